@@ -0,0 +1,36 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <string_view>
+#include <string>
+#include <iostream>
+
+namespace liquid
+{
+    void BenchmarkLiquid(double i_min_seconds, std::string_view i_filter);
+}
+
+/* usage: benchmark [--min-time <seconds>] [--filter <substring>]
+    Every benchmark writes a line of json on the standard output. */
+int main(int i_argc, char ** i_argv)
+{
+    double min_seconds = 0.2;
+    std::string_view filter;
+    for(int i = 1; i < i_argc; i++)
+    {
+        std::string_view const argument = i_argv[i];
+        if(argument == "--min-time" && i + 1 < i_argc)
+            min_seconds = std::stod(i_argv[++i]);
+        else if(argument == "--filter" && i + 1 < i_argc)
+            filter = i_argv[++i];
+        else
+        {
+            std::cerr << "usage: benchmark [--min-time <seconds>] [--filter <substring>]" << std::endl;
+            return 1;
+        }
+    }
+
+    liquid::BenchmarkLiquid(min_seconds, filter);
+}
@@ -0,0 +1,54 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#include "private_common.h"
+#include <chrono>
+#include <string_view>
+
+namespace liquid
+{
+    struct BenchmarkSettings
+    {
+        double m_min_seconds = 0.2; // minimum duration of a benchmark
+        std::string m_filter; // only benchmarks whose name contains this are run
+    };
+
+    const BenchmarkSettings & GetBenchmarkSettings();
+
+    bool IsBenchmarkEnabled(std::string_view i_name);
+
+    /* Writes a result as a line of json:
+        {"name": "kernel/add/same/4096", "iterations": 512, "seconds": 0.000012, "bytes_per_second": 4.1e+09} */
+    void ReportBenchmark(std::string_view i_name, size_t i_iterations,
+        double i_seconds_per_iteration, size_t i_processed_bytes);
+
+    /* Writes the estimated evaluation cost of a graph as a line of json:
+        {"name": "canonicalize/polynomial/32/cost", "unique_nodes": 40, "flops": 75, "peak_intermediate_bytes": 64} */
+    void ReportCost(std::string_view i_name, const Tensor & i_graph);
+
+    /* Runs a function repeatedly for at least the minimum duration, and reports
+        the average duration of a run. If i_processed_bytes is not zero, the 
+        throughput is reported too. */
+    template <typename FUNCTION>
+        void Benchmark(std::string_view i_name, size_t i_processed_bytes, const FUNCTION & i_function)
+    {
+        if(!IsBenchmarkEnabled(i_name))
+            return;
+
+        using Clock = std::chrono::steady_clock;
+        size_t iterations = 0;
+        std::chrono::duration<double> duration{};
+        auto const start = Clock::now();
+        do {
+            i_function();
+            iterations++;
+            duration = Clock::now() - start;
+        } while(duration.count() < GetBenchmarkSettings().m_min_seconds);
+
+        ReportBenchmark(i_name, iterations, duration.count() / static_cast<double>(iterations),
+            i_processed_bytes);
+    }
+}
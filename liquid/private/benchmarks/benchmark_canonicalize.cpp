@@ -0,0 +1,89 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "benchmarks/benchmark.h"
+#include <random>
+
+namespace liquid
+{
+    namespace
+    {
+        /* sum of monomials with random integer coefficients and exponents, like
+            3*x^2*y + 5*y*z^3 + ... Every operator invoked canonicalizes its operands. */
+        Tensor MakePolynomial(Span<const Tensor> i_variables, size_t i_monomial_count, uint32_t i_seed)
+        {
+            std::mt19937 generator(i_seed);
+            std::uniform_int_distribution<Integer> coefficient(-9, 9);
+            std::uniform_int_distribution<Integer> exponent(0, 3);
+
+            std::vector<Tensor> monomials;
+            monomials.reserve(i_monomial_count);
+            for(size_t i = 0; i < i_monomial_count; i++)
+            {
+                std::vector<Tensor> factors{ coefficient(generator) };
+                for(const Tensor & variable : i_variables)
+                    factors.push_back(Pow(variable, exponent(generator)));
+                monomials.push_back(Mul(factors));
+            }
+            return Add(monomials);
+        }
+
+        // c0 + c1*x + c2*x^2 + ... with Horner form c0 + x*(c1 + x*(c2 + ...))
+        Tensor MakeUnivariatePolynomial(const Tensor & i_variable, Integer i_degree)
+        {
+            std::vector<Tensor> monomials;
+            for(Integer exponent = 0; exponent <= i_degree; exponent++)
+                monomials.push_back((exponent + 2) * Pow(i_variable, exponent));
+            return Add(monomials);
+        }
+    }
+
+    void BenchmarkCanonicalize()
+    {
+        Tensor const variables[] = { Tensor("real x"), Tensor("real y"), Tensor("real z") };
+        for(size_t monomial_count : { 4, 32, 256 })
+        {
+            std::string const name = "canonicalize/polynomial/" + std::to_string(monomial_count);
+            Benchmark(name, 0, [&]{
+                return MakePolynomial(variables, monomial_count, 1); });
+            ReportCost(name + "/cost", MakePolynomial(variables, monomial_count, 1));
+        }
+
+        for(Integer degree : { 4, 16, 64 })
+        {
+            std::string const name = "canonicalize/univariate/" + std::to_string(degree);
+            Benchmark(name, 0, [&]{
+                return MakeUnivariatePolynomial(variables[0], degree); });
+            ReportCost(name + "/cost", MakeUnivariatePolynomial(variables[0], degree));
+        }
+
+        // products of powers of many bases, every base appearing twice
+        for(size_t factor_count : { 16, 128, 512 })
+        {
+            std::vector<Tensor> bases;
+            for(size_t i = 0; i < factor_count / 2; i++)
+                bases.push_back(Tensor("real b" + std::to_string(i)));
+
+            Benchmark("canonicalize/product/" + std::to_string(factor_count), 0, [&]{
+                std::vector<Tensor> factors;
+                factors.reserve(factor_count);
+                for(size_t i = 0; i < factor_count; i++)
+                    factors.push_back(Pow(bases[i % bases.size()], Tensor(Integer(i % 5) + 2)));
+                return Mul(factors);
+            });
+        }
+
+        // expanding a product of binomials
+        for(int factor_count : { 2, 4, 6 })
+        {
+            Benchmark("canonicalize/binomials/" + std::to_string(factor_count), 0, [&]{
+                Tensor result = 1;
+                for(int i = 0; i < factor_count; i++)
+                    result = result * (variables[i % 3] + i);
+                return result;
+            });
+        }
+    }
+}
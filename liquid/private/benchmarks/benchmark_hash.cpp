@@ -0,0 +1,60 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "benchmarks/benchmark.h"
+#include "hash.h"
+#include "expression.h"
+#include <numeric>
+
+namespace liquid
+{
+    void BenchmarkHash()
+    {
+        for(size_t size : { 64, 4096, 1024 * 1024 })
+        {
+            std::vector<unsigned char> bytes(size);
+            std::iota(bytes.begin(), bytes.end(), static_cast<unsigned char>(0));
+
+            // the first byte changes every time, so that the hash can't be hoisted out of the loop
+            Benchmark("hash/bytes/" + std::to_string(size), size, [&]{
+                bytes[0] = static_cast<unsigned char>(Hash(Span<const unsigned char>(bytes)).GetValue()); });
+        }
+    }
+
+    namespace
+    {
+        /* a graph with depth i_depth in which every node refers twice to the
+            previous one: as a tree it would have 2^i_depth nodes */
+        Tensor MakeDeepDag(const Tensor & i_leaf, size_t i_depth)
+        {
+            Tensor result = i_leaf;
+            for(size_t i = 0; i < i_depth; i++)
+                result = Sin(result) + Exp(result);
+            return result;
+        }
+    }
+
+    void BenchmarkAreIdentical()
+    {
+        Tensor const leaf("real x");
+        for(size_t depth : { 8, 64, 512 })
+        {
+            // two distinct but identical graphs
+            Tensor const first = MakeDeepDag(leaf, depth);
+            Tensor const second = MakeDeepDag(leaf, depth);
+
+            bool result = true;
+            Benchmark("are_identical/deep_dag/" + std::to_string(depth), 0, [&]{
+                result = result && AreIdentical(first, second); });
+            // without the cache every query compares all the nodes once
+            Benchmark("are_identical/deep_dag_cold/" + std::to_string(depth), 0, [&]{
+                ClearIdentityCache();
+                result = result && AreIdentical(first, second); });
+
+            if(!result)
+                Panic("BenchmarkAreIdentical - the graphs are not identical");
+        }
+    }
+}
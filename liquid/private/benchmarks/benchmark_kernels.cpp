@@ -0,0 +1,132 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "benchmarks/benchmark.h"
+#include "expression.h"
+#include "tensor_value.h"
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+namespace liquid
+{
+    namespace
+    {
+        Tensor MakeRandomConstant(const FixedShape & i_shape, uint32_t i_seed)
+        {
+            std::mt19937 generator(i_seed);
+            std::uniform_real_distribution<Real> distribution(0.5, 1.5);
+            SharedArray<Real> scalars(NumericCast<size_t>(i_shape.GetLinearSize()));
+            for(Real & scalar : scalars)
+                scalar = distribution(generator);
+            return MakeConstant(TensorValue(std::move(scalars), i_shape));
+        }
+
+        size_t GetByteSize(const Tensor & i_tensor)
+        {
+            return GetConstantValue(i_tensor).GetShape().GetLinearSize() * 
+                (i_tensor.GetScalarType() == ScalarType::Bool ? sizeof(Bool) : sizeof(Real));
+        }
+
+        // evaluates with constant propagation, reporting the bytes read and written
+        template <typename FUNCTION>
+            void BenchmarkKernel(const std::string & i_name, Span<const Tensor> i_operands,
+                const FUNCTION & i_function)
+        {
+            size_t bytes = GetByteSize(i_function());
+            for(const Tensor & operand : i_operands)
+                bytes += GetByteSize(operand);
+            Benchmark(i_name, bytes, i_function);
+        }
+    }
+
+    void BenchmarkKernels()
+    {
+        for(Integer side : { 8, 64, 512 })
+        {
+            Tensor const matrix = MakeRandomConstant({ side, side }, 1);
+            std::string const size = std::to_string(side * side);
+
+            // unary kernels
+            BenchmarkKernel("kernel/sin/" + size, { matrix }, [&]{ return Sin(matrix); });
+            BenchmarkKernel("kernel/exp/" + size, { matrix }, [&]{ return Exp(matrix); });
+            BenchmarkKernel("kernel/log/" + size, { matrix }, [&]{ return Log(matrix); });
+
+            // the same kernels with polynomial approximations
+            auto const fast = [](auto i_function) { return [=]{ PrecisionContext precision(Precision::Fast); return i_function(); }; };
+            BenchmarkKernel("kernel/sin/fast/" + size, { matrix }, fast([&]{ return Sin(matrix); }));
+            BenchmarkKernel("kernel/exp/fast/" + size, { matrix }, fast([&]{ return Exp(matrix); }));
+            BenchmarkKernel("kernel/log/fast/" + size, { matrix }, fast([&]{ return Log(matrix); }));
+
+            // binary kernels, for any broadcast pattern
+            struct BroadcastPattern { const char * m_name; Tensor m_operand; };
+            BroadcastPattern const patterns[] = {
+                { "same", MakeRandomConstant({ side, side }, 2) },
+                { "row", MakeRandomConstant({ side }, 3) },
+                { "scalar", MakeRandomConstant({}, 4) } };
+            for(const BroadcastPattern & pattern : patterns)
+            {
+                std::string const suffix = std::string("/") + pattern.m_name + "/" + size;
+                const Tensor & other = pattern.m_operand;
+                Tensor const operands[] = { matrix, other };
+                BenchmarkKernel("kernel/add" + suffix, operands, [&]{ return matrix + other; });
+                BenchmarkKernel("kernel/mul" + suffix, operands, [&]{ return matrix * other; });
+                BenchmarkKernel("kernel/pow" + suffix, operands, [&]{ return Pow(matrix, other); });
+                BenchmarkKernel("kernel/pow/fast" + suffix, operands, fast([&]{ return Pow(matrix, other); }));
+                BenchmarkKernel("kernel/less" + suffix, operands, [&]{ return matrix < other; });
+                BenchmarkKernel("kernel/equal" + suffix, operands, [&]{ return matrix == other; });
+            }
+
+            // uniform exponents that don't need std::pow
+            BenchmarkKernel("kernel/pow/square/" + size, { matrix }, [&]{ return Pow(matrix, 2); });
+            BenchmarkKernel("kernel/pow/sqrt/" + size, { matrix }, [&]{ return Pow(matrix, 0.5); });
+            BenchmarkKernel("kernel/pow/cube/" + size, { matrix }, [&]{ return Pow(matrix, 3); });
+            BenchmarkKernel("kernel/pow/cube/fast/" + size, { matrix }, fast([&]{ return Pow(matrix, 3); }));
+
+            Tensor const square = patterns[0].m_operand;
+            BenchmarkKernel("kernel/matmul/" + size, { matrix, square }, [&]{ return MatMul(matrix, square); });
+
+            // a chain contracted right to left, as the planner prefers the matrix-vector product
+            Tensor const vector = MakeRandomConstant({ side }, 5);
+            Tensor const chain[] = { matrix, square, vector };
+            BenchmarkKernel("kernel/einsum/chain/" + size, chain, [&]{ return Einsum("ij,jk,k->i", chain); });
+
+            // stack along the outer and the inner axis
+            Tensor const layers[] = { matrix, patterns[0].m_operand, matrix, patterns[0].m_operand };
+            BenchmarkKernel("kernel/stack/axis0/" + size, layers, [&]{ return Stack(layers); });
+            BenchmarkKernel("kernel/stack/axis2/" + size, layers, [&]{ return Stack(layers, 2); });
+
+            // views share the storage, the kernels read the transposed view with its strides
+            Tensor const transposed = Transpose(matrix);
+            BenchmarkKernel("kernel/transpose/" + size, { matrix }, [&]{ return Transpose(matrix); });
+            BenchmarkKernel("kernel/add/transposed/" + size, { transposed, square }, [&]{ return transposed + square; });
+
+            // gathering shuffled rows copies blocks, gathering a contiguous run of rows is a view
+            std::vector<Integer> shuffled(NumericCast<size_t>(side)), run(NumericCast<size_t>(side / 2));
+            std::iota(shuffled.begin(), shuffled.end(), 0);
+            std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(7));
+            std::iota(run.begin(), run.end(), side / 4);
+            Tensor const shuffled_rows = MakeConstant(TensorValue(SharedArray<Integer>(shuffled), FixedShape({ side })));
+            Tensor const run_rows = MakeConstant(TensorValue(SharedArray<Integer>(run), FixedShape({ side / 2 })));
+            BenchmarkKernel("kernel/gather/shuffled/" + size, { matrix, shuffled_rows }, [&]{ return Gather(matrix, shuffled_rows); });
+            BenchmarkKernel("kernel/gather/run/" + size, { matrix, run_rows }, [&]{ return Gather(matrix, run_rows); });
+
+            // reductions of contiguous rows, and of columns that are moved last
+            BenchmarkKernel("kernel/sum/rows/" + size, { matrix }, [&]{ return Sum(matrix, {1}); });
+            BenchmarkKernel("kernel/sum/columns/" + size, { matrix }, [&]{ return Sum(matrix, {0}); });
+
+            // fused softmax along the contiguous axis, compared to the composition of exp and sum
+            BenchmarkKernel("kernel/softmax/rows/" + size, { matrix }, [&]{ return Softmax(matrix); });
+            BenchmarkKernel("kernel/softmax/columns/" + size, { matrix }, [&]{ return Softmax(matrix, 0); });
+            BenchmarkKernel("kernel/softmax/unfused/" + size, { matrix }, [&]{
+                return Exp(matrix) / Reshape(Sum(Exp(matrix), {1}), { side, 1 }); });
+            BenchmarkKernel("kernel/log_sum_exp/rows/" + size, { matrix }, [&]{ return LogSumExp(matrix); });
+        }
+
+        // large enough to be reduced in parallel
+        Tensor const large = MakeRandomConstant({ 2048, 2048 }, 6);
+        BenchmarkKernel("kernel/sum/all/4194304", { large }, [&]{ return Sum(large); });
+    }
+}
@@ -0,0 +1,49 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "benchmarks/benchmark.h"
+#include "miu6/lexer.h"
+#include "miu6/parser.h"
+
+namespace liquid
+{
+    namespace
+    {
+        // machine-generated-like source: many short definitions
+        std::string MakeMiu6Source(size_t i_min_length)
+        {
+            std::string source;
+            source.reserve(i_min_length + 256);
+            for(size_t i = 0; source.length() < i_min_length; i++)
+            {
+                std::string const index = std::to_string(i);
+                source += "(real[3] position" + index + " * 2.5 + (int counter" + index +
+                    " - 4) ^ 2 >= [1 2 3]) or not (if real x" + index +
+                    " > 0 then true else false),\n";
+            }
+            return source;
+        }
+    }
+
+    void BenchmarkMiu6()
+    {
+        std::string const large_source = MakeMiu6Source(4 * 1024 * 1024);
+        Benchmark("miu6/lexer", large_source.length(), [&]{
+            miu6::Lexer lexer(large_source);
+            while(!lexer.IsSourceOver())
+            {
+                if(lexer.IsCurrentToken(miu6::SymbolId::Unrecognized))
+                    Panic(lexer, " Unrecognized token");
+                lexer.Advance();
+            }
+        });
+
+        std::string const source = MakeMiu6Source(64 * 1024);
+        Benchmark("miu6/parser/sequential", source.length(), [&]{
+            return miu6::ParseExpressions(source, Scope::Root(), false); });
+        Benchmark("miu6/parser/parallel", source.length(), [&]{
+            return miu6::ParseExpressions(source, Scope::Root(), true); });
+    }
+}
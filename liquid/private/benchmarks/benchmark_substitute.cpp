@@ -0,0 +1,56 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "benchmarks/benchmark.h"
+#include "expression.h"
+#include "substitute_by_predicate.h"
+#include "incremental_evaluator.h"
+#include <unordered_map>
+
+namespace liquid
+{
+    void BenchmarkSubstitute()
+    {
+        // binding all the variables of a graph to constants
+        for(size_t variable_count : { 16, 256, 2048 })
+        {
+            std::vector<Tensor> variables, terms;
+            std::vector<Rule> rules;
+            std::unordered_map<std::string, Tensor> values;
+            for(size_t i = 0; i < variable_count; i++)
+            {
+                std::string const name = "v" + std::to_string(i);
+                variables.push_back(Tensor("real " + name));
+                rules.push_back(Rule{ variables.back(), Real(i) / 8 });
+                values.emplace(name, Tensor(Real(i) / 8));
+            }
+            for(size_t i = 0; i < variable_count; i++)
+                terms.push_back(Sin(variables[i]) * variables[(i + 1) % variable_count]);
+            Tensor const graph = Add(terms);
+
+            Benchmark("substitute/bind/" + std::to_string(variable_count), 0, [&]{
+                return Substitute(graph, rules); });
+
+            Benchmark("substitute_by_predicate/bind/" + std::to_string(variable_count), 0, [&]{
+                return SubstituteByPredicate(graph, [&](const Tensor & i_candidate){
+                    auto const it = values.find(i_candidate.GetExpression()->GetName());
+                    return it != values.end() && IsVariable(i_candidate) ? it->second : i_candidate;
+                });
+            });
+
+            // changing one variable recomputes only its cone
+            IncrementalEvaluator evaluator({ graph });
+            for(const Rule & rule : rules)
+                evaluator.SetValue(rule.m_what, GetConstantValue(rule.m_with));
+            evaluator.Update();
+            size_t changed_variable = 0;
+            Benchmark("incremental/update_one/" + std::to_string(variable_count), 0, [&]{
+                changed_variable = (changed_variable + 1) % variable_count;
+                evaluator.SetValue(variables[changed_variable], Real(changed_variable));
+                return evaluator.Update();
+            });
+        }
+    }
+}
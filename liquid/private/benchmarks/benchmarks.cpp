@@ -0,0 +1,66 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "benchmarks/benchmark.h"
+#include <iostream>
+
+namespace liquid
+{
+    void BenchmarkKernels();
+    void BenchmarkCanonicalize();
+    void BenchmarkMiu6();
+    void BenchmarkHash();
+    void BenchmarkAreIdentical();
+    void BenchmarkSubstitute();
+
+    namespace
+    {
+        BenchmarkSettings g_benchmark_settings;
+    }
+
+    const BenchmarkSettings & GetBenchmarkSettings()
+    {
+        return g_benchmark_settings;
+    }
+
+    bool IsBenchmarkEnabled(std::string_view i_name)
+    {
+        return i_name.find(g_benchmark_settings.m_filter) != std::string_view::npos;
+    }
+
+    void ReportBenchmark(std::string_view i_name, size_t i_iterations,
+        double i_seconds_per_iteration, size_t i_processed_bytes)
+    {
+        std::cout << "{\"name\": \"" << i_name << "\", \"iterations\": " << i_iterations
+            << ", \"seconds\": " << i_seconds_per_iteration;
+        if(i_processed_bytes != 0)
+            std::cout << ", \"bytes_per_second\": " << i_processed_bytes / i_seconds_per_iteration;
+        std::cout << "}" << std::endl;
+    }
+
+    void ReportCost(std::string_view i_name, const Tensor & i_graph)
+    {
+        if(!IsBenchmarkEnabled(i_name))
+            return;
+
+        GraphStatistics const statistics = GetGraphStatistics({ i_graph });
+        std::cout << "{\"name\": \"" << i_name << "\", \"unique_nodes\": " << statistics.m_unique_nodes
+            << ", \"flops\": " << statistics.m_flops
+            << ", \"peak_intermediate_bytes\": " << statistics.m_peak_intermediate_bytes << "}" << std::endl;
+    }
+
+    void BenchmarkLiquid(double i_min_seconds, std::string_view i_filter)
+    {
+        g_benchmark_settings.m_min_seconds = i_min_seconds;
+        g_benchmark_settings.m_filter = i_filter;
+
+        BenchmarkKernels();
+        BenchmarkCanonicalize();
+        BenchmarkMiu6();
+        BenchmarkHash();
+        BenchmarkAreIdentical();
+        BenchmarkSubstitute();
+    }
+}
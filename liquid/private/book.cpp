@@ -7,28 +7,45 @@
 #include "book.h"
 #include "expression.h"
 #include "operator.h"
+#include <algorithm>
 
 namespace liquid
 {
     extern const Operator & GetOperatorAdd();
+    extern const Operator & GetOperatorAll();
     extern const Operator & GetOperatorAnd();
+    extern const Operator & GetOperatorAny();
+    extern const Operator & GetOperatorBroadcastTo();
     extern const Operator & GetOperatorCast();
     extern const Operator & GetOperatorConstant();
     extern const Operator & GetOperatorCos();
+    extern const Operator & GetOperatorEinsum();
     extern const Operator & GetOperatorEqual();
     extern const Operator & GetOperatorExp();
+    extern const Operator & GetOperatorGather();
     extern const Operator & GetOperatorIf();
     extern const Operator & GetOperatorIs();
     extern const Operator & GetOperatorLess();
     extern const Operator & GetOperatorLog();
+    extern const Operator & GetOperatorLogSumExp();
+    extern const Operator & GetOperatorMatMul();
+    extern const Operator & GetOperatorMax();
+    extern const Operator & GetOperatorMin();
     extern const Operator & GetOperatorMul();
     extern const Operator & GetOperatorNot();
     extern const Operator & GetOperatorOr();
     extern const Operator & GetOperatorPow();
+    extern const Operator & GetOperatorProduct();
     extern const Operator & GetOperatorRank();
+    extern const Operator & GetOperatorReshape();
+    extern const Operator & GetOperatorScatterAdd();
     extern const Operator & GetOperatorShape();
     extern const Operator & GetOperatorSin();
+    extern const Operator & GetOperatorSlice();
+    extern const Operator & GetOperatorSoftmax();
     extern const Operator & GetOperatorStack();
+    extern const Operator & GetOperatorSum();
+    extern const Operator & GetOperatorTranspose();
     extern const Operator & GetOperatorVariable();
 
     void Book::AddOperator(const Operator & i_operator)
@@ -56,9 +73,21 @@ namespace liquid
         Panic("Book - operator ", i_name, " mot found");
     }
 
+    std::vector<const Operator *> Book::GetOperators() const
+    {
+        std::vector<const Operator *> operators;
+        operators.reserve(m_operators.size());
+        for(auto const & entry : m_operators)
+            operators.push_back(entry.second);
+        std::sort(operators.begin(), operators.end(), [](const Operator * i_left, const Operator * i_right)
+            { return i_left->GetName() < i_right->GetName(); });
+        return operators;
+    }
+
     void Book::AddParagraph(std::string_view i_topic, Span<Element const> i_elements)
     {
         Paragraphs topic {{i_elements.begin(), i_elements.end()}};
+        std::lock_guard<std::mutex> lock(m_mutex);
         bool const inserted = m_paragraphs.insert(std::make_pair(i_topic, std::move(topic))).second;
         if(!inserted)
             Panic("Book - paragraph ", i_topic, " already present");
@@ -66,6 +95,7 @@ namespace liquid
 
     std::vector<std::string> Book::GetAllTopics() const
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         return Transform(m_paragraphs, [](auto i_pair){ return i_pair.first; });
     }
 
@@ -75,6 +105,7 @@ namespace liquid
         Proposition proposition{ i_bool_expression, 
             i_cpp_source_code != nullptr ? i_cpp_source_code : "", 
             i_miu6_source_code != nullptr ? i_miu6_source_code : "" };
+        std::lock_guard<std::mutex> lock(m_mutex);
         m_propositions.insert(std::make_pair(i_topic, std::move(proposition)));
     }
 
@@ -84,30 +115,47 @@ namespace liquid
         PanicProposition proposition{ i_panic_message,
             i_cpp_source_code != nullptr ? i_cpp_source_code : "", 
             i_miu6_source_code != nullptr ? i_miu6_source_code : "" };
+        std::lock_guard<std::mutex> lock(m_mutex);
         m_panic_propositions.insert(std::make_pair(i_topic, std::move(proposition)));
     }
 
     Book::Book()
     {
         AddOperator(GetOperatorAdd());
+        AddOperator(GetOperatorAll());
         AddOperator(GetOperatorAnd());
+        AddOperator(GetOperatorAny());
+        AddOperator(GetOperatorBroadcastTo());
         AddOperator(GetOperatorCast());
         AddOperator(GetOperatorConstant());
         AddOperator(GetOperatorCos());
+        AddOperator(GetOperatorEinsum());
         AddOperator(GetOperatorEqual());
         AddOperator(GetOperatorExp());
+        AddOperator(GetOperatorGather());
         AddOperator(GetOperatorIf());
         AddOperator(GetOperatorIs());
         AddOperator(GetOperatorLess());
         AddOperator(GetOperatorLog());
+        AddOperator(GetOperatorLogSumExp());
+        AddOperator(GetOperatorMatMul());
+        AddOperator(GetOperatorMax());
+        AddOperator(GetOperatorMin());
         AddOperator(GetOperatorMul());
         AddOperator(GetOperatorNot());
         AddOperator(GetOperatorOr());
         AddOperator(GetOperatorPow());
+        AddOperator(GetOperatorProduct());
         AddOperator(GetOperatorRank());
+        AddOperator(GetOperatorReshape());
+        AddOperator(GetOperatorScatterAdd());
         AddOperator(GetOperatorShape());
         AddOperator(GetOperatorSin());
+        AddOperator(GetOperatorSlice());
+        AddOperator(GetOperatorSoftmax());
         AddOperator(GetOperatorStack());
+        AddOperator(GetOperatorSum());
+        AddOperator(GetOperatorTranspose());
         AddOperator(GetOperatorVariable());
     }
 
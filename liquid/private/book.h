@@ -10,9 +10,13 @@
 #include "liquid/tensor.h"
 #include <unordered_map>
 #include <variant>
+#include <mutex>
 
 namespace liquid
 {
+    /* The book is safe for concurrent use: operators are registered by the
+        constructor and never modified, so they are accessed without locks, while
+        paragraphs and propositions are guarded by a mutex. */
     class Book
     {
     public:
@@ -62,6 +66,8 @@ namespace liquid
 
         const Operator * TryGetOperator(std::string_view i_name) const;
 
+        std::vector<const Operator *> GetOperators() const;
+
         std::vector<std::string> GetAllTopics() const;
 
     private:
@@ -72,6 +78,7 @@ namespace liquid
 
     private:
         std::unordered_map<std::string, const Operator *> m_operators;
+        mutable std::mutex m_mutex; // guards paragraphs and propositions
         std::unordered_map<std::string, const Paragraphs> m_paragraphs;
         std::unordered_multimap<std::string, const Proposition> m_propositions;
         std::unordered_multimap<std::string, const PanicProposition> m_panic_propositions;
@@ -6,6 +6,11 @@
 
 #include "expression.h"
 #include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <algorithm>
+#include <mutex>
+#include <cstdint>
 
 namespace liquid
 {
@@ -27,6 +32,20 @@ namespace liquid
         m_hash = Hash(m_name, m_type, m_operands, m_operator, m_operands);
         if(m_attachment.has_value())
             m_operator.HashAttachment(m_hash, m_attachment);
+        m_cost = m_operator.GetCost(m_attachment, m_type, m_operands);
+    }
+
+    int64_t Expression::GetComputationalCostExtimate() const
+    {
+        // many threads may compute the estimate at the same time, with the same result
+        int64_t estimate = m_computational_cost_estimate.load(std::memory_order_relaxed);
+        if(estimate < 0)
+        {
+            const Expression * const root = this;
+            estimate = GetGraphStatistics(Span(&root, 1)).m_flops;
+            m_computational_cost_estimate.store(estimate, std::memory_order_relaxed);
+        }
+        return estimate;
     }
 
     bool AlwaysEqual(const Tensor & i_tensor, const TensorValue& i_value)
@@ -34,6 +53,24 @@ namespace liquid
         return IsConstant(i_tensor) && GetConstantValue(i_tensor) == i_value;
     }
 
+    bool IsUniformConstant(const Tensor & i_tensor, Bool i_value)
+    {
+        if(!IsConstant(i_tensor) || i_tensor.GetScalarType() != ScalarType::Bool)
+            return false;
+
+        Span<const Bool> const elements = GetConstantStorage<Bool>(i_tensor);
+        return std::all_of(elements.begin(), elements.end(),
+            [i_value](Bool i_element){ return i_element == i_value; });
+    }
+
+    Tensor LiteralOfType(const Tensor & i_literal, ScalarType i_scalar_type)
+    {
+        if(i_scalar_type == ScalarType::Real32 || i_scalar_type == ScalarType::Integer32 ||
+                i_scalar_type == ScalarType::Integer8)
+            return Cast(i_scalar_type, i_literal);
+        return i_literal;
+    }
+
     TensorType DeduceType(Span<const Tensor> i_operands)
     {
         return DeduceType(Transform(i_operands, 
@@ -63,15 +100,121 @@ namespace liquid
                 i_left.GetOperator().AttachmentsEqual(i_left.GetAttachment(), i_right.GetAttachment());
         }
 
-        using IdenticalExprMap = std::unordered_multimap<Hash::Word, std::pair<
-            const Expression *, const Expression *>>;
+        // unordered pair of expressions: the one with the lower address is the first
+        struct ExpressionPair
+        {
+            const Expression * m_first = nullptr;
+            const Expression * m_second = nullptr;
+
+            ExpressionPair() = default;
+
+            ExpressionPair(const Expression & i_left, const Expression & i_right)
+                : m_first(std::min(&i_left, &i_right, std::less<const Expression *>())),
+                  m_second(std::max(&i_left, &i_right, std::less<const Expression *>())) { }
+
+            bool operator == (const ExpressionPair & i_other) const
+                { return m_first == i_other.m_first && m_second == i_other.m_second; }
+
+            /* expressions are aligned, so the low bits of their addresses are always zero:
+                the bits are mixed with the finalizer of splitmix64 */
+            size_t GetHash() const
+            {
+                uint64_t value = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(m_first)) * 31 +
+                    static_cast<uint64_t>(reinterpret_cast<uintptr_t>(m_second));
+                value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+                value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+                return static_cast<size_t>(value ^ (value >> 31));
+            }
+        };
+
+        struct ExpressionPairHasher
+        {
+            size_t operator () (const ExpressionPair & i_pair) const { return i_pair.GetHash(); }
+        };
+
+        using IdenticalExprSet = std::unordered_set<ExpressionPair, ExpressionPairHasher>;
+
+        /* Global cache of pairs of distinct expressions known to be identical, so that
+            repeated queries on the same pair are O(1). It's a direct-mapped table, so its
+            size is bounded: a pair evicts the previous pair mapped to the same slot.
+            Slots keep weak references to the expressions, so that a pair is not found
+            anymore when one of them is destroyed (and its address may be reused). The
+            memory of the destroyed expressions is released when the slot is overwritten.
+            The slots are guarded by a set of mutexes, so that threads canonicalizing
+            unrelated expressions rarely wait for each other. The mutex of a pair is
+            chosen by bits of the hash other than the ones that choose the slot. */
+        class IdentityCache
+        {
+        public:
+
+            static IdentityCache & Get()
+            {
+                static IdentityCache s_instance;
+                return s_instance;
+            }
+
+            bool Contains(const ExpressionPair & i_pair) const
+            {
+                size_t const hash = i_pair.GetHash();
+                std::lock_guard<std::mutex> lock(m_locks[GetLockIndex(hash)]);
+                const Slot & slot = m_slots[GetSlotIndex(hash)];
+                return slot.m_pair == i_pair &&
+                    !slot.m_first.expired() && !slot.m_second.expired();
+            }
+
+            void Add(const ExpressionPair & i_pair)
+            {
+                std::weak_ptr<const Expression> first = i_pair.m_first->weak_from_this();
+                std::weak_ptr<const Expression> second = i_pair.m_second->weak_from_this();
+
+                // expressions not owned by a shared_ptr can't be validated
+                if(first.expired() || second.expired())
+                    return;
+
+                size_t const hash = i_pair.GetHash();
+                std::lock_guard<std::mutex> lock(m_locks[GetLockIndex(hash)]);
+                Slot & slot = m_slots[GetSlotIndex(hash)];
+                slot.m_pair = i_pair;
+                slot.m_first = std::move(first);
+                slot.m_second = std::move(second);
+            }
+
+            void Clear()
+            {
+                // all the mutexes are locked, always in the same order
+                std::vector<std::unique_lock<std::mutex>> locks;
+                locks.reserve(s_lock_count);
+                for(std::mutex & mutex : m_locks)
+                    locks.emplace_back(mutex);
+                for(Slot & slot : m_slots)
+                    slot = Slot{};
+            }
+
+        private:
+            IdentityCache() = default;
+
+            static size_t GetSlotIndex(size_t i_hash) { return i_hash % s_slot_count; }
+
+            static size_t GetLockIndex(size_t i_hash) { return (i_hash / s_slot_count) % s_lock_count; }
+
+            struct Slot
+            {
+                ExpressionPair m_pair;
+                std::weak_ptr<const Expression> m_first, m_second;
+            };
+
+            static constexpr size_t s_slot_count = 4096;
+            static constexpr size_t s_lock_count = 64;
+            mutable std::mutex m_locks[s_lock_count];
+            std::vector<Slot> m_slots = std::vector<Slot>(s_slot_count);
+        };
 
         /* this function is resursive on the operands
-          i_map contains all pairs of identical expressions found so far
-          we combine the hashes of left and right by xor, which is commutative
-          the combined hash is used as key in the map */
+          i_set contains all pairs of identical expressions found so far by this
+          comparison, so that shared nodes are compared once even if the global
+          cache evicts them */
         bool AreIdenticalImpl(const Expression & i_left, const Expression & i_right, 
-            IdenticalExprMap & i_map)
+            IdenticalExprSet & i_set)
         {
             if(&i_left == &i_right)
                 return true;
@@ -79,37 +222,31 @@ namespace liquid
             if(!AreIdenticalImplShallow(i_left, i_right))
                 return false;
 
-            auto const combined_hash = 
-                i_left.GetHash().GetValue() ^
-                i_left.GetHash().GetValue();
-
-            auto const range = i_map.equal_range(combined_hash);
-            for(auto it = range.first; it != range.second; it++)
-            {
-                const Expression * const expr1 = it->second.first;
-                const Expression * const expr2 = it->second.second;
-                if(expr1 == &i_left && expr2 == &i_right ||
-                    expr1 == &i_right && expr2 == &i_left)
-                {
-                    return true;
-                }
-            }
+            ExpressionPair const pair(i_left, i_right);
+            if(i_set.find(pair) != i_set.end() || IdentityCache::Get().Contains(pair))
+                return true;
 
             const size_t operand_count = i_left.GetOperands().size();
             for(size_t operand_index = 0; operand_index < operand_count; operand_index++)
             {
                 const Expression & left_op = *i_left.GetOperands()[operand_index].GetExpression();
                 const Expression & right_op = *i_right.GetOperands()[operand_index].GetExpression();
-                if(!AreIdenticalImpl(left_op, right_op, i_map))
+                if(!AreIdenticalImpl(left_op, right_op, i_set))
                     return false;
             }
 
-            i_map.insert(std::make_pair(combined_hash, std::make_pair(&i_left, &i_right)));
+            i_set.insert(pair);
+            IdentityCache::Get().Add(pair);
 
             return true;
         }
     }
 
+    void ClearIdentityCache()
+    {
+        detail::IdentityCache::Get().Clear();
+    }
+
     bool AreIdentical(const Tensor & i_left, const Tensor & i_right)
     {
         return AreIdentical(*i_left.GetExpression(), *i_right.GetExpression());
@@ -118,7 +255,7 @@ namespace liquid
     bool AreIdentical(const Expression & i_left, const Expression & i_right)
     {
         using namespace detail;
-        IdenticalExprMap map;
-        return AreIdenticalImpl(i_left, i_right, map);
+        IdenticalExprSet set;
+        return AreIdenticalImpl(i_left, i_right, set);
     }
 }
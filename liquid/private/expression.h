@@ -8,6 +8,8 @@
 
 #include <variant>
 #include <any>
+#include <memory>
+#include <atomic>
 #include "private_common.h"
 #include "liquid/span.h"
 #include "shared_array.h"
@@ -17,7 +19,9 @@
 
 namespace liquid
 {
-    class Expression
+    /* Expressions are always owned by shared pointers, so they can provide weak
+        references to themselves (see AreIdentical). */
+    class Expression : public std::enable_shared_from_this<Expression>
     {
     public:
 
@@ -40,8 +44,12 @@ namespace liquid
         const std::any & GetAttachment() const { return m_attachment; }
         const Hash & GetHash() const { return m_hash; }
 
-        // this is a stub - to be implemented
-        int64_t GetComputationalCostExtimate() const { return 0; }
+        // cost of this node alone, see Operator::CostFunction
+        const Operator::Cost & GetCost() const { return m_cost; }
+
+        /* flops of the whole graph of this expression, shared nodes counted once. The
+            graph is visited only the first time, then the estimate is cached. */
+        int64_t GetComputationalCostExtimate() const;
 
         bool OperatorIs(const Operator & i_op) const { return &m_operator == &i_op; }
 
@@ -54,6 +62,8 @@ namespace liquid
         std::vector<Tensor> m_operands;
         std::any m_attachment;
         Hash m_hash;
+        Operator::Cost m_cost;
+        mutable std::atomic<int64_t> m_computational_cost_estimate = -1;
     };
 
     
@@ -73,12 +83,25 @@ namespace liquid
 
     bool AlwaysEqual(const Tensor & i_tensor, const TensorValue & i_value);
 
+    // like Always and Never, but without allocating a value to compare with
+    bool IsUniformConstant(const Tensor & i_tensor, Bool i_value);
+
+    /* Canonicalizations insert integer and real literals, like the -1 of -a. If i_scalar_type
+        is a narrow type (real32, int32 or int8) the literal is converted to it, so that it
+        doesn't promote the expression it's combined with. */
+    Tensor LiteralOfType(const Tensor & i_literal, ScalarType i_scalar_type);
+
     bool AreIdentical(const Tensor & i_left, const Tensor & i_right);
 
     bool AreIdentical(const Expression & i_left, const Expression & i_right);
 
+    // AreIdentical caches the pairs of identical expressions, this discards them
+    void ClearIdentityCache();
+
     TensorType DeduceType(Span<const Tensor> i_operands);
 
+    GraphStatistics GetGraphStatistics(Span<const Expression * const> i_roots);
+
     Tensor Is(const Tensor & i_tensor, const TensorType & i_type);
 
     template <auto VALUE>
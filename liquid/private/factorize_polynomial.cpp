@@ -11,6 +11,7 @@
 #include "indices.h"
 #include <algorithm>
 #include <variant>
+#include <unordered_map>
 
 namespace liquid
 {
@@ -48,14 +49,15 @@ namespace liquid
                     for(const Tensor & addend : exponent.GetExpression()->GetOperands())
                         EnumFactors(Pow(base, addend), i_predicate);
                 }
-                else if(IsConstant(exponent))
+                else if(IsConstant(exponent) && (exponent.GetScalarType() == ScalarType::Real ||
+                    exponent.GetScalarType() == ScalarType::Integer))
                 {
                     // constant exponent, well formed factor
                     i_predicate(base, GetConstantValue(exponent));
                 }
                 else
                 {
-                    // the exponent is a random expression
+                    // the exponent is a random expression, or a constant of a narrow type
                     i_predicate(i_source, MakeConstantValue<1>());
                 }
             }
@@ -68,8 +70,10 @@ namespace liquid
 
         struct Factor
         {
+            using Exponent = std::variant<std::monostate, SharedArray<Real>, SharedArray<Integer>>;
+
             Tensor m_base;
-            std::variant<std::monostate, SharedArray<Real>, SharedArray<Integer>> m_exponent;
+            Exponent m_exponent;
             FixedShape m_exponent_shape;
             std::vector<size_t> m_term_indices;
 
@@ -105,81 +109,85 @@ namespace liquid
                     Panic("GetAndResetExponent - unexpected exponent type");
             }
 
-            /* converts m_exponent from integer to real if i_source_scalar_type is real 
-                and m_exponent is integer */
-            void ExponentNumericPromotion(ScalarType i_source_scalar_type)
+            /* returns m_exponent converted from integer to real if i_source_scalar_type is real
+                and m_exponent is integer, otherwise m_exponent */
+            Exponent GetPromotedExponent(ScalarType i_source_scalar_type) const
             {
                 auto const old_scalar_type = GetExponentType();
 
                 ScalarType const new_scalar_type = DeduceScalarType({old_scalar_type, i_source_scalar_type});
-                if(new_scalar_type != old_scalar_type)
-                {
-                    // we expect only Integer to Real promotion
-                    if(new_scalar_type != ScalarType::Real || old_scalar_type != ScalarType::Integer)
-                        Panic("ExponentNumericPromotion - unexpected promotion from ",
-                            old_scalar_type, " to ", new_scalar_type);
-  
-                      const SharedArray<Integer> & integers = std::get<SharedArray<Integer>>(m_exponent);
-                    SharedArray<Real> reals(integers.size());
-                    for(size_t i = 0; i < integers.size(); i++)
-                        reals[i] = NumericCast<Real>(integers[i]);
-
-                    m_exponent = std::move(reals);
-                }
+                if(new_scalar_type == old_scalar_type)
+                    return m_exponent;
+
+                // we expect only Integer to Real promotion
+                if(new_scalar_type != ScalarType::Real || old_scalar_type != ScalarType::Integer)
+                    Panic("GetPromotedExponent - unexpected promotion from ",
+                        old_scalar_type, " to ", new_scalar_type);
+
+                const SharedArray<Integer> & integers = std::get<SharedArray<Integer>>(m_exponent);
+                SharedArray<Real> reals(integers.size());
+                for(size_t i = 0; i < integers.size(); i++)
+                    reals[i] = NumericCast<Real>(integers[i]);
+                return reals;
             }
 
+            /* the merged exponent is the common power of the factor, that is for every
+                element the exponent closest to zero. Exponents with different signs (or
+                zero) can't be merged, and in this case the factor is left unchanged. */
             template <typename EXPONENT_TYPE, typename SOURCE_TYPE>
-                bool TryMergeExponentScalars(const TensorValue & i_source)
+                bool TryMergeExponentScalars(const Exponent & i_dest, const TensorValue & i_source)
             {
-                auto & exponent = std::get<SharedArray<EXPONENT_TYPE>>(m_exponent);
-                for (Indices indices(m_exponent_shape); indices; indices++)
-                {
-                    auto & dest = exponent[indices.GetLogicalLinearIndex()];
-                    auto const source = indices.At<SOURCE_TYPE>(i_source);
-
-                    bool const dest_positive = dest > EXPONENT_TYPE{};
-                    bool const source_positive = source > SOURCE_TYPE{};
+                TensorValue const exponent(SharedArray<EXPONENT_TYPE>(
+                    std::get<SharedArray<EXPONENT_TYPE>>(i_dest)), m_exponent_shape);
 
-                    if(dest_positive != source_positive)
-                        return false;
+                FixedShape const merged_shape = Broadcast({m_exponent_shape, i_source.GetShape()});
+                SharedArray<EXPONENT_TYPE> merged(static_cast<size_t>(merged_shape.GetLinearSize()));
+                for (Indices indices(merged_shape); indices; indices++)
+                {
+                    auto const dest = indices.At<EXPONENT_TYPE>(exponent);
+                    auto const source = NumericCast<EXPONENT_TYPE>(indices.At<SOURCE_TYPE>(i_source));
 
-                    if(dest_positive)
+                    if(dest > EXPONENT_TYPE{})
                     {
-                        if(dest < source)
-                            dest = NumericCast<EXPONENT_TYPE>(source);
+                        if(!(source > EXPONENT_TYPE{}))
+                            return false;
+                        indices[merged] = std::min(dest, source);
                     }
-                    else
+                    else if(dest < EXPONENT_TYPE{})
                     {
-                        if(dest > source)
-                            dest = NumericCast<EXPONENT_TYPE>(source);
+                        if(!(source < EXPONENT_TYPE{}))
+                            return false;
+                        indices[merged] = std::max(dest, source);
                     }
+                    else
+                        return false;
                 }
 
+                m_exponent = std::move(merged);
+                m_exponent_shape = merged_shape;
                 return true;
             }
 
+            // the exponent is promoted only if the merge succeeds
             bool TryMergeExponent(const TensorValue & i_source_exponent)
             {
                 ScalarType const source_scalar_type = i_source_exponent.GetScalarType();
 
-                m_exponent_shape = Broadcast({m_exponent_shape, i_source_exponent.GetShape()});
-
-                ExponentNumericPromotion(source_scalar_type);
+                Exponent const dest = GetPromotedExponent(source_scalar_type);
 
-                ScalarType const dest_scalar_type = GetExponentType();
-                if(dest_scalar_type == ScalarType::Integer)
+                if(std::holds_alternative<SharedArray<Integer>>(dest))
                 {
                     if(source_scalar_type == ScalarType::Integer)
-                        return TryMergeExponentScalars<Integer, Integer>(i_source_exponent);
+                        return TryMergeExponentScalars<Integer, Integer>(dest, i_source_exponent);
                     else
                         Panic("MergeExponent - internal error - source was expected to be integral");
                 }
-                else if(dest_scalar_type == ScalarType::Real)
+                else if(std::holds_alternative<SharedArray<Real>>(dest))
                 {
                     if(source_scalar_type == ScalarType::Integer)
-                        return TryMergeExponentScalars<Real, Integer>(i_source_exponent);
+                        return TryMergeExponentScalars<Real, Integer>(dest, i_source_exponent);
                     if(source_scalar_type == ScalarType::Real)
-                        return TryMergeExponentScalars<Real, Real>(i_source_exponent);
+                        return TryMergeExponentScalars<Real, Real>(dest, i_source_exponent);
                     else
                         Panic("MergeExponent - internal error - source was expected to be real or integral");
                 }
@@ -188,46 +196,92 @@ namespace liquid
             }
         };
 
+        /* divides a term by pow(i_base, i_exponent), subtracting the exponent from
+            the first factor of the term with the same base. The quotient does not
+            depend on the canonicalization of mul merging the powers. */
+        Tensor DivideTerm(const Tensor & i_term, const Tensor & i_base, const Tensor & i_exponent)
+        {
+            std::vector<Tensor> quotient;
+            bool divided = false;
+            EnumFactors(i_term, [&](const Tensor & i_factor_base, const TensorValue & i_factor_exponent) {
+                Tensor exponent = MakeConstant(i_factor_exponent);
+                if(!divided && AreIdentical(i_factor_base, i_base))
+                {
+                    exponent = exponent - i_exponent;
+                    divided = true;
+                }
+                quotient.push_back(Pow(i_factor_base, exponent));
+            });
+            LIQUID_ASSERT(divided);
+            return Mul(quotient);
+        }
+
     } // detail
     
     std::optional<Tensor> Factorize(Span<const Tensor> i_terms)
     {
+        /* factors are bucketed by the hash of their base, so that every factor
+            is compared only with the factors that may have an identical base */
         std::vector<Factor> factors;
+        std::unordered_map<Hash::Word, std::vector<size_t>> buckets;
 
         for(size_t term_index = 0; term_index < i_terms.size(); term_index++)
         {
             EnumFactors(i_terms[term_index], [&](const Tensor & i_base, const TensorValue & i_exponent) {
 
-                bool found = false;
-                for(auto & factor : factors)
+                std::vector<size_t> & bucket = buckets[i_base.GetExpression()->GetHash().GetValue()];
+                for(size_t factor_index : bucket)
                 {
+                    Factor & factor = factors[factor_index];
                     if(AreIdentical(factor.m_base, i_base) && factor.TryMergeExponent(i_exponent))
                     {
-                        factor.m_term_indices.push_back(term_index);
-                        found = true;
-                        break;
+                        if(factor.m_term_indices.back() != term_index)
+                            factor.m_term_indices.push_back(term_index);
+                        return;
                     }
                 }
-                if(!found)
-                    factors.emplace_back(i_base, i_exponent, term_index);
+                bucket.push_back(factors.size());
+                factors.emplace_back(i_base, i_exponent, term_index);
             });
         }
 
         if(!factors.empty())
         {
-            auto const most_requent = std::max_element(factors.begin(), factors.end(), 
+            auto most_requent = std::max_element(factors.begin(), factors.end(), 
                 [](const Factor & i_first, const Factor & i_second){
                     return i_first.m_term_indices.size() < i_second.m_term_indices.size(); });
 
+            // with the same number of terms, factoring out the most expensive base saves more
+            if(most_requent->m_term_indices.size() >= 2)
+            {
+                int64_t max_cost = most_requent->m_base.GetExpression()->GetComputationalCostExtimate();
+                for(auto it = most_requent + 1; it != factors.end(); ++it)
+                {
+                    if(it->m_term_indices.size() == most_requent->m_term_indices.size())
+                    {
+                        int64_t const cost = it->m_base.GetExpression()->GetComputationalCostExtimate();
+                        if(cost > max_cost)
+                        {
+                            max_cost = cost;
+                            most_requent = it;
+                        }
+                    }
+                }
+            }
+
             if(most_requent->m_term_indices.size() >= 2)
             {
-                Tensor const factor = Pow(most_requent->m_base, 
-                    MakeConstant(most_requent->GetAndResetExponent()));
+                Tensor const exponent = MakeConstant(most_requent->GetAndResetExponent());
+                Tensor const factor = Pow(most_requent->m_base, exponent);
+                std::vector<bool> is_factorized(i_terms.size());
+                for(size_t term_index : most_requent->m_term_indices)
+                    is_factorized[term_index] = true;
+
                 std::vector<Tensor> factorized_terms, non_factorized_terms;
                 for(size_t term_index = 0; term_index < i_terms.size(); term_index++)
                 {
-                    if(Contains(most_requent->m_term_indices, term_index))
-                        factorized_terms.push_back(i_terms[term_index] / factor);
+                    if(is_factorized[term_index])
+                        factorized_terms.push_back(DivideTerm(i_terms[term_index], most_requent->m_base, exponent));
                     else
                         non_factorized_terms.push_back(i_terms[term_index]);
                 }
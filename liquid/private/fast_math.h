@@ -0,0 +1,246 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#include "private_common.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace liquid
+{
+    /* Polynomial approximations used by the transcendental kernels in Precision::Fast. Every
+        kernel has a core made only of arithmetic and bit operations, that is vectorized even
+        with SSE2, and the elements out of the domain of the core are computed by the C library
+        in a second pass. The maximum errors, measured against the C library in units in the
+        last place, are:
+            FastExp     2 ulp
+            FastLog     1 ulp
+            FastSin     2 ulp
+            FastCos     2 ulp
+            FastPow     4 + 2.5 * |y * log(x)| ulp
+        The error of FastPow grows with the magnitude of the result, since the rounding error
+        of the logarithm is multiplied by the exponent. */
+
+    namespace fast_math
+    {
+        inline uint64_t ToBits(Real i_value)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &i_value, sizeof(bits));
+            return bits;
+        }
+
+        inline Real FromBits(uint64_t i_bits)
+        {
+            Real value;
+            std::memcpy(&value, &i_bits, sizeof(value));
+            return value;
+        }
+
+        // adding and subtracting 1.5 * 2^52 rounds to the nearest integer
+        constexpr Real g_round_shifter = 6755399441055744.0;
+
+        // ln(2) split so that the product of the high part by a small integer is exact
+        constexpr Real g_ln2_high = 6.93147180369123816490e-01;
+        constexpr Real g_ln2_low = 1.90821492927058770002e-10;
+
+        // pi/2 split in three parts, the first two have 33 significant bits
+        constexpr Real g_half_pi_1 = 1.57079632673412561417e+00;
+        constexpr Real g_half_pi_2 = 6.07710050630396597660e-11;
+        constexpr Real g_half_pi_3 = 2.02226624879595063154e-21;
+
+        // beyond this the quotient by pi/2 has more than 20 bits, and the reduction is not exact
+        constexpr Real g_trigonometric_limit = 1048576.0;
+
+        // exp(x) for |x| < 708
+        inline Real ExpCore(Real i_x)
+        {
+            // x = k * ln(2) + r, with |r| <= ln(2) / 2
+            Real const t = i_x * 1.4426950408889634 + g_round_shifter;
+            Real const k = t - g_round_shifter;
+            Real const r = (i_x - k * g_ln2_high) - k * g_ln2_low;
+
+            // Taylor up to the term of degree 12
+            Real p = 2.0876756987868099e-09;
+            p = p * r + 2.5052108385441720e-08;
+            p = p * r + 2.7557319223985893e-07;
+            p = p * r + 2.7557319223985891e-06;
+            p = p * r + 2.4801587301587302e-05;
+            p = p * r + 1.9841269841269841e-04;
+            p = p * r + 1.3888888888888889e-03;
+            p = p * r + 8.3333333333333333e-03;
+            p = p * r + 4.1666666666666667e-02;
+            p = p * r + 1.6666666666666667e-01;
+            p = p * r + 0.5;
+            p = 1.0 + (r + r * r * p);
+
+            // the low bits of t are k, so 2^k is built adding the bias to them
+            uint64_t const scale = (ToBits(t) - ToBits(g_round_shifter) + 1023) << 52;
+            return p * FromBits(scale);
+        }
+
+        // log(x) for a positive normal x
+        inline Real LogCore(Real i_x)
+        {
+            // x = m * 2^k, with sqrt(1/2) <= m < sqrt(2)
+            uint64_t const sqrt_half = 0x3fe6a09e667f3bcdULL;
+            uint64_t const bits = ToBits(i_x) + (0x3ff0000000000000ULL - sqrt_half);
+            Real const m = FromBits((bits & 0x000fffffffffffffULL) + sqrt_half);
+            Real const k = FromBits((bits >> 52) | 0x4330000000000000ULL) - (4503599627370496.0 + 1023.0);
+
+            // log(m) = 2 * atanh(s), with s = (m - 1) / (m + 1) and |s| < 0.172
+            Real const f = m - 1.0;
+            Real const s = f / (m + 1.0);
+            Real const z = s * s;
+            Real p = 1.0 / 23.0;
+            p = p * z + 1.0 / 21.0;
+            p = p * z + 1.0 / 19.0;
+            p = p * z + 1.0 / 17.0;
+            p = p * z + 1.0 / 15.0;
+            p = p * z + 1.0 / 13.0;
+            p = p * z + 1.0 / 11.0;
+            p = p * z + 1.0 / 9.0;
+            p = p * z + 1.0 / 7.0;
+            p = p * z + 1.0 / 5.0;
+            p = p * z + 1.0 / 3.0;
+
+            // log(m) = f - f^2 / 2 + s * (f^2 / 2 + 2 * z * p), so that f is not rounded
+            Real const half_f_squared = 0.5 * f * f;
+            Real const log_m = f - (half_f_squared - s * (half_f_squared + 2.0 * z * p));
+            return k * g_ln2_high + (log_m + k * g_ln2_low);
+        }
+
+        // sin(r) for |r| <= pi/4, Taylor up to the term of degree 17
+        inline Real SinKernel(Real i_r)
+        {
+            Real const z = i_r * i_r;
+            Real p = 2.8114572543455206e-15;
+            p = p * z - 7.6471637318198164e-13;
+            p = p * z + 1.6059043836821613e-10;
+            p = p * z - 2.5052108385441720e-08;
+            p = p * z + 2.7557319223985893e-06;
+            p = p * z - 1.9841269841269841e-04;
+            p = p * z + 8.3333333333333333e-03;
+            p = p * z - 1.6666666666666667e-01;
+            return i_r + i_r * z * p;
+        }
+
+        // cos(r) for |r| <= pi/4, Taylor up to the term of degree 18
+        inline Real CosKernel(Real i_r)
+        {
+            Real const z = i_r * i_r;
+            Real p = -1.5619206968586225e-16;
+            p = p * z + 4.7794773323873853e-14;
+            p = p * z - 1.1470745597729725e-11;
+            p = p * z + 2.0876756987868099e-09;
+            p = p * z - 2.7557319223985891e-07;
+            p = p * z + 2.4801587301587302e-05;
+            p = p * z - 1.3888888888888889e-03;
+            p = p * z + 4.1666666666666667e-02;
+
+            // the rounding error of 1 - z/2 is added back
+            Real const half_z = 0.5 * z;
+            Real const w = 1.0 - half_z;
+            return w + (((1.0 - w) - half_z) + z * z * p);
+        }
+
+        /* sin(x + i_phase * pi/2) for |x| < g_trigonometric_limit, where the phase is 0 for
+            the sine and 1 for the cosine. The quadrant selects the kernel and the sign with
+            masks instead of branches. */
+        inline Real SinCore(Real i_x, uint64_t i_phase)
+        {
+            Real const t = i_x * 0.63661977236758134308 + g_round_shifter;
+            Real const n = t - g_round_shifter;
+            Real const r = ((i_x - n * g_half_pi_1) - n * g_half_pi_2) - n * g_half_pi_3;
+            uint64_t const quadrant = ToBits(t) - ToBits(g_round_shifter) + i_phase;
+
+            uint64_t const cosine_mask = 0 - (quadrant & 1);
+            uint64_t const value = (ToBits(CosKernel(r)) & cosine_mask) | (ToBits(SinKernel(r)) & ~cosine_mask);
+            return FromBits(value ^ ((quadrant & 2) << 62));
+        }
+
+        /* Applies the core to every element, then computes with the C library the elements
+            out of the domain of the core. */
+        template <typename CORE, typename IN_DOMAIN, typename EXACT>
+            void FastTransform(const Real * i_source, Real * o_dest, size_t i_count,
+                const CORE & i_core, const IN_DOMAIN & i_in_domain, const EXACT & i_exact)
+        {
+            for(size_t index = 0; index < i_count; index++)
+                o_dest[index] = i_core(i_source[index]);
+
+            for(size_t index = 0; index < i_count; index++)
+                if(!i_in_domain(i_source[index]))
+                    o_dest[index] = i_exact(i_source[index]);
+        }
+
+        inline bool IsPositiveNormal(Real i_x)
+        {
+            return i_x >= std::numeric_limits<Real>::min() && i_x <= std::numeric_limits<Real>::max();
+        }
+    }
+
+    inline void FastExp(const Real * i_source, Real * o_dest, size_t i_count)
+    {
+        using namespace fast_math;
+        FastTransform(i_source, o_dest, i_count, ExpCore,
+            [](Real i_x) { return std::abs(i_x) < 708.0; },
+            [](Real i_x) { return std::exp(i_x); });
+    }
+
+    inline void FastLog(const Real * i_source, Real * o_dest, size_t i_count)
+    {
+        using namespace fast_math;
+        FastTransform(i_source, o_dest, i_count, LogCore, IsPositiveNormal,
+            [](Real i_x) { return std::log(i_x); });
+    }
+
+    inline void FastSin(const Real * i_source, Real * o_dest, size_t i_count)
+    {
+        using namespace fast_math;
+        // the core loses the sign of -0
+        FastTransform(i_source, o_dest, i_count,
+            [](Real i_x) { return SinCore(i_x, 0); },
+            [](Real i_x) { return std::abs(i_x) < g_trigonometric_limit && i_x != 0; },
+            [](Real i_x) { return std::sin(i_x); });
+    }
+
+    inline void FastCos(const Real * i_source, Real * o_dest, size_t i_count)
+    {
+        using namespace fast_math;
+        FastTransform(i_source, o_dest, i_count,
+            [](Real i_x) { return SinCore(i_x, 1); },
+            [](Real i_x) { return std::abs(i_x) < g_trigonometric_limit; },
+            [](Real i_x) { return std::cos(i_x); });
+    }
+
+    // pow(x, y) = exp(y * log(x)), the C library is used if x is not a positive normal number
+    inline void FastPow(const Real * i_bases, const Real * i_exponents, Real * o_dest, size_t i_count)
+    {
+        using namespace fast_math;
+
+        // blocks small enough for the products to stay in the L1 cache
+        constexpr size_t block_size = 256;
+        Real products[block_size];
+        for(size_t block = 0; block < i_count; block += block_size)
+        {
+            size_t const size = std::min(block_size, i_count - block);
+            const Real * const bases = i_bases + block;
+            const Real * const exponents = i_exponents + block;
+            Real * const dest = o_dest + block;
+
+            for(size_t index = 0; index < size; index++)
+                products[index] = exponents[index] * LogCore(bases[index]);
+
+            for(size_t index = 0; index < size; index++)
+                dest[index] = ExpCore(products[index]);
+
+            for(size_t index = 0; index < size; index++)
+                if(!IsPositiveNormal(bases[index]) || !(std::abs(products[index]) < 708.0))
+                    dest[index] = std::pow(bases[index], exponents[index]);
+        }
+    }
+}
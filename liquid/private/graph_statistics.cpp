@@ -0,0 +1,109 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "expression.h"
+#include <unordered_map>
+#include <algorithm>
+#include <vector>
+
+namespace liquid
+{
+    extern const Operator & GetOperatorVariable();
+
+    namespace
+    {
+        // leaves are inputs of the evaluation, so they have no cost and are not intermediates
+        bool IsLeaf(const Expression & i_expression)
+        {
+            return IsConstant(i_expression) || i_expression.OperatorIs(GetOperatorVariable());
+        }
+
+        struct NodeInfo
+        {
+            size_t m_depth = 0;
+            size_t m_pending_uses = 0;
+        };
+
+        // the visit is iterative, so that deep graphs do not overflow the stack
+        std::vector<const Expression *> PostOrder(Span<const Expression * const> i_roots,
+            std::unordered_map<const Expression *, NodeInfo> & o_nodes)
+        {
+            std::vector<const Expression *> post_order;
+            std::vector<std::pair<const Expression *, size_t>> stack; // node and next operand
+            for(const Expression * root : i_roots)
+            {
+                if(!o_nodes.emplace(root, NodeInfo{}).second)
+                    continue;
+
+                stack.emplace_back(root, 0);
+                while(!stack.empty())
+                {
+                    const Expression * const node = stack.back().first;
+                    size_t const operand_index = stack.back().second++;
+                    if(operand_index < node->GetOperands().size())
+                    {
+                        const Expression * const operand = node->GetOperand(operand_index).GetExpression().get();
+                        if(o_nodes.emplace(operand, NodeInfo{}).second)
+                            stack.emplace_back(operand, 0);
+                    }
+                    else
+                    {
+                        post_order.push_back(node);
+                        stack.pop_back();
+                    }
+                }
+            }
+            return post_order;
+        }
+    }
+
+    GraphStatistics GetGraphStatistics(Span<const Expression * const> i_roots)
+    {
+        std::unordered_map<const Expression *, NodeInfo> nodes;
+        std::vector<const Expression *> const post_order = PostOrder(i_roots, nodes);
+
+        // roots have a use that is never released
+        for(const Expression * root : i_roots)
+            nodes.at(root).m_pending_uses++;
+        for(const Expression * node : post_order)
+            for(const Tensor & operand : node->GetOperands())
+                nodes.at(operand.GetExpression().get()).m_pending_uses++;
+
+        GraphStatistics statistics;
+        statistics.m_unique_nodes = post_order.size();
+        int64_t live_bytes = 0;
+        for(const Expression * node : post_order)
+        {
+            NodeInfo & info = nodes.at(node);
+            for(const Tensor & operand : node->GetOperands())
+                info.m_depth = std::max(info.m_depth, nodes.at(operand.GetExpression().get()).m_depth);
+            info.m_depth++;
+            statistics.m_depth = std::max(statistics.m_depth, info.m_depth);
+
+            if(!IsLeaf(*node))
+            {
+                statistics.m_flops += node->GetCost().m_flops;
+                live_bytes += node->GetCost().m_bytes;
+                statistics.m_peak_intermediate_bytes = std::max(statistics.m_peak_intermediate_bytes, live_bytes);
+            }
+
+            // the operands are alive until the result has been computed
+            for(const Tensor & operand : node->GetOperands())
+            {
+                const Expression & operand_expression = *operand.GetExpression();
+                if(--nodes.at(&operand_expression).m_pending_uses == 0 && !IsLeaf(operand_expression))
+                    live_bytes -= operand_expression.GetCost().m_bytes;
+            }
+        }
+        return statistics;
+    }
+
+    GraphStatistics GetGraphStatistics(Span<const Tensor> i_roots)
+    {
+        std::vector<const Expression *> const roots = Transform(i_roots,
+            [](const Tensor & i_root){ return i_root.GetExpression().get(); });
+        return GetGraphStatistics(roots);
+    }
+}
@@ -69,7 +69,7 @@ namespace liquid
 
     inline Hash & operator << (Hash & i_dest, const Hash & i_source)
     {
-        i_dest << i_dest.GetValue();
+        i_dest << i_source.GetValue();
         return i_dest;
     }
 
@@ -0,0 +1,290 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "incremental_evaluator.h"
+#include "expression.h"
+#include "tensor_type.h"
+#include <algorithm>
+
+namespace liquid
+{
+    IncrementalEvaluator::IncrementalEvaluator(Span<const Tensor> i_roots, std::optional<Precision> i_precision)
+        : m_precision(i_precision)
+    {
+        // iterative post-order visit, so that deep graphs do not overflow the stack
+        std::unordered_map<const Expression *, size_t> node_indices;
+        std::vector<std::pair<const Tensor *, size_t>> stack; // tensor and next operand
+        for(const Tensor & root : i_roots)
+        {
+            if(node_indices.find(root.GetExpression().get()) == node_indices.end())
+                stack.emplace_back(&root, 0);
+
+            while(!stack.empty())
+            {
+                const Tensor & tensor = *stack.back().first;
+                auto const & operands = tensor.GetExpression()->GetOperands();
+                size_t const operand_index = stack.back().second++;
+                if(operand_index < operands.size())
+                {
+                    if(node_indices.find(operands[operand_index].GetExpression().get()) == node_indices.end())
+                        stack.emplace_back(&operands[operand_index], 0);
+                    continue;
+                }
+                stack.pop_back();
+
+                if(node_indices.find(tensor.GetExpression().get()) != node_indices.end())
+                    continue; // pushed more than once
+
+                size_t const node_index = m_nodes.size();
+                node_indices.emplace(tensor.GetExpression().get(), node_index);
+                Node & node = m_nodes.emplace_back(Node{tensor, {}, {}, {}, true});
+                for(const Tensor & operand : operands)
+                {
+                    size_t const operand_node = node_indices.at(operand.GetExpression().get());
+                    node.m_operands.push_back(operand_node);
+                    m_nodes[operand_node].m_users.push_back(node_index);
+                }
+
+                const Expression & expression = *tensor.GetExpression();
+                if(IsConstant(tensor))
+                    node.m_value = GetConstantValue(tensor);
+                else if(IsVariable(tensor))
+                {
+                    m_variable_nodes[expression.GetHash().GetValue()].push_back(node_index);
+
+                    const TensorType & type = expression.GetType();
+                    if(type.HasVariableShape())
+                    {
+                        m_symbolic_variables.push_back(node_index);
+                        if(auto const dimensions = TryGetDimensions(type))
+                            for(const Tensor & dimension : *dimensions)
+                                if(IsVariable(dimension) && !IsDimensionVariable(dimension))
+                                    m_dimension_variables.push_back(dimension);
+                    }
+                }
+                else
+                {
+                    for(const Tensor & constraint : expression.GetOperator().GetShapeConstraints(
+                            expression.GetAttachment(), operands))
+                        m_shape_constraints.push_back(constraint);
+                }
+            }
+
+            m_root_nodes.push_back(node_indices.at(root.GetExpression().get()));
+        }
+    }
+
+    std::vector<size_t> IncrementalEvaluator::FindVariableNodes(const Tensor & i_variable) const
+    {
+        std::vector<size_t> result;
+        auto const bucket = m_variable_nodes.find(i_variable.GetExpression()->GetHash().GetValue());
+        if(bucket != m_variable_nodes.end())
+            for(size_t node_index : bucket->second)
+                if(AreIdentical(m_nodes[node_index].m_tensor, i_variable))
+                    result.push_back(node_index);
+        return result;
+    }
+
+    bool IncrementalEvaluator::IsDimensionVariable(const Tensor & i_variable) const
+    {
+        return std::any_of(m_dimension_variables.begin(), m_dimension_variables.end(),
+            [&](const Tensor & i_dimension){ return AreIdentical(i_dimension, i_variable); });
+    }
+
+    void IncrementalEvaluator::SetValue(const Tensor & i_variable, const TensorValue & i_value)
+    {
+        if(!IsVariable(i_variable))
+            Panic("IncrementalEvaluator::SetValue - ", i_variable, " is not a variable");
+
+        if(!i_variable.GetExpression()->GetType().IsSupercaseOf(i_value.GetType()))
+            Panic("IncrementalEvaluator::SetValue - the variable ", i_variable.GetExpression()->GetName(),
+                " can't have a value of type ", i_value.GetType());
+
+        if(IsDimensionVariable(i_variable))
+            Panic("IncrementalEvaluator::SetValue - ", i_variable.GetExpression()->GetName(),
+                " is a dimension, its value is deduced from the shapes of the variables");
+
+        for(size_t node_index : FindVariableNodes(i_variable))
+        {
+            Node & node = m_nodes[node_index];
+            if(i_variable.GetExpression()->GetType().HasVariableShape() &&
+                    (!node.m_value || node.m_value->GetShape() != i_value.GetShape()))
+                m_shapes_changed = true;
+            node.m_value = i_value;
+            m_changed_variables.push_back(node_index);
+        }
+    }
+
+    void IncrementalEvaluator::CheckShapes()
+    {
+        // binds the dimension variables to the shapes of the values
+        std::vector<Rule> bindings;
+        for(size_t node_index : m_symbolic_variables)
+        {
+            const Node & node = m_nodes[node_index];
+            auto const dimensions = TryGetDimensions(node.m_tensor.GetExpression()->GetType());
+            if(!node.m_value || !dimensions)
+                continue;
+
+            // the rank and the constant dimensions are checked by SetValue
+            Span<const Integer> const values = node.m_value->GetShape().GetDimensions();
+            for(size_t index = 0; index < dimensions->size(); index++)
+            {
+                const Tensor & dimension = (*dimensions)[index];
+                if(!IsVariable(dimension))
+                    continue;
+
+                auto const binding = std::find_if(bindings.begin(), bindings.end(),
+                    [&](const Rule & i_rule){ return AreIdentical(i_rule.m_what, dimension); });
+                if(binding == bindings.end())
+                    bindings.push_back(Rule{dimension, values[index]});
+                else if(!AlwaysEqual(binding->m_with, values[index]))
+                    Panic("IncrementalEvaluator::Update - the dimension ", dimension.GetExpression()->GetName(),
+                        " is ", binding->m_with, ", but it's ", values[index], " in ", node.m_tensor.GetExpression()->GetName());
+            }
+        }
+
+        // dimensions that are expressions of the dimension variables
+        for(size_t node_index : m_symbolic_variables)
+        {
+            const Node & node = m_nodes[node_index];
+            auto const dimensions = TryGetDimensions(node.m_tensor.GetExpression()->GetType());
+            if(!node.m_value || !dimensions)
+                continue;
+
+            Span<const Integer> const values = node.m_value->GetShape().GetDimensions();
+            for(size_t index = 0; index < dimensions->size(); index++)
+            {
+                const Tensor & dimension = (*dimensions)[index];
+                if(IsVariable(dimension) || IsConstant(dimension))
+                    continue;
+
+                Tensor const value = Substitute(dimension, bindings);
+                if(IsConstant(value) && !AlwaysEqual(value, values[index]))
+                    Panic("IncrementalEvaluator::Update - the dimension ", dimension, " of ", node.m_tensor.GetExpression()->GetName(),
+                        " should be ", value, ", but it's ", values[index]);
+            }
+        }
+
+        for(const Tensor & constraint : m_shape_constraints)
+        {
+            Tensor const condition = Substitute(constraint, bindings);
+            if(IsConstant(condition) && !Always(condition))
+                Panic("IncrementalEvaluator::Update - the shapes of the variables violate the constraint ", constraint);
+        }
+
+        // the dimension variables used in the graph get the bound values
+        for(const Rule & binding : bindings)
+        {
+            TensorValue const value = GetConstantValue(binding.m_with);
+            for(size_t node_index : FindVariableNodes(binding.m_what))
+            {
+                Node & node = m_nodes[node_index];
+                if(!node.m_value || !AlwaysEqual(MakeConstant(*node.m_value), value))
+                {
+                    node.m_value = value;
+                    m_changed_variables.push_back(node_index);
+                }
+            }
+        }
+    }
+
+    size_t IncrementalEvaluator::Update()
+    {
+        // the shape checks are done only when the shapes change, and before evaluating any node
+        if(m_first_update || m_shapes_changed)
+        {
+            CheckShapes();
+            m_shapes_changed = false;
+        }
+
+        if(m_first_update)
+        {
+            m_cone.clear();
+            for(size_t node_index = 0; node_index < m_nodes.size(); node_index++)
+                m_cone.push_back(node_index);
+        }
+        else
+        {
+            // the nodes left dirty by an update that has panicked are still in the cone
+            m_cone.erase(std::remove_if(m_cone.begin(), m_cone.end(),
+                [&](size_t i_node_index){ return !m_nodes[i_node_index].m_dirty; }), m_cone.end());
+
+            // mark the users of the changed variables, and their users, and so on
+            std::vector<size_t> stack = std::move(m_changed_variables);
+            while(!stack.empty())
+            {
+                size_t const node_index = stack.back();
+                stack.pop_back();
+                for(size_t user : m_nodes[node_index].m_users)
+                {
+                    if(!m_nodes[user].m_dirty)
+                    {
+                        m_nodes[user].m_dirty = true;
+                        m_cone.push_back(user);
+                        stack.push_back(user);
+                    }
+                }
+            }
+
+            // node indices are in post-order, so sorting them gives an evaluation order
+            std::sort(m_cone.begin(), m_cone.end());
+        }
+        m_changed_variables.clear();
+
+        std::optional<PrecisionContext> precision;
+        if(m_precision)
+            precision.emplace(*m_precision);
+
+        size_t evaluated_nodes = 0;
+        for(size_t node_index : m_cone)
+        {
+            Node & node = m_nodes[node_index];
+            if(IsVariable(node.m_tensor))
+            {
+                if(!node.m_value)
+                    Panic("IncrementalEvaluator::Update - the variable ", 
+                        node.m_tensor.GetExpression()->GetName(), " has no value");
+            }
+            else if(!IsConstant(node.m_tensor))
+            {
+                Evaluate(node);
+                evaluated_nodes++;
+            }
+            node.m_dirty = false;
+        }
+
+        // the update is complete only if no node has panicked
+        m_cone.clear();
+        m_first_update = false;
+        return evaluated_nodes;
+    }
+
+    void IncrementalEvaluator::Evaluate(Node & i_node)
+    {
+        /* the operator is invoked with constant operands, so that type deduction,
+            overload resolution and numeric promotion work as for any expression */
+        std::vector<Tensor> operands;
+        operands.reserve(i_node.m_operands.size());
+        for(size_t operand : i_node.m_operands)
+            operands.push_back(MakeConstant(*m_nodes[operand].m_value));
+
+        const Expression & expression = *i_node.m_tensor.GetExpression();
+        Tensor const result = expression.GetOperator().Invoke(expression.GetName(),
+            expression.GetDoc(), operands, expression.GetAttachment());
+        if(!IsConstant(result))
+            Panic("IncrementalEvaluator - ", expression.GetOperator().GetName(), " could not be evaluated");
+
+        i_node.m_value = GetConstantValue(result);
+    }
+
+    const TensorValue & IncrementalEvaluator::GetValue(size_t i_root_index) const
+    {
+        const Node & node = m_nodes[m_root_nodes.at(i_root_index)];
+        if(node.m_dirty)
+            Panic("IncrementalEvaluator::GetValue - the value is outdated, Update has never been called or has panicked");
+        return *node.m_value;
+    }
+}
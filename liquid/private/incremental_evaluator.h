@@ -0,0 +1,88 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#include "private_common.h"
+#include "liquid/tensor.h"
+#include "tensor_value.h"
+#include "hash.h"
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace liquid
+{
+    /* Evaluates a graph given the values of its variables, and keeps the value of
+        every node. When some variables change, Update recomputes only the nodes that
+        depend on them (the cone of the changed variables), found following the
+        edges from every node to its users.
+
+        Variables may have a symbolic shape, like real[int n, 3] x: the graph is built once
+        and evaluated for any n. When the shapes of the values change, Update binds the
+        dimension variables to them and checks the shape constraints of all the nodes (see
+        Operator::GetShapeConstraints) before evaluating any node. Dimension variables used
+        in the graph get their value from the shapes, so they can't be set. */
+    class IncrementalEvaluator
+    {
+    public:
+
+        /* If a precision is specified, it is used by Update instead of the precision of
+            the calling thread. */
+        IncrementalEvaluator(Span<const Tensor> i_roots, std::optional<Precision> i_precision = {});
+
+        IncrementalEvaluator(const IncrementalEvaluator &) = delete;
+        IncrementalEvaluator & operator = (const IncrementalEvaluator &) = delete;
+
+        /* Sets the value of all the variables of the graph identical to i_variable.
+            The new value is used by the next Update. */
+        void SetValue(const Tensor & i_variable, const TensorValue & i_value);
+
+        /* Recomputes the nodes affected by the values set since the last update, and
+            returns the number of operations evaluated. The first update evaluates the
+            whole graph, so all the variables must have a value. If an update panics, the
+            nodes it has not evaluated are evaluated by the next one. */
+        size_t Update();
+
+        // value of a root as computed by the last completed update
+        const TensorValue & GetValue(size_t i_root_index) const;
+
+        size_t GetNodeCount() const { return m_nodes.size(); }
+
+    private:
+
+        struct Node
+        {
+            Tensor m_tensor;
+            std::vector<size_t> m_operands;
+            std::vector<size_t> m_users;
+            std::optional<TensorValue> m_value;
+            bool m_dirty = true;
+        };
+
+        void Evaluate(Node & i_node);
+
+        std::vector<size_t> FindVariableNodes(const Tensor & i_variable) const;
+
+        bool IsDimensionVariable(const Tensor & i_variable) const;
+
+        // binds the dimension variables and checks the shape constraints
+        void CheckShapes();
+
+    private:
+        std::vector<Node> m_nodes; // in post-order, so operands come before their users
+        std::vector<size_t> m_root_nodes;
+        std::unordered_map<Hash::Word, std::vector<size_t>> m_variable_nodes;
+        std::vector<size_t> m_changed_variables;
+        std::vector<size_t> m_cone; // nodes to evaluate, not empty only if an update has panicked
+        std::optional<Precision> m_precision;
+        bool m_first_update = true;
+
+        // symbolic shapes
+        std::vector<size_t> m_symbolic_variables; // variable nodes with a symbolic shape
+        std::vector<Tensor> m_dimension_variables;
+        std::vector<Tensor> m_shape_constraints;
+        bool m_shapes_changed = false;
+    };
+}
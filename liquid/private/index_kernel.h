@@ -0,0 +1,106 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#include "private_common.h"
+#include "tensor_value.h"
+#include <algorithm>
+
+namespace liquid
+{
+    /* Gather and scatter address a tensor as [outer, dimension, inner], where dimension is
+        the indexed axis, outer is the product of the dimensions before it, and inner is the
+        product of the dimensions after it. Every index selects a block of inner elements. */
+    struct IndexedAxis
+    {
+        size_t m_outer = 1;
+        size_t m_dimension = 1;
+        size_t m_inner = 1;
+    };
+
+    inline IndexedAxis GetIndexedAxis(const FixedShape & i_shape, Integer i_axis)
+    {
+        Span<const Integer> const dimensions = i_shape.GetDimensions();
+        IndexedAxis result;
+        for(size_t axis = 0; axis < dimensions.size(); axis++)
+        {
+            size_t const dimension = NumericCast<size_t>(dimensions[axis]);
+            if(NumericCast<Integer>(axis) < i_axis)
+                result.m_outer *= dimension;
+            else if(NumericCast<Integer>(axis) == i_axis)
+                result.m_dimension = dimension;
+            else
+                result.m_inner *= dimension;
+        }
+        return result;
+    }
+
+    // the shape of the tensor with the indexed axis replaced by the dimensions of the indices
+    inline FixedShape GetGatheredShape(const char * i_name, const FixedShape & i_source,
+        const FixedShape & i_indices, Integer i_axis)
+    {
+        Span<const Integer> const dimensions = i_source.GetDimensions();
+        if(i_axis < 0 || i_axis >= NumericCast<Integer>(dimensions.size()))
+            Panic(i_name, ": the axis ", i_axis, " is out of range for the rank ", dimensions.size());
+
+        size_t const axis = NumericCast<size_t>(i_axis);
+        return FixedShape(Concatenate(dimensions.subspan(0, axis),
+            i_indices.GetDimensions(), dimensions.subspan(axis + 1)));
+    }
+
+    /* Validates the indices. Sorted indices are checked only at the ends, and contiguous
+        indices (a sequence with step 1) let the caller process all the blocks at once. */
+    struct IndexSequence
+    {
+        bool m_sorted = true;
+        bool m_contiguous = true;
+    };
+
+    inline IndexSequence CheckIndices(const char * i_name, Span<const Integer> i_indices, size_t i_dimension)
+    {
+        IndexSequence sequence;
+        for(size_t index = 1; index < i_indices.size() && sequence.m_sorted; index++)
+        {
+            sequence.m_sorted = i_indices[index - 1] <= i_indices[index];
+            sequence.m_contiguous = sequence.m_contiguous && i_indices[index - 1] + 1 == i_indices[index];
+        }
+        sequence.m_contiguous = sequence.m_contiguous && sequence.m_sorted;
+
+        Integer const dimension = NumericCast<Integer>(i_dimension);
+        auto const check = [&](Integer i_index) {
+            if(i_index < 0 || i_index >= dimension)
+                Panic(i_name, ": the index ", i_index, " is out of range for the dimension ", dimension);
+        };
+        if(sequence.m_sorted)
+        {
+            if(!i_indices.empty())
+            {
+                check(i_indices[0]);
+                check(i_indices[i_indices.size() - 1]);
+            }
+        }
+        else
+            for(Integer index : i_indices)
+                check(index);
+
+        return sequence;
+    }
+
+    /* Returns the elements of the value in row-major order, without wrapping. The storage is
+        used directly if it's dense, otherwise the elements are copied in o_buffer. */
+    template <typename SCALAR_TYPE>
+        const SCALAR_TYPE * GetUnwrapped(const TensorValue & i_value, SharedArray<SCALAR_TYPE> & o_buffer)
+    {
+        Span<const SCALAR_TYPE> const storage = i_value.GetAs<SCALAR_TYPE>();
+        size_t const size = NumericCast<size_t>(i_value.GetShape().GetLinearSize());
+        if(storage.size() == size)
+            return storage.data();
+
+        o_buffer = SharedArray<SCALAR_TYPE>(size);
+        for(size_t index = 0; index < size; index++)
+            o_buffer[index] = storage[index % storage.size()];
+        return o_buffer.data();
+    }
+}
@@ -69,9 +69,10 @@ namespace liquid
             const SCALAR_TYPE & At(const TensorValue & i_tensor_value) const
         {
             Integer const physical_linear_index = static_cast<size_t>(
-                i_tensor_value.GetShape().GetPhysicalLinearIndex(m_indices));
+                i_tensor_value.GetPhysicalLinearIndex(m_indices));
 
-            Span<SCALAR_TYPE const> const elements = i_tensor_value.GetAs<SCALAR_TYPE>();
+            // views are addressed with their strides, without a dense copy
+            Span<SCALAR_TYPE const> const elements = i_tensor_value.GetStorageAs<SCALAR_TYPE>();
             
             // constant reduction wraps the storage
             size_t const modulo_index = physical_linear_index % elements.size();
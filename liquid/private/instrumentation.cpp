@@ -0,0 +1,54 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "instrumentation.h"
+#include "book.h"
+#include "tensor_value.h"
+#include <ostream>
+
+namespace liquid
+{
+    uint64_t GetStorageBytes(const TensorValue & i_value)
+    {
+        switch(i_value.GetScalarType())
+        {
+            case ScalarType::Real: return i_value.GetStorageAs<Real>().size() * sizeof(Real);
+            case ScalarType::Integer: return i_value.GetStorageAs<Integer>().size() * sizeof(Integer);
+            case ScalarType::Bool: return i_value.GetStorageAs<Bool>().size() * sizeof(Bool);
+            case ScalarType::Real32: return i_value.GetStorageAs<Real32>().size() * sizeof(Real32);
+            case ScalarType::Integer32: return i_value.GetStorageAs<Integer32>().size() * sizeof(Integer32);
+            case ScalarType::Integer8: return i_value.GetStorageAs<Integer8>().size() * sizeof(Integer8);
+            default: Panic("GetStorageBytes: unsupported scalar type");
+        }
+    }
+
+    void DumpOperatorStatistics([[maybe_unused]] std::ostream & i_dest)
+    {
+        #if LIQUID_INSTRUMENTATION
+            for(const Operator * op : Book::Get().GetOperators())
+            {
+                const OperatorStatistics & statistics = op->GetStatistics();
+                if(statistics.m_invocations.Get() == 0)
+                    continue;
+
+                i_dest << op->GetName() << ": invocations " << statistics.m_invocations.Get()
+                    << ", constant propagations " << statistics.m_constant_propagations.Get()
+                    << ", canonicalize hits [";
+                for(size_t i = 0; i < statistics.m_canonicalize_hits.size(); i++)
+                    i_dest << (i != 0 ? ", " : "") << statistics.m_canonicalize_hits[i].Get();
+                i_dest << "], kernel time " << statistics.m_kernel_nanoseconds.Get() / 1000000.
+                    << " ms, kernel bytes " << statistics.m_kernel_bytes.Get() << std::endl;
+            }
+        #endif
+    }
+
+    void ResetOperatorStatistics()
+    {
+        #if LIQUID_INSTRUMENTATION
+            for(const Operator * op : Book::Get().GetOperators())
+                op->ResetStatistics();
+        #endif
+    }
+}
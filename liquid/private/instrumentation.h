@@ -0,0 +1,71 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#include "private_common.h"
+#include <atomic>
+#include <vector>
+#include <iosfwd>
+
+/* Instrumentation is opt-in: when LIQUID_INSTRUMENTATION is 0 (the default) the
+    statistics are not collected, and the counters are not compiled. */
+#ifndef LIQUID_INSTRUMENTATION
+    #define LIQUID_INSTRUMENTATION 0
+#endif
+
+#if LIQUID_INSTRUMENTATION
+    #define LIQUID_INSTRUMENT(...) __VA_ARGS__
+#else
+    #define LIQUID_INSTRUMENT(...)
+#endif
+
+namespace liquid
+{
+    class TensorValue;
+
+    // atomic counter that can be copied, like the operators that own it
+    class StatisticCounter
+    {
+    public:
+
+        StatisticCounter() = default;
+
+        StatisticCounter(const StatisticCounter & i_source)
+            : m_value(i_source.Get()) { }
+
+        StatisticCounter & operator = (const StatisticCounter & i_source)
+        {
+            m_value.store(i_source.Get(), std::memory_order_relaxed);
+            return *this;
+        }
+
+        void Add(uint64_t i_value) { m_value.fetch_add(i_value, std::memory_order_relaxed); }
+
+        uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+        void Reset() { m_value.store(0, std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> m_value{0};
+    };
+
+    struct OperatorStatistics
+    {
+        StatisticCounter m_invocations;
+        StatisticCounter m_constant_propagations;
+        std::vector<StatisticCounter> m_canonicalize_hits; // indexed like the canonicalize functions
+        StatisticCounter m_kernel_nanoseconds;
+        StatisticCounter m_kernel_bytes; // size of the values produced by the kernels
+    };
+
+    // size of the storage of a value, that may be smaller than its shape because of wrapping
+    uint64_t GetStorageBytes(const TensorValue & i_value);
+
+    /* Writes a line for every operator in the book that has been invoked since the
+        last reset. Writes nothing if instrumentation is disabled. */
+    void DumpOperatorStatistics(std::ostream & i_dest);
+
+    void ResetOperatorStatistics();
+}
@@ -6,6 +6,7 @@
 
 #include "private_common.h"
 #include "book.h"
+#include <atomic>
 #include <iostream>
 #ifdef _WIN32
     #include <Windows.h>
@@ -13,14 +14,16 @@
 
 namespace liquid
 {
-    struct PanicException : public std::exception
+    struct PanicException : public std::runtime_error
     {
-        using exception::exception;
+        using runtime_error::runtime_error;
     };
 
     namespace detail
     {
         thread_local int64_t g_silent_panic_count;
+        std::atomic<Precision> g_default_precision{ Precision::Exact };
+        thread_local std::optional<Precision> g_precision;
     }
 
     SilentPanicContext::SilentPanicContext()
@@ -35,6 +38,27 @@ namespace liquid
             Panic("Internak error: g_silent_panic_count is ", detail::g_silent_panic_count);
     }
 
+    void SetDefaultPrecision(Precision i_precision)
+    {
+        detail::g_default_precision = i_precision;
+    }
+
+    Precision GetPrecision()
+    {
+        return detail::g_precision.value_or(detail::g_default_precision.load());
+    }
+
+    PrecisionContext::PrecisionContext(Precision i_precision)
+        : m_previous(detail::g_precision)
+    {
+        detail::g_precision = i_precision;
+    }
+
+    PrecisionContext::~PrecisionContext()
+    {
+        detail::g_precision = m_previous;
+    }
+
     void Expects(const char * i_topic, const Tensor & i_bool_tensor, const char * i_cpp_source_code)
     {
         auto GetMessageHeader = [i_topic, i_cpp_source_code]{
@@ -157,6 +181,9 @@ namespace liquid
             case ScalarType::Real: i_ostream << "real"; break;
             case ScalarType::Integer: i_ostream << "int"; break;
             case ScalarType::Bool: i_ostream << "bool"; break;
+            case ScalarType::Real32: i_ostream << "real32"; break;
+            case ScalarType::Integer32: i_ostream << "int32"; break;
+            case ScalarType::Integer8: i_ostream << "int8"; break;
             default: Panic("Unrecognized scalar type ", static_cast<int>(i_scalar_type));
         }
         return i_ostream;
@@ -0,0 +1,72 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+
+namespace liquid
+{
+    /* Accumulates in io_dest the product of a [rows, inner] by b [inner, columns]. The inner
+        and the column dimensions are split in blocks, so that a block of b stays in cache while
+        it's multiplied by all the rows of a. Within a block, 4 rows are processed at once: every
+        element of b is loaded once for 4 multiply-adds, and the innermost loop is a contiguous
+        axpy that the compiler can vectorize. */
+    template <typename SCALAR_TYPE>
+        void MatMulKernel(const SCALAR_TYPE * i_a, const SCALAR_TYPE * i_b, SCALAR_TYPE * io_dest,
+            size_t i_rows, size_t i_inner, size_t i_columns)
+    {
+        constexpr size_t inner_block = 128;
+        constexpr size_t column_block = 256;
+        constexpr size_t row_tile = 4;
+
+        for(size_t inner_start = 0; inner_start < i_inner; inner_start += inner_block)
+        {
+            size_t const inner_end = std::min(inner_start + inner_block, i_inner);
+            for(size_t column_start = 0; column_start < i_columns; column_start += column_block)
+            {
+                size_t const column_count = std::min(column_block, i_columns - column_start);
+
+                size_t row = 0;
+                for(; row + row_tile <= i_rows; row += row_tile)
+                {
+                    SCALAR_TYPE * const dest0 = io_dest + (row + 0) * i_columns + column_start;
+                    SCALAR_TYPE * const dest1 = io_dest + (row + 1) * i_columns + column_start;
+                    SCALAR_TYPE * const dest2 = io_dest + (row + 2) * i_columns + column_start;
+                    SCALAR_TYPE * const dest3 = io_dest + (row + 3) * i_columns + column_start;
+                    for(size_t inner = inner_start; inner < inner_end; inner++)
+                    {
+                        SCALAR_TYPE const a0 = i_a[(row + 0) * i_inner + inner];
+                        SCALAR_TYPE const a1 = i_a[(row + 1) * i_inner + inner];
+                        SCALAR_TYPE const a2 = i_a[(row + 2) * i_inner + inner];
+                        SCALAR_TYPE const a3 = i_a[(row + 3) * i_inner + inner];
+                        const SCALAR_TYPE * const b = i_b + inner * i_columns + column_start;
+                        for(size_t column = 0; column < column_count; column++)
+                        {
+                            SCALAR_TYPE const b_element = b[column];
+                            dest0[column] += a0 * b_element;
+                            dest1[column] += a1 * b_element;
+                            dest2[column] += a2 * b_element;
+                            dest3[column] += a3 * b_element;
+                        }
+                    }
+                }
+
+                // remaining rows
+                for(; row < i_rows; row++)
+                {
+                    SCALAR_TYPE * const dest = io_dest + row * i_columns + column_start;
+                    for(size_t inner = inner_start; inner < inner_end; inner++)
+                    {
+                        SCALAR_TYPE const a = i_a[row * i_inner + inner];
+                        const SCALAR_TYPE * const b = i_b + inner * i_columns + column_start;
+                        for(size_t column = 0; column < column_count; column++)
+                            dest[column] += a * b[column];
+                    }
+                }
+            }
+        }
+    }
+}
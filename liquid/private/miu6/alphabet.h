@@ -17,7 +17,7 @@ namespace liquid
         enum class SymbolId
         {
             // scalar types
-            Any, Real, Bool, Integer,
+            Any, Real, Bool, Integer, Real32, Integer32, Integer8,
 
             // arithmetic unary operators
             UnaryPlus, UnaryMinus,
@@ -84,7 +84,10 @@ namespace liquid
 
             // scalar types
             { "any",        SymbolId::Any                                    },
+            { "real32",     SymbolId::Real32                                 },
             { "real",       SymbolId::Real                                   },
+            { "int32",      SymbolId::Integer32                              },
+            { "int8",       SymbolId::Integer8                               },
             { "int",        SymbolId::Integer                                },
             { "bool",       SymbolId::Bool                                   },
         
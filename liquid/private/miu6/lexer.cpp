@@ -5,9 +5,10 @@
 //          http://www.boost.org/LICENSE_1_0.txt)
 
 #include "miu6/lexer.h"
-#include <cctype>
 #include <cstdlib>
-#include <cinttypes>
+#include <charconv>
+#include <array>
+#include <algorithm>
 
 namespace liquid
 {
@@ -15,48 +16,129 @@ namespace liquid
     {
         namespace
         {
-            template <typename PREDICATE>
-                size_t CountIf(std::string_view i_source, const PREDICATE & i_predicate)
+            enum CharClass : uint8_t
             {
-                for(size_t i = 0; i < i_source.length(); i++)
-                    if(!i_predicate(i_source[i]))
-                        return i;
+                Space = 1 << 0,
+                Digit = 1 << 1,
+                Alpha = 1 << 2, // includes utf-8 code units
+                AlphaNum = Alpha | Digit
+            };
 
-                return i_source.length();
-            }
-
-            bool IsUtf8CodeUnit(char i_char)
+            constexpr std::array<uint8_t, 256> MakeCharClassTable()
             {
-                return static_cast<unsigned char>(i_char) >= 0x80;
+                std::array<uint8_t, 256> table = {};
+                for(size_t i = 0; i < table.size(); i++)
+                {
+                    if(i == ' ' || (i >= '\t' && i <= '\r'))
+                        table[i] = CharClass::Space;
+                    else if(i >= '0' && i <= '9')
+                        table[i] = CharClass::Digit;
+                    else if((i >= 'a' && i <= 'z') || (i >= 'A' && i <= 'Z') || i >= 0x80)
+                        table[i] = CharClass::Alpha;
+                }
+                return table;
             }
 
-            bool IsSpace(char i_char)
+            constexpr std::array<uint8_t, 256> g_char_classes = MakeCharClassTable();
+
+            bool IsOfClass(char i_char, uint8_t i_classes)
             {
-                return !IsUtf8CodeUnit(i_char) && std::isspace(i_char);
+                return (g_char_classes[static_cast<unsigned char>(i_char)] & i_classes) != 0;
             }
 
-            bool IsDigit(char i_char)
+            size_t CountOfClass(std::string_view i_source, uint8_t i_classes)
             {
-                return !IsUtf8CodeUnit(i_char) && std::isdigit(i_char);
+                size_t i = 0;
+                while(i < i_source.length() && IsOfClass(i_source[i], i_classes))
+                    i++;
+                return i;
             }
 
-            bool IsAlpha(char i_char)
+            /* Trie of the chars of the symbols in the alphabet. Match finds in a 
+                single pass all the symbols that are a prefix of the source. */
+            class SymbolTrie
             {
-                return IsUtf8CodeUnit(i_char) || std::isalpha(i_char);
-            }
+            public:
+
+                constexpr static size_t s_max_candidates = 8;
+
+                struct Candidates
+                {
+                    std::array<const Symbol *, s_max_candidates> m_symbols;
+                    size_t m_count = 0;
+                };
+
+                SymbolTrie()
+                {
+                    m_nodes.emplace_back();
+                    for(const Symbol & symbol : g_alphabet)
+                    {
+                        size_t node_index = 0, depth_candidates = 0;
+                        for(char c : symbol.m_chars)
+                        {
+                            auto const ascii = static_cast<unsigned char>(c);
+                            if(ascii >= s_child_count)
+                                Panic("SymbolTrie - non-ascii symbol: ", symbol.m_chars);
+                            depth_candidates += m_nodes[node_index].m_symbols.size();
+                            if(m_nodes[node_index].m_children[ascii] == 0)
+                            {
+                                m_nodes[node_index].m_children[ascii] = NumericCast<uint16_t>(m_nodes.size());
+                                m_nodes.emplace_back();
+                            }
+                            node_index = m_nodes[node_index].m_children[ascii];
+                        }
+                        m_nodes[node_index].m_symbols.push_back(&symbol);
+                        if(depth_candidates + m_nodes[node_index].m_symbols.size() > s_max_candidates)
+                            Panic("SymbolTrie - too many overlapping symbols");
+                    }
+                }
+
+                /* The candidates are returned in the order they appear in the alphabet,
+                    that is the order in which the lexer must try them. */
+                Candidates Match(std::string_view i_source) const
+                {
+                    Candidates result;
+                    size_t node_index = 0;
+                    for(char c : i_source)
+                    {
+                        auto const ascii = static_cast<unsigned char>(c);
+                        if(ascii >= s_child_count)
+                            break;
+                        node_index = m_nodes[node_index].m_children[ascii];
+                        if(node_index == 0)
+                            break;
+                        for(const Symbol * symbol : m_nodes[node_index].m_symbols)
+                            result.m_symbols[result.m_count++] = symbol;
+                    }
+                    std::sort(result.m_symbols.begin(), result.m_symbols.begin() + result.m_count);
+                    return result;
+                }
 
-            bool IsAlphaNum(char i_char)
+            private:
+
+                constexpr static size_t s_child_count = 128;
+
+                struct Node
+                {
+                    std::array<uint16_t, s_child_count> m_children = {}; // 0 is the root, so it means 'no child'
+                    std::vector<const Symbol *> m_symbols;
+                };
+
+                std::vector<Node> m_nodes;
+            };
+
+            const SymbolTrie & GetSymbolTrie()
             {
-                return IsUtf8CodeUnit(i_char) || std::isalnum(i_char);
+                static const SymbolTrie trie;
+                return trie;
             }
         }
 
         std::string_view Lexer::TryParseSpaces(std::string_view & io_source)
         {
-            const char * beginning = io_source.data();
-            while(!io_source.empty() && IsSpace(io_source[0]))
-                io_source = io_source.substr(1);
-            return std::string_view(beginning, io_source.data() - beginning);
+            auto const spaces = io_source.substr(0, CountOfClass(io_source, CharClass::Space));
+            io_source.remove_prefix(spaces.length());
+            return spaces;
         }
 
         /* returns true if two sequences of spaces are simmetrical, that is 
@@ -89,7 +171,7 @@ namespace liquid
         {
             if (StartsWith(io_source, i_what))
             {
-                io_source = io_source.substr(i_what.length());
+                io_source.remove_prefix(i_what.length());
                 return true;
             }
 
@@ -98,29 +180,43 @@ namespace liquid
 
         std::optional<Real> Lexer::TryParseReal(std::string_view & io_source)
         {
-            static_assert(std::is_same_v<Real, double>, "std::strtod works with doubles");
-            char * end_ptr = nullptr;
-            auto const value = std::strtod(io_source.data(), &end_ptr);
-            if(end_ptr == io_source.data())
+            if(io_source.empty() || !(IsOfClass(io_source[0], CharClass::Digit) || io_source[0] == '.'))
+                return {};
+
+            const char * const end = io_source.data() + io_source.length();
+            Real value = 0;
+            auto const result = std::from_chars(io_source.data(), end, value);
+            if(result.ec == std::errc::invalid_argument)
                 return {};
-        
-            io_source = io_source.substr(end_ptr - io_source.data());
+
+            if(result.ec == std::errc::result_out_of_range)
+            {
+                // let strtod choose between infinity and zero
+                static_assert(std::is_same_v<Real, double>, "std::strtod works with doubles");
+                value = std::strtod(std::string(io_source.data(), result.ptr).c_str(), nullptr);
+            }
+
+            io_source.remove_prefix(result.ptr - io_source.data());
             return value;
         }
 
         std::optional<Integer> Lexer::TryParseInteger(std::string_view & io_source)
         {
-            size_t const digits = CountIf(io_source, IsDigit);
+            size_t const digits = CountOfClass(io_source, CharClass::Digit);
             if(digits == 0)
                 return {};
 
             if(digits < io_source.length() &&
-                (io_source[digits] == '.' || isalpha(io_source[digits])))
+                (io_source[digits] == '.' || IsOfClass(io_source[digits], CharClass::Alpha)))
                     return {};
 
-            auto const value = std::strtoimax(std::string(io_source.substr(0, digits)).c_str(), nullptr, 10);
-            io_source = io_source.substr(digits);
-            return NumericCast<Integer>(value);
+            Integer value = 0;
+            auto const result = std::from_chars(io_source.data(), io_source.data() + digits, value);
+            if(result.ec != std::errc())
+                return {}; // out of range, parsed as real
+
+            io_source.remove_prefix(digits);
+            return value;
         }
 
         std::optional<Bool> Lexer::TryParseBool(std::string_view & io_source)
@@ -135,15 +231,12 @@ namespace liquid
 
         std::optional<std::string_view> Lexer::TryParseName(std::string_view & io_source)
         {
-            size_t const length = CountIf(io_source, IsAlphaNum);
-            if(length > 0 && IsAlpha(io_source[0]))
-            {
-                auto const name = io_source.substr(0, length);
-                io_source = io_source.substr(length);
-                return name;
-            }
-            else
+            if(io_source.empty() || !IsOfClass(io_source[0], CharClass::Alpha))
                 return {};
+
+            auto const name = io_source.substr(0, CountOfClass(io_source, CharClass::AlphaNum));
+            io_source.remove_prefix(name.length());
+            return name;
         }
 
         Token Lexer::TryParseToken(std::string_view & io_source)
@@ -158,27 +251,26 @@ namespace liquid
 
         Token Lexer::TryParseTokenImpl(std::string_view i_prefix_spaces, std::string_view & io_source)
         {
-            for(const Symbol & symbol : g_alphabet)
+            auto const candidates = GetSymbolTrie().Match(io_source);
+            for(size_t i = 0; i < candidates.m_count; i++)
             {
+                const Symbol & symbol = *candidates.m_symbols[i];
                 if(symbol.IsBinaryOperator())
                 {
                     // binary operator - enforce white space symmetry
-                    auto new_source = io_source;
-                    if(TryParseString(new_source, symbol.m_chars))
+                    auto new_source = io_source.substr(symbol.m_chars.length());
+                    std::string_view postfix_spaces = TryParseSpaces(new_source);
+                    if(WhiteSimmetry(i_prefix_spaces, postfix_spaces))
                     {
-                        std::string_view postfix_spaces = TryParseSpaces(new_source);
-                        if(WhiteSimmetry(i_prefix_spaces, postfix_spaces))
-                        {
-                            io_source = new_source;
-                            return { symbol };
-                        }
-                    }                    
+                        io_source = new_source;
+                        return { symbol };
+                    }
                 }
                 else
                 {
                     // non-binary operator
-                    if(TryParseString(io_source, symbol.m_chars))
-                        return { symbol };
+                    io_source.remove_prefix(symbol.m_chars.length());
+                    return { symbol };
                 }
             }
 
@@ -204,8 +296,17 @@ namespace liquid
         }
 
         Lexer::Lexer(std::string_view i_source)
-            : m_whole_source(i_source), m_remaining_source(i_source)
+            : m_remaining_source(i_source), m_whole_source(i_source)
+        {
+            m_curr_token = TryParseToken(m_remaining_source);
+        }
+
+        Lexer::Lexer(std::string_view i_source, std::string_view i_whole_source)
+            : m_remaining_source(i_source), m_whole_source(i_whole_source)
         {
+            if(i_source.data() < i_whole_source.data() || 
+                    i_source.data() + i_source.size() > i_whole_source.data() + i_whole_source.size())
+                Panic("Lexer - the source is not a range of the whole source");
             m_curr_token = TryParseToken(m_remaining_source);
         }
 
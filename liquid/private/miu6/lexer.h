@@ -45,6 +45,10 @@ namespace liquid
 
             Lexer(std::string_view i_source);
 
+            /* i_source must be a range of i_whole_source. Locations in error
+                messages are relative to the whole source. */
+            Lexer(std::string_view i_source, std::string_view i_whole_source);
+
             const Token & GetCurrentToken() const { return m_curr_token; }
 
             bool IsCurrentToken(SymbolId i_symbol_id) const
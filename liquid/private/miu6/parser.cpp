@@ -9,6 +9,9 @@
 #include "miu6/alphabet.h"
 #include "tensor_type.h"
 #include "expression.h"
+#include <future>
+#include <thread>
+#include <algorithm>
 
 namespace liquid
 {
@@ -21,12 +24,15 @@ namespace liquid
 
         public:
 
-        // tries to parse real|int|bool|any
+        // tries to parse real|int|bool|real32|int32|int8|any
         static std::optional<ScalarType> TryParseScalarType(Lexer & i_lexer)
         {
             if(i_lexer.TryAccept(SymbolId::Real))           return ScalarType::Real;
             else if(i_lexer.TryAccept(SymbolId::Integer))   return ScalarType::Integer;
             else if(i_lexer.TryAccept(SymbolId::Bool))      return ScalarType::Bool;
+            else if(i_lexer.TryAccept(SymbolId::Real32))    return ScalarType::Real32;
+            else if(i_lexer.TryAccept(SymbolId::Integer32)) return ScalarType::Integer32;
+            else if(i_lexer.TryAccept(SymbolId::Integer8))  return ScalarType::Integer8;
             else if(i_lexer.TryAccept(SymbolId::Any))       return ScalarType::Any;
             else return {};
         }
@@ -253,32 +259,123 @@ namespace liquid
 
         }; // class Parser
 
-        Tensor ParseExpression(std::string_view i_source, const std::shared_ptr<const Scope> & i_scope)
+        namespace
         {
-            Lexer lexer(i_source);
-            try
+            Tensor ParseExpression(std::string_view i_source, std::string_view i_whole_source,
+                const std::shared_ptr<const Scope> & i_scope)
             {
-                /* prevent panic to break or log, we do it in the catch block showing
-                    the current location in the source code */
-                SilentPanicContext silent_panic;
+                Lexer lexer(i_source, i_whole_source);
+                try
+                {
+                    /* prevent panic to break or log, we do it in the catch block showing
+                        the current location in the source code */
+                    SilentPanicContext silent_panic;
                 
-                Tensor const result = Parser::ParseExpression(lexer, i_scope->MakeInner(), 0);
+                    Tensor const result = Parser::ParseExpression(lexer, i_scope->MakeInner(), 0);
 
-                // all the source must be consumed
-                if(!lexer.IsSourceOver())
-                    Panic("expected end of source, ", 
-                        GetSymbolChars(lexer.GetCurrentToken().m_symbol_id), " found");
+                    // all the source must be consumed
+                    if(!lexer.IsSourceOver())
+                        Panic("expected end of source, ", 
+                            GetSymbolChars(lexer.GetCurrentToken().m_symbol_id), " found");
 
-                return result;
+                    return result;
+                }
+                catch(const std::exception & i_exc)
+                {
+                    Panic(lexer, i_exc.what());
+                }
+                catch(...)
+                {
+                    Panic(lexer, "unspecified error");
+                }
             }
-            catch(const std::exception & i_exc)
+
+            /* Splits the source at the commas that are not enclosed by brackets. The
+                last expression is discarded if blank, so that a trailing comma is allowed. */
+            std::vector<std::string_view> SplitTopLevelExpressions(std::string_view i_source)
             {
-                Panic(lexer, i_exc.what());
+                std::vector<std::string_view> result;
+                const char * expression_begin = i_source.data();
+                int64_t nesting = 0;
+                for(Lexer lexer(i_source); !lexer.IsSourceOver(); lexer.Advance())
+                {
+                    const Token & token = lexer.GetCurrentToken();
+                    switch(token.m_symbol_id)
+                    {
+                    case SymbolId::LeftParenthesis:
+                    case SymbolId::LeftBracket:
+                    case SymbolId::LeftBrace:
+                        nesting++;
+                        break;
+
+                    case SymbolId::RightParenthesis:
+                    case SymbolId::RightBracket:
+                    case SymbolId::RightBrace:
+                        nesting--;
+                        break;
+
+                    case SymbolId::Comma:
+                        if(nesting == 0)
+                        {
+                            const char * const comma = token.m_source_chars.data();
+                            result.emplace_back(expression_begin, comma - expression_begin);
+                            expression_begin = comma + token.m_source_chars.length();
+                        }
+                        break;
+
+                    default:
+                        break;
+                    }
+
+                    // the parser will report the error
+                    if(token.m_symbol_id == SymbolId::Unrecognized)
+                        break;
+                }
+
+                std::string_view const last(expression_begin, 
+                    i_source.data() + i_source.length() - expression_begin);
+                if(last.find_first_not_of(" \t\n\v\f\r") != std::string_view::npos || result.empty())
+                    result.push_back(last);
+                return result;
             }
-            catch(...)
+        }
+
+        Tensor ParseExpression(std::string_view i_source, const std::shared_ptr<const Scope> & i_scope)
+        {
+            return ParseExpression(i_source, i_source, i_scope);
+        }
+
+        std::vector<Tensor> ParseExpressions(std::string_view i_source,
+            const std::shared_ptr<const Scope> & i_scope, bool i_parallel)
+        {
+            std::vector<std::string_view> const sources = SplitTopLevelExpressions(i_source);
+            std::vector<std::optional<Tensor>> expressions(sources.size());
+
+            auto const parse_range = [&](size_t i_begin, size_t i_end){
+                for(size_t i = i_begin; i < i_end; i++)
+                    expressions[i] = ParseExpression(sources[i], i_source, i_scope);
+            };
+
+            size_t const task_count = i_parallel ? std::clamp<size_t>(
+                std::thread::hardware_concurrency(), 1, sources.size()) : 1;
+            size_t const expressions_per_task = (sources.size() + task_count - 1) / task_count;
+
+            /* the first range is parsed on this thread. Tasks are joined in order,
+                so the first error in the source is the one propagated. */
+            std::vector<std::future<void>> tasks;
+            tasks.reserve(task_count);
+            for(size_t task = 1; task < task_count; task++)
             {
-                Panic(lexer, "unspecified error");
+                size_t const begin = std::min(task * expressions_per_task, sources.size());
+                size_t const end = std::min(begin + expressions_per_task, sources.size());
+                tasks.push_back(std::async(std::launch::async, parse_range, begin, end));
             }
+            parse_range(0, std::min(expressions_per_task, sources.size()));
+            for(auto & task : tasks)
+                task.get();
+
+            return Transform(expressions, [](const std::optional<Tensor> & i_expression){
+                return *i_expression; });
         }
         
         /*std::shared_ptr<const Scope> ParseScope(std::string_view i_source, const std::shared_ptr<const Scope> & i_scope)
@@ -15,6 +15,15 @@ namespace liquid
     {
         Tensor ParseExpression(std::string_view i_source, 
             const std::shared_ptr<const Scope> & i_scope = Scope::Root());
+
+        /* Parses a comma-separated list of independent top-level expressions. Every
+            expression is parsed in its own inner scope of i_scope, so declarations
+            are not shared between expressions. If i_parallel is true the expressions
+            are parsed concurrently. If more expressions are ill-formed, the error
+            about the first one in the source is reported. */
+        std::vector<Tensor> ParseExpressions(std::string_view i_source,
+            const std::shared_ptr<const Scope> & i_scope = Scope::Root(),
+            bool i_parallel = true);
     }
 
 } // namespace liquid
@@ -7,13 +7,14 @@
 #include "operator.h"
 #include "expression.h"
 #include <algorithm>
+#include <chrono>
 
 namespace liquid
 {
     extern const Operator & GetOperatorConstant();
 
     Operator::Operator(std::string_view i_name)
-        : m_name(i_name), m_deduce_type_func(DefaultDeduceType)
+        : m_name(i_name), m_deduce_type_func(DefaultDeduceType), m_cost_func(DefaultCost)
     {
 
     }
@@ -33,9 +34,38 @@ namespace liquid
         return *this;
     }
 
+    Operator & Operator::SetShapeConstraints(ShapeConstraintsFunction i_func)
+    {
+        if(i_func == nullptr)
+            Panic("Operator::SetShapeConstraints - null function");
+        m_shape_constraints_func = i_func;
+        return *this;
+    }
+
+    std::vector<Tensor> Operator::GetShapeConstraints(const std::any & i_attachment,
+        Span<const Tensor> i_operands) const
+    {
+        if(m_shape_constraints_func != nullptr)
+            return m_shape_constraints_func(i_attachment, i_operands);
+        if(m_deduce_type_func == DefaultDeduceType)
+            return BroadcastConstraints(i_attachment, i_operands);
+        return {};
+    }
+
+    std::vector<Tensor> Operator::BroadcastConstraints([[maybe_unused]] const std::any & i_attachment,
+        Span<const Tensor> i_operands)
+    {
+        std::vector<TensorType> const types = Transform(i_operands,
+            [](const Tensor & i_operand){ return i_operand.GetExpression()->GetType(); });
+        std::vector<Tensor> constraints;
+        BroadcastShapes(types, &constraints);
+        return constraints;
+    }
+
     Operator & Operator::AddCanonicalize(CanonicalizeFunction i_func)
     {
         m_canonicalize_funcs.push_back(i_func);
+        LIQUID_INSTRUMENT(m_statistics.m_canonicalize_hits.emplace_back();)
         return *this;
     }
 
@@ -88,6 +118,61 @@ namespace liquid
         return *this;
     }
 
+    Tensor Operator::GetGradientOfOperand(const Tensor & i_self, 
+        const Tensor & i_self_gradient, size_t i_operand_index) const
+    {
+        if(m_gradient_of_input_func == nullptr)
+            Panic(m_name, ": the gradient is not defined");
+        return m_gradient_of_input_func(i_self, i_self_gradient, i_operand_index);
+    }
+
+    Operator & Operator::SetCost(CostFunction i_func)
+    {
+        if(i_func == nullptr)
+            Panic("Operator::SetCost - null function");
+        m_cost_func = i_func;
+        return *this;
+    }
+
+    int64_t Operator::GetElementCount(const TensorType & i_type)
+    {
+        return i_type.HasFixedShape() ? i_type.GetFixedShape().GetLinearSize() : 1;
+    }
+
+    int64_t Operator::GetByteSize(const TensorType & i_type)
+    {
+        switch(i_type.GetScalarType())
+        {
+            case ScalarType::Integer: return GetElementCount(i_type) * NumericCast<int64_t>(sizeof(Integer));
+            case ScalarType::Bool: return GetElementCount(i_type) * NumericCast<int64_t>(sizeof(Bool));
+            case ScalarType::Real32: return GetElementCount(i_type) * NumericCast<int64_t>(sizeof(Real32));
+            case ScalarType::Integer32: return GetElementCount(i_type) * NumericCast<int64_t>(sizeof(Integer32));
+            case ScalarType::Integer8: return GetElementCount(i_type) * NumericCast<int64_t>(sizeof(Integer8));
+            default: return GetElementCount(i_type) * NumericCast<int64_t>(sizeof(Real));
+        }
+    }
+
+    Operator::Cost Operator::ZeroFlopsCost([[maybe_unused]] const std::any & i_attachment,
+        const TensorType & i_result_type,
+        [[maybe_unused]] Span<const Tensor> i_operands)
+    {
+        return { 0, GetByteSize(i_result_type) };
+    }
+
+    Operator::Cost Operator::ViewCost([[maybe_unused]] const std::any & i_attachment,
+        [[maybe_unused]] const TensorType & i_result_type,
+        [[maybe_unused]] Span<const Tensor> i_operands)
+    {
+        return { 0, 0 };
+    }
+
+    Operator::Cost Operator::DefaultCost([[maybe_unused]] const std::any & i_attachment,
+        const TensorType & i_result_type, Span<const Tensor> i_operands)
+    {
+        int64_t const flops_per_element = std::max<int64_t>(1, NumericCast<int64_t>(i_operands.size()) - 1);
+        return { GetElementCount(i_result_type) * flops_per_element, GetByteSize(i_result_type) };
+    }
+
     TensorType Operator::DefaultDeduceType(
         [[maybe_unused]] const std::any & i_attachment,
         Span<const Tensor> i_operands)
@@ -99,9 +184,20 @@ namespace liquid
         return DeduceType(types);
     }
 
+    /* The cost of a numeric promotion is the distance of the ranks, but converting an integer
+        to a floating point type costs as converting it to Real: integers become Real, unless
+        the overload is chosen by a Real32 operand. */
+    int GetPromotionCost(ScalarType i_argument, ScalarType i_parameter)
+    {
+        int const parameter_rank = GetNumericRank(i_parameter) >= GetNumericRank(ScalarType::Real32) &&
+            GetNumericRank(i_argument) < GetNumericRank(ScalarType::Real32) ?
+                GetNumericRank(ScalarType::Real) : GetNumericRank(i_parameter);
+        return parameter_rank - GetNumericRank(i_argument);
+    }
+
     bool Operator::OverloadMatch(const Operator::Overload & i_overload, 
         Span<const Tensor> i_operands, OverloadMatchFlags i_flags,
-        std::vector<Tensor> & o_arguments)
+        std::vector<Tensor> & o_arguments, int * o_promotion_cost)
     {
         auto & parameters = i_overload.m_parameters;
         size_t const variadic_parameters = i_overload.m_variadic_parameters_count;
@@ -117,18 +213,23 @@ namespace liquid
         size_t variadic_repetitions = 0;
         if (i_overload.m_variadic_parameters_count > 0)
         {
+            if(i_operands.size() < non_variadic_parameters)
+                return false;
             size_t const variadic_arguments = i_operands.size() - non_variadic_parameters;
             variadic_repetitions = variadic_arguments / variadic_parameters;
             if((variadic_arguments % variadic_parameters) != 0)
                 return false;
         }
+        else if(i_operands.size() != parameters.size())
+            return false;
 
         // check operands types
         size_t parameter_index = 0;
         size_t variadic_repetition_index = 0;
         for (size_t operand_index = 0; operand_index < i_operands.size(); operand_index++)
         {
-            if(parameter_index >= variadic_parameters)
+            // after a complete pack the variadic parameters are repeated
+            if(parameter_index == variadic_parameters && variadic_repetition_index < variadic_repetitions)
             {
                 variadic_repetition_index++;
                 parameter_index = 0;
@@ -143,17 +244,22 @@ namespace liquid
             auto const & argument_type = i_operands[operand_index].GetExpression()->GetType();
             if (!parameters[parameter_index].m_type.IsSupercaseOf(argument_type))
             {
-                // mismatching types
+                // mismatching types, a numeric type can be promoted to a type with higher rank
+                ScalarType const parameter_scalar_type = parameters[parameter_index].m_type.GetScalarType();
+                int const promotion_distance = GetNumericRank(parameter_scalar_type) -
+                    GetNumericRank(argument_type.GetScalarType());
                 bool const promotion_feasible =
                     HasFlags(i_flags, OverloadMatchFlags::AllowNumericPromotion) &&
-                    parameters[parameter_index].m_type.GetScalarType() == ScalarType::Real &&
-                    argument_type.GetScalarType() == ScalarType::Integer;
+                    IsNumeric(argument_type.GetScalarType()) && promotion_distance > 0;
 
                 if(!promotion_feasible)
                     return false;
 
+                if(o_promotion_cost != nullptr)
+                    *o_promotion_cost += GetPromotionCost(argument_type.GetScalarType(), parameter_scalar_type);
+
                 if(HasFlags(i_flags, OverloadMatchFlags::ProcessArguments))
-                    o_arguments[operand_index] = Cast<Real>(o_arguments[operand_index]);
+                    o_arguments[operand_index] = Cast(parameter_scalar_type, o_arguments[operand_index]);
             }
 
             parameter_index++;
@@ -179,9 +285,21 @@ namespace liquid
                 OverloadMatchFlags::None, o_arguments))
             return *overload;
 
-        if (const Overload* overload = TryFindOverload(i_operands,
-                OverloadMatchFlags::AllowNumericPromotion, o_arguments))
-            return *overload;
+        // with numeric promotion, the overload that promotes the operands the least is chosen
+        const Overload * best_overload = nullptr;
+        int best_cost = 0;
+        for (const Overload & overload : m_overloads)
+        {
+            int cost = 0;
+            if(OverloadMatch(overload, i_operands, OverloadMatchFlags::AllowNumericPromotion, o_arguments, &cost) &&
+                    (best_overload == nullptr || cost < best_cost))
+            {
+                best_overload = &overload;
+                best_cost = cost;
+            }
+        }
+        if(best_overload != nullptr)
+            return *best_overload;
 
         Panic(m_name, ": could not find an overload matching the argument types: ",
             Span(Transform(i_operands, [](auto & i_op){ return i_op.GetExpression()->GetType(); } )) );
@@ -221,12 +339,21 @@ namespace liquid
     TensorValue Operator::Evaluate(const Overload & i_overload, const TensorType & i_result_type,
             Span<const Tensor> i_operands, const std::any & i_attachment) const
     {
-        if (auto const func = std::get_if<EvaluateFromVariablesFunction>(&i_overload.m_evaluate))
-        {
-            return (*func)(i_attachment, i_result_type, i_operands);
-        }
+        LIQUID_INSTRUMENT(auto const start_time = std::chrono::steady_clock::now();)
+
+        auto const from_variables = std::get_if<EvaluateFromVariablesFunction>(&i_overload.m_evaluate);
+        TensorValue result = from_variables ?
+            (*from_variables)(i_attachment, i_result_type, i_operands) :
+            Evaluate(i_overload, i_result_type, ToValues(i_operands), i_attachment);
 
-        return Evaluate(i_overload, i_result_type, ToValues(i_operands), i_attachment);
+        LIQUID_INSTRUMENT(
+            auto const elapsed = std::chrono::steady_clock::now() - start_time;
+            m_statistics.m_kernel_nanoseconds.Add(NumericCast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            m_statistics.m_kernel_bytes.Add(GetStorageBytes(result));
+        )
+
+        return result;
     }
 
     TensorValue Operator::Evaluate(const Overload & i_overload, const TensorType & i_result_type,
@@ -257,6 +384,7 @@ namespace liquid
     {
         if (IsEligibleForPropagation(i_attachment, i_operands))
         {
+            LIQUID_INSTRUMENT(m_statistics.m_constant_propagations.Add(1);)
             return MakeConstant(Evaluate(i_overload, i_result_type, 
                 i_operands, i_attachment));
         }
@@ -341,11 +469,14 @@ namespace liquid
             CA_SortOperands(i_operands);
         }
 
-        for(const auto & func : m_canonicalize_funcs)
+        for(size_t func_index = 0; func_index < m_canonicalize_funcs.size(); func_index++)
         {
-            if(auto const func_ptr = std::get_if<AdjustCanonicalizeFunction>(&func))
+            if(auto const func_ptr = std::get_if<AdjustCanonicalizeFunction>(&m_canonicalize_funcs[func_index]))
                 if((**func_ptr)(i_operands))
+                {
+                    LIQUID_INSTRUMENT(m_statistics.m_canonicalize_hits[func_index].Add(1);)
                     return true;
+                }
         }
 
         return false;
@@ -354,6 +485,8 @@ namespace liquid
     Tensor Operator::Invoke(std::string_view i_name, std::string_view i_doc,
         Span<const Tensor> i_operands, const std::any & i_attachment) const
     {
+        LIQUID_INSTRUMENT(m_statistics.m_invocations.Add(1);)
+
         std::vector<Tensor> operands;
         const Overload & overload = FindOverload(i_operands, operands);
         OverloadMatch(overload, i_operands, 
@@ -367,15 +500,24 @@ namespace liquid
         for(;;)
         {
             if(AdjustCanonicalize(operands, i_attachment))
+            {
+                /* dropping operands may leave only constants. The type deduced from all the
+                    operands is kept, so that dropped operands still broadcast the result, but
+                    if it doesn't have a fixed shape it's deduced again. Regular n-ary operators
+                    reduce to their only operand anyway. */
+                if(!IsRegularNAry() && IsEligibleForPropagation(i_attachment, operands))
+                    return *TryConstantPropagation(overload, type.HasFixedShape() ? type :
+                        m_deduce_type_func(i_attachment, operands), operands, i_attachment);
                 continue;
+            }
 
             if(Has(Flags::Commutative | Flags::Associative) && i_operands.empty() && m_identity_value)
-                return MakeConstant(*m_identity_value);
+                return LiteralOfType(MakeConstant(*m_identity_value), type.GetScalarType());
 
             if(IsRegularNAry())
             {
                 if(operands.size() == 0)
-                    return MakeConstant(*m_identity_value);
+                    return LiteralOfType(MakeConstant(*m_identity_value), type.GetScalarType());
                 if(operands.size() == 1)
                     return operands[0];
             }
@@ -385,17 +527,32 @@ namespace liquid
                 operands, i_attachment ));
 
             /* to do: this kind of canonicalizations are recursive, make it iterative */
-            for(const auto & func : m_canonicalize_funcs)
+            for(size_t func_index = 0; func_index < m_canonicalize_funcs.size(); func_index++)
             {
-                if(auto const func_ptr = std::get_if<ReplaceCanonicalizeFunction>(&func))
+                if(auto const func_ptr = std::get_if<ReplaceCanonicalizeFunction>(&m_canonicalize_funcs[func_index]))
                     if(auto new_expr = (**func_ptr)(result))
+                    {
+                        LIQUID_INSTRUMENT(m_statistics.m_canonicalize_hits[func_index].Add(1);)
                         return *new_expr;
+                    }
             }
 
             return result;
         }
     }
 
+    #if LIQUID_INSTRUMENTATION
+        void Operator::ResetStatistics() const
+        {
+            m_statistics.m_invocations.Reset();
+            m_statistics.m_constant_propagations.Reset();
+            for(StatisticCounter & hits : m_statistics.m_canonicalize_hits)
+                hits.Reset();
+            m_statistics.m_kernel_nanoseconds.Reset();
+            m_statistics.m_kernel_bytes.Reset();
+        }
+    #endif
+
     Operator & Operator::SetAttachmentComparer(AttachmentComparer i_attachment_comparer)
     {
         m_attachment_comparer = i_attachment_comparer;
@@ -429,6 +586,44 @@ namespace liquid
         m_attachment_hasher(i_dest, i_attachment);
     }
 
+    Operator & Operator::SetAttachmentSerializer(AttachmentWriter i_attachment_writer,
+        AttachmentReader i_attachment_reader)
+    {
+        m_attachment_writer = i_attachment_writer;
+        m_attachment_reader = i_attachment_reader;
+        return *this;
+    }
+
+    void Operator::WriteAttachment(BinaryWriter & i_dest, const std::any & i_attachment) const
+    {
+        if(m_attachment_writer == nullptr)
+            Panic("Operator ", m_name, ": attachment writer not set" );
+        m_attachment_writer(i_dest, i_attachment);
+    }
+
+    std::any Operator::ReadAttachment(BinaryReader & i_source) const
+    {
+        if(m_attachment_reader == nullptr)
+            Panic("Operator ", m_name, ": attachment reader not set" );
+        return m_attachment_reader(i_source);
+    }
+
+    size_t Operator::GetOverloadIndex(const Overload & i_overload) const
+    {
+        for(size_t overload_index = 0; overload_index < m_overloads.size(); overload_index++)
+            if(&m_overloads[overload_index] == &i_overload)
+                return overload_index;
+
+        Panic("Operator ", m_name, ": the overload does not belong to this operator");
+    }
+
+    const Operator::Overload & Operator::GetOverload(size_t i_overload_index) const
+    {
+        if(i_overload_index >= m_overloads.size())
+            Panic("Operator ", m_name, ": overload index ", i_overload_index, " out of range");
+        return m_overloads[i_overload_index];
+    }
+
     Hash & operator << (Hash & i_dest, const Operator & i_source)
     {
         i_dest << i_source.m_name;
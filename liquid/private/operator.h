@@ -9,6 +9,8 @@
 #include "tensor_value.h"
 #include "tensor_type.h"
 #include "hash.h"
+#include "serialization.h"
+#include "instrumentation.h"
 #include <optional>
 #include <any>
 #include <variant>
@@ -75,6 +77,22 @@ namespace liquid
             Span<const Tensor> i_operands);
 
         Operator & SetDeduceType(DeduceTypeFunction i_func);
+
+        /* Symbolic shapes may be compatible only for some values of the dimension variables,
+            see BroadcastShapes. This returns the bool scalars that must be true for the
+            operands to be compatible, so that they can be checked before evaluating the graph.
+            The operands of operators without a custom type deduction are broadcast. */
+        using ShapeConstraintsFunction = std::vector<Tensor>(*)(const std::any & i_attachment,
+            Span<const Tensor> i_operands);
+
+        Operator & SetShapeConstraints(ShapeConstraintsFunction i_func);
+
+        std::vector<Tensor> GetShapeConstraints(const std::any & i_attachment,
+            Span<const Tensor> i_operands) const;
+
+        // constraints of operators that broadcast all their operands
+        static std::vector<Tensor> BroadcastConstraints(const std::any & i_attachment,
+            Span<const Tensor> i_operands);
         
 
                 // evaluation
@@ -150,6 +168,50 @@ namespace liquid
 
         Operator & SetGradientOfOperand(GradientOfOperandFunction i_func);
 
+        Tensor GetGradientOfOperand(const Tensor & i_self, const Tensor & i_self_gradient, size_t i_operand_index) const;
+
+
+            // cost
+
+        struct Cost
+        {
+            int64_t m_flops = 0;
+            int64_t m_bytes = 0; // size of the result
+        };
+
+        /* Estimates the cost of evaluating an expression with this operator, excluding
+            the cost of the operands. The default cost is one flop per element for every operand after the first. */
+        using CostFunction = Cost(*)(const std::any & i_attachment,
+            const TensorType & i_result_type, Span<const Tensor> i_operands);
+
+        Operator & SetCost(CostFunction i_func);
+
+        Cost GetCost(const std::any & i_attachment, const TensorType & i_result_type,
+                Span<const Tensor> i_operands) const
+            { return m_cost_func(i_attachment, i_result_type, i_operands); }
+
+        // cost of operators with the same flops for every element, like transcendental functions
+        template <int64_t FLOPS_PER_ELEMENT>
+            static Cost ElementwiseCost([[maybe_unused]] const std::any & i_attachment,
+                const TensorType & i_result_type,
+                [[maybe_unused]] Span<const Tensor> i_operands)
+        {
+            return { GetElementCount(i_result_type) * FLOPS_PER_ELEMENT, GetByteSize(i_result_type) };
+        }
+
+        // cost of operators that only produce or copy data
+        static Cost ZeroFlopsCost(const std::any & i_attachment,
+            const TensorType & i_result_type, Span<const Tensor> i_operands);
+
+        // cost of operators that return a view of the storage of an operand
+        static Cost ViewCost(const std::any & i_attachment,
+            const TensorType & i_result_type, Span<const Tensor> i_operands);
+
+        // tensors without a fixed shape are estimated as scalars
+        static int64_t GetElementCount(const TensorType & i_type);
+
+        static int64_t GetByteSize(const TensorType & i_type);
+
 
             // identity element
 
@@ -191,15 +253,60 @@ namespace liquid
         void HashAttachment(Hash & i_dest, const std::any & i_attachment) const;
 
 
+            // attachment serialization
+
+        using AttachmentWriter = void (*)(BinaryWriter & i_dest, const std::any & i_attachment);
+        using AttachmentReader = std::any (*)(BinaryReader & i_source);
+
+        Operator & SetAttachmentSerializer(AttachmentWriter i_attachment_writer,
+            AttachmentReader i_attachment_reader);
+
+        template <typename ATTACHMENT_TYPE>
+            Operator & SetAttachmentSerializer()
+        {
+            return SetAttachmentSerializer(
+                [](BinaryWriter & i_dest, const std::any & i_attachment) {
+                    i_dest << std::any_cast<const ATTACHMENT_TYPE &>(i_attachment);
+                },
+                [](BinaryReader & i_source) -> std::any {
+                    return i_source.Read<ATTACHMENT_TYPE>();
+                });
+        }
+
+        void WriteAttachment(BinaryWriter & i_dest, const std::any & i_attachment) const;
+
+        std::any ReadAttachment(BinaryReader & i_source) const;
+
+
+            // overloads
+
+        size_t GetOverloadIndex(const Overload & i_overload) const;
+
+        const Overload & GetOverload(size_t i_overload_index) const;
+
+
             // hash
 
         friend Hash & operator << (Hash & i_dest, const Operator & i_source);
 
+    #if LIQUID_INSTRUMENTATION
+
+            // instrumentation
+
+        const OperatorStatistics & GetStatistics() const { return m_statistics; }
+
+        void ResetStatistics() const;
+
+    #endif
+
     private:
 
         static TensorType DefaultDeduceType(const std::any & i_attachment,
             Span<const Tensor> i_operands);
 
+        static Cost DefaultCost(const std::any & i_attachment,
+            const TensorType & i_result_type, Span<const Tensor> i_operands);
+
         enum class OverloadMatchFlags
         {
             None = 0,
@@ -215,9 +322,11 @@ namespace liquid
         bool IsEligibleForPropagation(const std::any & i_attachment, 
             Span<const Tensor> i_operands) const;
 
+        /* If o_promotion_cost is not null, it receives the sum of the costs of the
+            promoted operands, see GetPromotionCost. */
         static bool OverloadMatch(const Operator::Overload & i_overload, 
             Span<const Tensor> i_operands, OverloadMatchFlags i_flags,
-            std::vector<Tensor> & o_arguments);
+            std::vector<Tensor> & o_arguments, int * o_promotion_cost = nullptr);
 
         const Overload * TryFindOverload(Span<const Tensor> i_operands,
             OverloadMatchFlags i_flags, std::vector<Tensor> & o_arguments) const;
@@ -253,12 +362,19 @@ namespace liquid
         std::string_view m_doc_return_type;
         Flags m_flags = {};
         DeduceTypeFunction m_deduce_type_func = {};
+        ShapeConstraintsFunction m_shape_constraints_func = {};
+        CostFunction m_cost_func = {};
         EligibleForPropagation m_eligible_for_propagation = {};
         std::vector<Overload> m_overloads = {};
         std::vector<CanonicalizeFunction> m_canonicalize_funcs = {};
         GradientOfOperandFunction m_gradient_of_input_func = {};
         AttachmentComparer m_attachment_comparer = {};
         AttachmentHasher m_attachment_hasher = {};
+        AttachmentWriter m_attachment_writer = {};
+        AttachmentReader m_attachment_reader = {};
         std::optional<TensorValue> m_identity_value;
+    #if LIQUID_INSTRUMENTATION
+        mutable OperatorStatistics m_statistics;
+    #endif
     };
 }
@@ -49,7 +49,10 @@ namespace liquid
             .AddFlags(Operator::Flags::Commutative | Operator::Flags::Associative)
             .AddCanonicalize(AddCanonicalizeReplace)
             .AddOverload(AddEvaluate<Real>, { {ScalarType::Real, "addend"} }, 1)
+            .AddOverload(AddEvaluate<Real32>, { {ScalarType::Real32, "addend"} }, 1)
             .AddOverload(AddEvaluate<Integer>, { {ScalarType::Integer, "addend"} }, 1)
+            .AddOverload(AddEvaluate<Integer32>, { {ScalarType::Integer32, "addend"} }, 1)
+            .AddOverload(AddEvaluate<Integer8>, { {ScalarType::Integer8, "addend"} }, 1)
             .SetGradientOfOperand(AddGradient);
         return op;
     }
@@ -66,7 +69,7 @@ namespace liquid
 
     Tensor operator - (const Tensor & i_operand)
     {
-        return i_operand * -1;
+        return i_operand * LiteralOfType(MakeConstant<-1>(), i_operand.GetScalarType());
     }
 
     Tensor operator + (const Tensor & i_first, const Tensor & i_second)
@@ -0,0 +1,99 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "expression.h"
+#include "operator.h"
+#include "tensor_value.h"
+#include "tensor_type.h"
+
+namespace liquid
+{
+    extern const Operator & GetOperatorBroadcastTo();
+
+    TensorType BroadcastToDeduceType(const std::any & i_attachment, Span<const Tensor> i_operands)
+    {
+        const TensorType & source_type = i_operands.at(0).GetExpression()->GetType();
+        const FixedShape & shape = std::any_cast<const FixedShape &>(i_attachment);
+        if(source_type.HasFixedShape())
+        {
+            auto const broadcast = TryBroadcast({ source_type.GetFixedShape(), shape });
+            if(!broadcast || *broadcast != shape)
+                Panic("broadcast_to: can't broadcast ", source_type.GetFixedShape(), " to ", shape);
+        }
+        return { source_type.GetScalarType(), shape };
+    }
+
+    /* The result is a view of the source. The dimensions added on the left, and the
+        dimensions broadcast from 1, have stride zero. */
+    TensorValue BroadcastToEvaluate([[maybe_unused]] const std::any & i_attachment,
+        const TensorType & i_result_type, Span<const TensorValue> i_operands)
+    {
+        const TensorValue & source = i_operands.at(0);
+        Span<const Integer> const source_dimensions = source.GetShape().GetDimensions();
+        Span<const Integer> const source_strides = source.GetStorageStrides();
+        const FixedShape & result_shape = i_result_type.GetFixedShape();
+        Span<const Integer> const dimensions = result_shape.GetDimensions();
+
+        size_t const added = dimensions.size() - source_dimensions.size();
+        std::vector<Integer> strides(dimensions.size(), 0);
+        for(size_t index = 0; index < source_dimensions.size(); index++)
+            if(source_dimensions[index] == dimensions[added + index])
+                strides[added + index] = source_strides[index];
+
+        return TensorValue(source, result_shape, strides, source.GetStorageOffset());
+    }
+
+    // broadcast_to(x) -> x if the shape does not change
+    std::optional<Tensor> BroadcastToCanonicalize(const Tensor & i_source)
+    {
+        const Expression & expression = *i_source.GetExpression();
+        const Tensor & operand = expression.GetOperands().at(0);
+        const TensorType & operand_type = operand.GetExpression()->GetType();
+        if(operand_type.HasFixedShape() && operand_type.GetFixedShape() == expression.GetType().GetFixedShape())
+            return operand;
+        return {};
+    }
+
+    // the gradient is summed along the broadcast axes
+    Tensor BroadcastToGradient(const Tensor & i_self, const Tensor & i_self_gradient, [[maybe_unused]] size_t i_operand_index)
+    {
+        const Tensor & source = i_self.GetExpression()->GetOperands().at(0);
+        const TensorType & source_type = source.GetExpression()->GetType();
+        if(!source_type.HasFixedShape())
+            Panic("broadcast_to: the gradient requires an operand with a fixed shape");
+
+        Span<const Integer> const source_dimensions = source_type.GetFixedShape().GetDimensions();
+        Span<const Integer> const dimensions = i_self.GetExpression()->GetType().GetFixedShape().GetDimensions();
+        size_t const added = dimensions.size() - source_dimensions.size();
+        std::vector<Integer> axes;
+        for(size_t axis = 0; axis < dimensions.size(); axis++)
+            if(axis < added || source_dimensions[axis - added] != dimensions[axis])
+                axes.push_back(NumericCast<Integer>(axis));
+
+        return Reshape(Sum(i_self_gradient, axes), source_dimensions);
+    }
+
+    extern const Operator & GetOperatorBroadcastTo()
+    {
+        static auto const op = Operator("broadcast_to")
+            .SetDoc("Returns the source broadcast to a shape, without copying its elements.",
+                "The return scalar type is the scalar type of the source.\n"
+                "The return shape is the requested one, the shape of the source must be broadcastable to it.")
+            .SetDeduceType(BroadcastToDeduceType)
+            .SetCost(Operator::ViewCost)
+            .AddOverload(BroadcastToEvaluate, { { ScalarType::Any, "source" } })
+            .SetAttachmentComparer<FixedShape>()
+            .SetAttachmentHasher<FixedShape>()
+            .SetAttachmentSerializer<FixedShape>()
+            .AddCanonicalize(BroadcastToCanonicalize)
+            .SetGradientOfOperand(BroadcastToGradient);
+        return op;
+    }
+
+    Tensor BroadcastTo(const Tensor & i_source, Span<const Integer> i_shape)
+    {
+        return GetOperatorBroadcastTo().Invoke({ i_source }, FixedShape(i_shape));
+    }
+}
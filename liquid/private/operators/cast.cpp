@@ -61,6 +61,15 @@ namespace liquid
         case ScalarType::Integer:
             return CastEvaluateImpl<Integer, SOURCE_TYPE>(i_operands.at(0));
 
+        case ScalarType::Real32:
+            return CastEvaluateImpl<Real32, SOURCE_TYPE>(i_operands.at(0));
+
+        case ScalarType::Integer32:
+            return CastEvaluateImpl<Integer32, SOURCE_TYPE>(i_operands.at(0));
+
+        case ScalarType::Integer8:
+            return CastEvaluateImpl<Integer8, SOURCE_TYPE>(i_operands.at(0));
+
         default:
             Panic("CastEvaluate - unrecognized dest type");
         }  
@@ -71,9 +80,13 @@ namespace liquid
         static auto const op = Operator("cast")
             .SetDeduceType(CastDeduceType)
             .AddOverload(CastEvaluate<Real>, { { ScalarType::Real, "source" } })
+            .AddOverload(CastEvaluate<Real32>, { { ScalarType::Real32, "source" } })
             .AddOverload(CastEvaluate<Integer>, { { ScalarType::Integer, "source" } })
+            .AddOverload(CastEvaluate<Integer32>, { { ScalarType::Integer32, "source" } })
+            .AddOverload(CastEvaluate<Integer8>, { { ScalarType::Integer8, "source" } })
             .SetAttachmentComparer<ScalarType>()
             .SetAttachmentHasher<ScalarType>()
+            .SetAttachmentSerializer<ScalarType>()
             .AddCanonicalize(CastCanonicalize);
         return op;
     }
@@ -26,10 +26,12 @@ namespace liquid
     extern const Operator & GetOperatorConstant()
     {
         static auto const op = Operator("constant")
+            .SetCost(Operator::ZeroFlopsCost)
             .SetDeduceType(ConstantDeduceType)
             .AddOverload({ ConstantEvaluate, { } })
             .SetAttachmentComparer<TensorValue>()
-            .SetAttachmentHasher<TensorValue>();
+            .SetAttachmentHasher<TensorValue>()
+            .SetAttachmentSerializer<TensorValue>();
         return op;
     }
 
@@ -63,6 +65,9 @@ namespace liquid
     template Span<const Real> GetConstantStorage(const Tensor & i_tensor);
     template Span<const Integer> GetConstantStorage(const Tensor & i_tensor);
     template Span<const Bool> GetConstantStorage(const Tensor & i_tensor);
+    template Span<const Real32> GetConstantStorage(const Tensor & i_tensor);
+    template Span<const Integer32> GetConstantStorage(const Tensor & i_tensor);
+    template Span<const Integer8> GetConstantStorage(const Tensor & i_tensor);
 
     template <typename SCALAR_TYPE>
         Span<const SCALAR_TYPE> GetConstantStorage(const Tensor & i_tensor)
@@ -76,6 +81,9 @@ namespace liquid
     template std::vector<Real> ConstantToVector(const Tensor & i_tensor);
     template std::vector<Integer> ConstantToVector(const Tensor & i_tensor);
     template std::vector<Bool> ConstantToVector(const Tensor & i_tensor);
+    template std::vector<Real32> ConstantToVector(const Tensor & i_tensor);
+    template std::vector<Integer32> ConstantToVector(const Tensor & i_tensor);
+    template std::vector<Integer8> ConstantToVector(const Tensor & i_tensor);
 
     template <typename SCALAR_TYPE>
         std::vector<SCALAR_TYPE> ConstantToVector(const Tensor & i_tensor)
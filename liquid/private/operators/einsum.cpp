@@ -0,0 +1,490 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "expression.h"
+#include "operator.h"
+#include "tensor_value.h"
+#include "tensor_type.h"
+#include "indices.h"
+#include "matmul_kernel.h"
+#include <algorithm>
+#include <array>
+#include <string>
+
+namespace liquid
+{
+    extern const Operator & GetOperatorEinsum();
+
+    /* An index specification like "ij,jk->ik": a term of labels for every operand, and
+        the labels of the result. Labels are single letters. */
+    struct EinsumSpec
+    {
+        std::vector<std::string> m_operands;
+        std::string m_result;
+    };
+
+    // the dimension of every label, or -1 for labels not used
+    using EinsumDimensions = std::array<Integer, 128>;
+
+    bool EinsumHasLabel(std::string_view i_labels, char i_label)
+    {
+        return i_labels.find(i_label) != std::string_view::npos;
+    }
+
+    /* Without '->' the result has the labels that appear only once, in alphabetical order,
+        so "ij,jk" is the same as "ij,jk->ik" */
+    EinsumSpec ParseEinsumSpec(std::string_view i_spec)
+    {
+        EinsumSpec spec;
+        spec.m_operands.emplace_back();
+        bool has_arrow = false;
+        for(size_t index = 0; index < i_spec.size(); index++)
+        {
+            char const character = i_spec[index];
+            if(character == ' ')
+                continue;
+
+            if((character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z'))
+            {
+                if(has_arrow)
+                    spec.m_result.push_back(character);
+                else
+                    spec.m_operands.back().push_back(character);
+            }
+            else if(character == ',' && !has_arrow)
+                spec.m_operands.emplace_back();
+            else if(character == '-' && index + 1 < i_spec.size() && i_spec[index + 1] == '>' && !has_arrow)
+            {
+                has_arrow = true;
+                index++;
+            }
+            else
+                Panic("einsum: unexpected '", character, "' in the index specification '", i_spec, "'");
+        }
+
+        if(!has_arrow)
+        {
+            for(char label = 'A'; label <= 'z'; label++)
+            {
+                size_t occurrences = 0;
+                for(const std::string & operand : spec.m_operands)
+                    occurrences += static_cast<size_t>(std::count(operand.begin(), operand.end(), label));
+                if(occurrences == 1)
+                    spec.m_result.push_back(label);
+            }
+        }
+
+        for(size_t index = 0; index < spec.m_result.size(); index++)
+        {
+            char const label = spec.m_result[index];
+            if(EinsumHasLabel(std::string_view(spec.m_result).substr(0, index), label))
+                Panic("einsum: the label '", label, "' is repeated in the result of '", i_spec, "'");
+            if(std::none_of(spec.m_operands.begin(), spec.m_operands.end(),
+                    [label](const std::string & i_operand){ return EinsumHasLabel(i_operand, label); }))
+                Panic("einsum: the label '", label, "' of the result is not used by any operand in '", i_spec, "'");
+        }
+
+        return spec;
+    }
+
+    std::string ToString(const EinsumSpec & i_spec)
+    {
+        std::string result;
+        for(size_t index = 0; index < i_spec.m_operands.size(); index++)
+        {
+            if(index != 0)
+                result += ',';
+            result += i_spec.m_operands[index];
+        }
+        return result + "->" + i_spec.m_result;
+    }
+
+    EinsumSpec GetEinsumSpec(const std::any & i_attachment)
+    {
+        if(!i_attachment.has_value())
+            Panic("einsum: missing the index specification");
+        return ParseEinsumSpec(std::any_cast<const std::string &>(i_attachment));
+    }
+
+    EinsumDimensions GetEinsumDimensions(const EinsumSpec & i_spec, Span<const FixedShape> i_shapes)
+    {
+        if(i_spec.m_operands.size() != i_shapes.size())
+            Panic("einsum: the specification has ", i_spec.m_operands.size(),
+                " terms, but ", i_shapes.size(), " operands are provided");
+
+        EinsumDimensions dimensions;
+        dimensions.fill(-1);
+        for(size_t operand_index = 0; operand_index < i_shapes.size(); operand_index++)
+        {
+            const std::string & labels = i_spec.m_operands[operand_index];
+            Span<const Integer> const operand_dimensions = i_shapes[operand_index].GetDimensions();
+            if(labels.size() != operand_dimensions.size())
+                Panic("einsum: the term '", labels, "' has ", labels.size(),
+                    " labels, but the operand has the shape ", i_shapes[operand_index]);
+
+            for(size_t index = 0; index < labels.size(); index++)
+            {
+                Integer & dimension = dimensions[static_cast<size_t>(labels[index])];
+                if(dimension >= 0 && dimension != operand_dimensions[index])
+                    Panic("einsum: the label '", labels[index], "' has the dimensions ",
+                        dimension, " and ", operand_dimensions[index]);
+                dimension = operand_dimensions[index];
+            }
+        }
+        return dimensions;
+    }
+
+    Integer GetEinsumSize(std::string_view i_labels, const EinsumDimensions & i_dimensions)
+    {
+        Integer size = 1;
+        for(char const label : i_labels)
+            size *= i_dimensions[static_cast<size_t>(label)];
+        return size;
+    }
+
+    std::string GetUniqueLabels(std::string_view i_labels)
+    {
+        std::string unique;
+        for(char const label : i_labels)
+            if(!EinsumHasLabel(unique, label))
+                unique.push_back(label);
+        return unique;
+    }
+
+    // the labels of i_first and i_second needed by the result or by the other terms
+    std::string GetKeptLabels(const std::vector<std::string> & i_terms, size_t i_first, size_t i_second,
+        const std::string & i_result)
+    {
+        std::string kept;
+        for(char const label : GetUniqueLabels(i_terms[i_first] + i_terms[i_second]))
+        {
+            bool needed = EinsumHasLabel(i_result, label);
+            for(size_t index = 0; index < i_terms.size() && !needed; index++)
+                needed = index != i_first && index != i_second && EinsumHasLabel(i_terms[index], label);
+            if(needed)
+                kept.push_back(label);
+        }
+        return kept;
+    }
+
+    /* A contraction of two terms. The labels of both are split in: batch (in both and kept),
+        contracted (in both and not kept), left (only in the first and kept), right (only in
+        the second and kept). Labels only in one term and not kept are summed before. */
+    struct EinsumPair
+    {
+        std::string m_batch, m_left, m_contracted, m_right;
+    };
+
+    EinsumPair GetEinsumPair(const std::string & i_first, const std::string & i_second, const std::string & i_kept)
+    {
+        EinsumPair pair;
+        for(char const label : GetUniqueLabels(i_first + i_second))
+        {
+            bool const in_first = EinsumHasLabel(i_first, label);
+            bool const in_second = EinsumHasLabel(i_second, label);
+            bool const kept = EinsumHasLabel(i_kept, label);
+            if(in_first && in_second)
+                (kept ? pair.m_batch : pair.m_contracted).push_back(label);
+            else if(kept)
+                (in_first ? pair.m_left : pair.m_right).push_back(label);
+        }
+        return pair;
+    }
+
+    /* Contracting a pair costs a multiply-add for every combination of its labels. The pair
+        is chosen greedily: the cheapest first, and among them the one with the smallest result.
+        Returns the contracted pairs in order: at every step the pair is removed from the terms,
+        and the result is appended. */
+    std::vector<std::pair<size_t, size_t>> PlanEinsum(std::vector<std::string> i_terms,
+        const std::string & i_result, const EinsumDimensions & i_dimensions, int64_t & o_flops)
+    {
+        std::vector<std::pair<size_t, size_t>> plan;
+        o_flops = 0;
+        while(i_terms.size() > 1)
+        {
+            bool found = false;
+            std::pair<size_t, size_t> best;
+            Integer best_flops = 0, best_size = 0;
+            std::string best_labels;
+            for(size_t first = 0; first < i_terms.size(); first++)
+                for(size_t second = first + 1; second < i_terms.size(); second++)
+                {
+                    std::string const kept = GetKeptLabels(i_terms, first, second, i_result);
+                    EinsumPair const pair = GetEinsumPair(i_terms[first], i_terms[second], kept);
+                    Integer const flops = 2 * GetEinsumSize(
+                        pair.m_batch + pair.m_left + pair.m_contracted + pair.m_right, i_dimensions);
+                    Integer const size = GetEinsumSize(kept, i_dimensions);
+                    if(!found || flops < best_flops || (flops == best_flops && size < best_size))
+                    {
+                        found = true;
+                        best = { first, second };
+                        best_flops = flops;
+                        best_size = size;
+                        best_labels = pair.m_batch + pair.m_left + pair.m_right;
+                    }
+                }
+
+            plan.push_back(best);
+            o_flops += best_flops;
+            i_terms.erase(i_terms.begin() + static_cast<std::ptrdiff_t>(best.second));
+            i_terms.erase(i_terms.begin() + static_cast<std::ptrdiff_t>(best.first));
+            i_terms.push_back(best_labels);
+        }
+
+        // the final transposition or reduction
+        o_flops += GetEinsumSize(GetUniqueLabels(i_terms.at(0)), i_dimensions);
+        return plan;
+    }
+
+    /* Returns the elements of a term along i_target_labels, summing the labels not in the
+        target. i_source_labels may have repeated labels, that select a diagonal. */
+    template <typename SCALAR_TYPE>
+        std::vector<SCALAR_TYPE> EinsumRearrange(const SCALAR_TYPE * i_source, std::string_view i_source_labels,
+            std::string_view i_target_labels, const EinsumDimensions & i_dimensions)
+    {
+        std::string const unique = GetUniqueLabels(i_source_labels);
+        size_t const label_count = unique.size();
+
+        // the step of the source and target linear indices for every unique label
+        std::vector<Integer> extents(label_count), source_steps(label_count), target_steps(label_count);
+        Integer stride = 1;
+        for(size_t index = i_source_labels.size(); index-- > 0; )
+        {
+            source_steps[unique.find(i_source_labels[index])] += stride;
+            stride *= i_dimensions[static_cast<size_t>(i_source_labels[index])];
+        }
+        stride = 1;
+        for(size_t index = i_target_labels.size(); index-- > 0; )
+        {
+            target_steps[unique.find(i_target_labels[index])] += stride;
+            stride *= i_dimensions[static_cast<size_t>(i_target_labels[index])];
+        }
+        for(size_t index = 0; index < label_count; index++)
+            extents[index] = i_dimensions[static_cast<size_t>(unique[index])];
+
+        std::vector<SCALAR_TYPE> result(static_cast<size_t>(stride));
+        if(GetEinsumSize(unique, i_dimensions) == 0)
+            return result;
+
+        std::vector<Integer> counters(label_count);
+        Integer source_index = 0, target_index = 0;
+        for(bool in_bounds = true; in_bounds; )
+        {
+            result[static_cast<size_t>(target_index)] += i_source[source_index];
+
+            in_bounds = false;
+            for(size_t dim = label_count; dim-- > 0 && !in_bounds; )
+            {
+                source_index += source_steps[dim];
+                target_index += target_steps[dim];
+                if(++counters[dim] < extents[dim])
+                    in_bounds = true;
+                else
+                {
+                    source_index -= source_steps[dim] * extents[dim];
+                    target_index -= target_steps[dim] * extents[dim];
+                    counters[dim] = 0;
+                }
+            }
+        }
+        return result;
+    }
+
+    template <typename SCALAR_TYPE>
+        struct EinsumTerm
+    {
+        std::string m_labels;
+        std::vector<SCALAR_TYPE> m_elements;
+    };
+
+    // a batch of matrix products of [left, contracted] by [contracted, right]
+    template <typename SCALAR_TYPE>
+        EinsumTerm<SCALAR_TYPE> EinsumContract(const EinsumTerm<SCALAR_TYPE> & i_first,
+            const EinsumTerm<SCALAR_TYPE> & i_second, const std::string & i_kept,
+            const EinsumDimensions & i_dimensions)
+    {
+        EinsumPair const pair = GetEinsumPair(i_first.m_labels, i_second.m_labels, i_kept);
+
+        std::vector<SCALAR_TYPE> const first = EinsumRearrange(i_first.m_elements.data(),
+            i_first.m_labels, pair.m_batch + pair.m_left + pair.m_contracted, i_dimensions);
+        std::vector<SCALAR_TYPE> const second = EinsumRearrange(i_second.m_elements.data(),
+            i_second.m_labels, pair.m_batch + pair.m_contracted + pair.m_right, i_dimensions);
+
+        size_t const batch = static_cast<size_t>(GetEinsumSize(pair.m_batch, i_dimensions));
+        size_t const left = static_cast<size_t>(GetEinsumSize(pair.m_left, i_dimensions));
+        size_t const contracted = static_cast<size_t>(GetEinsumSize(pair.m_contracted, i_dimensions));
+        size_t const right = static_cast<size_t>(GetEinsumSize(pair.m_right, i_dimensions));
+
+        EinsumTerm<SCALAR_TYPE> result;
+        result.m_labels = pair.m_batch + pair.m_left + pair.m_right;
+        result.m_elements.resize(batch * left * right);
+        for(size_t batch_index = 0; batch_index < batch; batch_index++)
+            MatMulKernel(first.data() + batch_index * left * contracted,
+                second.data() + batch_index * contracted * right,
+                result.m_elements.data() + batch_index * left * right,
+                left, contracted, right);
+        return result;
+    }
+
+    template <typename SCALAR_TYPE>
+        TensorValue EinsumEvaluate(const std::any & i_attachment,
+            const TensorType & i_result_type, Span<const TensorValue> i_operands)
+    {
+        EinsumSpec const spec = GetEinsumSpec(i_attachment);
+        EinsumDimensions const dimensions = GetEinsumDimensions(spec,
+            Transform(i_operands, [](const TensorValue & i_value){ return i_value.GetShape(); }));
+
+        // terms are stored dense, unwrapping the storage, or reading views with their strides
+        std::vector<EinsumTerm<SCALAR_TYPE>> terms(i_operands.size());
+        for(size_t index = 0; index < i_operands.size(); index++)
+        {
+            const TensorValue & operand = i_operands[index];
+            terms[index].m_labels = spec.m_operands[index];
+            terms[index].m_elements.resize(static_cast<size_t>(operand.GetShape().GetLinearSize()));
+            if(terms[index].m_elements.empty())
+                continue; // an empty operand may have an empty storage
+            if(operand.IsView())
+            {
+                for(Indices indices(operand.GetShape()); indices; indices++)
+                    terms[index].m_elements[static_cast<size_t>(indices.GetLogicalLinearIndex())] =
+                        indices.At<SCALAR_TYPE>(operand);
+                continue;
+            }
+            Span<const SCALAR_TYPE> const storage = operand.GetStorageAs<SCALAR_TYPE>();
+            for(size_t element = 0; element < terms[index].m_elements.size(); element++)
+                terms[index].m_elements[element] = storage[element % storage.size()];
+        }
+
+        int64_t flops = 0;
+        for(auto const & [first, second] : PlanEinsum(spec.m_operands, spec.m_result, dimensions, flops))
+        {
+            std::vector<std::string> labels;
+            for(const auto & term : terms)
+                labels.push_back(term.m_labels);
+            std::string const kept = GetKeptLabels(labels, first, second, spec.m_result);
+
+            EinsumTerm<SCALAR_TYPE> contracted = EinsumContract(terms[first], terms[second], kept, dimensions);
+            terms.erase(terms.begin() + static_cast<std::ptrdiff_t>(second));
+            terms.erase(terms.begin() + static_cast<std::ptrdiff_t>(first));
+            terms.push_back(std::move(contracted));
+        }
+
+        const FixedShape & result_shape = i_result_type.GetFixedShape();
+        std::vector<SCALAR_TYPE> const elements = EinsumRearrange(terms.at(0).m_elements.data(),
+            terms.at(0).m_labels, spec.m_result, dimensions);
+        return TensorValue(SharedArray<const SCALAR_TYPE>(elements), result_shape);
+    }
+
+    TensorType EinsumDeduceType(const std::any & i_attachment, Span<const Tensor> i_operands)
+    {
+        EinsumSpec const spec = GetEinsumSpec(i_attachment);
+
+        std::vector<ScalarType> scalar_types;
+        std::vector<FixedShape> shapes;
+        for(const Tensor & operand : i_operands)
+        {
+            const TensorType & type = operand.GetExpression()->GetType();
+            scalar_types.push_back(type.GetScalarType());
+            if(type.HasFixedShape())
+                shapes.push_back(type.GetFixedShape());
+        }
+        ScalarType const scalar_type = DeduceScalarType(scalar_types);
+
+        if(shapes.size() != i_operands.size())
+            return { scalar_type };
+
+        EinsumDimensions const dimensions = GetEinsumDimensions(spec, shapes);
+        std::vector<Integer> result_dimensions;
+        for(char const label : spec.m_result)
+            result_dimensions.push_back(dimensions[static_cast<size_t>(label)]);
+        return { scalar_type, FixedShape(result_dimensions) };
+    }
+
+    Operator::Cost EinsumCost(const std::any & i_attachment,
+        const TensorType & i_result_type, Span<const Tensor> i_operands)
+    {
+        std::vector<FixedShape> shapes;
+        for(const Tensor & operand : i_operands)
+        {
+            const TensorType & type = operand.GetExpression()->GetType();
+            if(!type.HasFixedShape())
+                return { Operator::GetElementCount(i_result_type), Operator::GetByteSize(i_result_type) };
+            shapes.push_back(type.GetFixedShape());
+        }
+
+        EinsumSpec const spec = GetEinsumSpec(i_attachment);
+        int64_t flops = 0;
+        PlanEinsum(spec.m_operands, spec.m_result, GetEinsumDimensions(spec, shapes), flops);
+        return { flops, Operator::GetByteSize(i_result_type) };
+    }
+
+    /* The gradient of an operand is the contraction of the gradient of the result with the
+        other operands: for "ij,jk->ik" the gradient of the first operand is "ik,jk->ij". */
+    Tensor EinsumGradient(const Tensor & i_self,
+        const Tensor & i_self_gradient, size_t i_operand_index)
+    {
+        EinsumSpec const spec = GetEinsumSpec(i_self.GetExpression()->GetAttachment());
+        const std::vector<Tensor> & operands = i_self.GetExpression()->GetOperands();
+
+        EinsumSpec gradient_spec;
+        gradient_spec.m_operands.push_back(spec.m_result);
+        std::vector<Tensor> gradient_operands{ i_self_gradient };
+        for(size_t index = 0; index < operands.size(); index++)
+        {
+            if(index != i_operand_index)
+            {
+                gradient_spec.m_operands.push_back(spec.m_operands[index]);
+                gradient_operands.push_back(operands[index]);
+            }
+        }
+        gradient_spec.m_result = spec.m_operands.at(i_operand_index);
+
+        for(char const label : gradient_spec.m_result)
+        {
+            bool const repeated = std::count(gradient_spec.m_result.begin(), gradient_spec.m_result.end(), label) != 1;
+            bool const used = std::any_of(gradient_spec.m_operands.begin(), gradient_spec.m_operands.end(),
+                [label](const std::string & i_labels){ return EinsumHasLabel(i_labels, label); });
+            if(repeated || !used)
+                Panic("einsum: the gradient of the operand '", gradient_spec.m_result,
+                    "' is not supported, because the label '", label, "' is repeated or summed");
+        }
+
+        return Einsum(ToString(gradient_spec), gradient_operands);
+    }
+
+    const char g_einsum_description[] =
+        "Returns the contraction of the operands described by an index specification, like "
+        "'ij,jk->ik' for the matrix product. Labels shared by more operands are multiplied, "
+        "labels not in the result are summed, and labels repeated in a term select a diagonal. "
+        "Operands are contracted in pairs, choosing at every step the cheapest pair.";
+
+    const char g_einsum_return_type[] =
+        "The return scalar type is deduced permorming numeric promotion from all operands.\n"
+        "The return shape has the dimensions of the labels of the result.";
+
+    extern const Operator & GetOperatorEinsum()
+    {
+        static auto const op = Operator("einsum")
+            .SetDoc(g_einsum_description, g_einsum_return_type)
+            .SetDeduceType(EinsumDeduceType)
+            .SetCost(EinsumCost)
+            .AddOverload(EinsumEvaluate<Real>, { { ScalarType::Real, "operand" } }, 1)
+            .AddOverload(EinsumEvaluate<Real32>, { { ScalarType::Real32, "operand" } }, 1)
+            .AddOverload(EinsumEvaluate<Integer>, { { ScalarType::Integer, "operand" } }, 1)
+            .AddOverload(EinsumEvaluate<Integer32>, { { ScalarType::Integer32, "operand" } }, 1)
+            .AddOverload(EinsumEvaluate<Integer8>, { { ScalarType::Integer8, "operand" } }, 1)
+            .SetAttachmentComparer<std::string>()
+            .SetAttachmentHasher<std::string>()
+            .SetAttachmentSerializer<std::string>()
+            .SetGradientOfOperand(EinsumGradient);
+        return op;
+    }
+
+    Tensor Einsum(std::string_view i_spec, Span<Tensor const> i_operands)
+    {
+        // implicit results and blanks are normalized, so that equivalent specifications are identical
+        return GetOperatorEinsum().Invoke(i_operands, ToString(ParseEinsumSpec(i_spec)));
+    }
+}
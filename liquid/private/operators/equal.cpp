@@ -26,10 +26,7 @@ namespace liquid
         const TensorType & first_type = i_operands.at(0).GetExpression()->GetType();
         const TensorType & second_type = i_operands.at(1).GetExpression()->GetType();
 
-        if(first_type.HasFixedShape() && second_type.HasFixedShape())
-            return { ScalarType::Bool, Broadcast({first_type.GetFixedShape(), second_type.GetFixedShape()}) };
-        else
-            return { ScalarType::Bool };
+        return { ScalarType::Bool, BroadcastShapes({ first_type, second_type }) };
     }
 
     template <typename SCALAR_TYPE>
@@ -53,9 +50,13 @@ namespace liquid
         static auto const op = Operator("equal")
             .AddFlags(Operator::Flags::Commutative)
             .SetDeduceType(EqualDeduceType)
+            .SetShapeConstraints(Operator::BroadcastConstraints)
             .AddCanonicalize(EqualCanonicalize)
             .AddOverload(EqualEvaluate<Real>, { { ScalarType::Real, "first" }, { ScalarType::Real, "second" } })
+            .AddOverload(EqualEvaluate<Real32>, { { ScalarType::Real32, "first" }, { ScalarType::Real32, "second" } })
             .AddOverload(EqualEvaluate<Integer>, { { ScalarType::Integer, "first" }, { ScalarType::Integer, "second" } })
+            .AddOverload(EqualEvaluate<Integer32>, { { ScalarType::Integer32, "first" }, { ScalarType::Integer32, "second" } })
+            .AddOverload(EqualEvaluate<Integer8>, { { ScalarType::Integer8, "first" }, { ScalarType::Integer8, "second" } })
             .AddOverload(EqualEvaluate<Bool>, { { ScalarType::Bool, "first" }, { ScalarType::Bool, "second" } });
         return op;
     }
@@ -0,0 +1,122 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "expression.h"
+#include "operator.h"
+#include "tensor_value.h"
+#include "tensor_type.h"
+#include "index_kernel.h"
+#include <algorithm>
+
+namespace liquid
+{
+    extern const Operator & GetOperatorGather();
+
+    // the axis is attached only if it's not zero
+    Integer GetGatherAxis(const std::any & i_attachment)
+    {
+        return i_attachment.has_value() ? std::any_cast<Integer>(i_attachment) : 0;
+    }
+
+    TensorType GatherDeduceType(const std::any & i_attachment, Span<const Tensor> i_operands)
+    {
+        const TensorType & source_type = i_operands.at(0).GetExpression()->GetType();
+        const TensorType & indices_type = i_operands.at(1).GetExpression()->GetType();
+        if(!source_type.HasFixedShape() || !indices_type.HasFixedShape())
+            return source_type.GetScalarType();
+
+        return { source_type.GetScalarType(), GetGatheredShape("gather",
+            source_type.GetFixedShape(), indices_type.GetFixedShape(), GetGatherAxis(i_attachment)) };
+    }
+
+    /* The blocks selected by the indices are copied. If the indices are a contiguous vector
+        the result is a view of the source, as it was a slice. */
+    template <typename SCALAR_TYPE>
+        TensorValue GatherEvaluate(const std::any & i_attachment,
+            const TensorType & i_result_type, Span<const TensorValue> i_operands)
+    {
+        const TensorValue & source = i_operands.at(0);
+        const TensorValue & indices_value = i_operands.at(1);
+        Integer const axis = GetGatherAxis(i_attachment);
+        IndexedAxis const shape = GetIndexedAxis(source.GetShape(), axis);
+        const FixedShape & result_shape = i_result_type.GetFixedShape();
+
+        SharedArray<Integer> indices_buffer;
+        Span<const Integer> const indices(GetUnwrapped(indices_value, indices_buffer),
+            NumericCast<size_t>(indices_value.GetShape().GetLinearSize()));
+        IndexSequence const sequence = CheckIndices("gather", indices, shape.m_dimension);
+
+        if(sequence.m_contiguous && indices_value.GetShape().GetRank() == 1 && !indices.empty())
+        {
+            std::vector<Integer> strides(source.GetStorageStrides().begin(), source.GetStorageStrides().end());
+            Integer const offset = source.GetStorageOffset() + indices[0] * strides[NumericCast<size_t>(axis)];
+            return TensorValue(source, result_shape, strides, offset);
+        }
+
+        SharedArray<SCALAR_TYPE> source_buffer;
+        const SCALAR_TYPE * const elements = GetUnwrapped(source, source_buffer);
+        SharedArray<SCALAR_TYPE> result(NumericCast<size_t>(result_shape.GetLinearSize()));
+        SCALAR_TYPE * dest = result.data();
+        for(size_t outer = 0; outer < shape.m_outer; outer++)
+        {
+            const SCALAR_TYPE * const group = elements + outer * shape.m_dimension * shape.m_inner;
+            for(Integer index : indices)
+                dest = std::copy_n(group + NumericCast<size_t>(index) * shape.m_inner, shape.m_inner, dest);
+        }
+        return TensorValue(std::move(result), result_shape);
+    }
+
+    // gathering copies every element of the result
+    Operator::Cost GatherCost([[maybe_unused]] const std::any & i_attachment,
+        const TensorType & i_result_type, [[maybe_unused]] Span<const Tensor> i_operands)
+    {
+        return { 0, Operator::GetByteSize(i_result_type) };
+    }
+
+    // the gradient of the source accumulates the gradient of the result at the indices
+    Tensor GatherGradient(const Tensor & i_self, const Tensor & i_self_gradient, size_t i_operand_index)
+    {
+        if(i_operand_index != 0)
+            Panic("gather: the indices are not differentiable");
+
+        const Expression & expression = *i_self.GetExpression();
+        const Tensor & source = expression.GetOperands().at(0);
+        const TensorType & source_type = source.GetExpression()->GetType();
+        if(!source_type.HasFixedShape())
+            Panic("gather: the gradient requires an operand with a fixed shape");
+
+        Span<const Integer> const dimensions = source_type.GetFixedShape().GetDimensions();
+        Tensor const zero = Cast(source_type.GetScalarType(), Tensor(0, dimensions));
+        return ScatterAdd(zero, expression.GetOperands().at(1), i_self_gradient, GetGatherAxis(expression.GetAttachment()));
+    }
+
+    extern const Operator & GetOperatorGather()
+    {
+        static auto const op = Operator("gather")
+            .SetDoc("Returns the elements of the source at the indices along an axis.",
+                "The return scalar type is the scalar type of the source.\n"
+                "The return shape is the shape of the source, with the axis replaced by the shape of the indices.")
+            .SetDeduceType(GatherDeduceType)
+            .SetCost(GatherCost)
+            .AddOverload(GatherEvaluate<Real>, { { ScalarType::Real, "source" }, { ScalarType::Integer, "indices" } })
+            .AddOverload(GatherEvaluate<Real32>, { { ScalarType::Real32, "source" }, { ScalarType::Integer, "indices" } })
+            .AddOverload(GatherEvaluate<Integer>, { { ScalarType::Integer, "source" }, { ScalarType::Integer, "indices" } })
+            .AddOverload(GatherEvaluate<Integer32>, { { ScalarType::Integer32, "source" }, { ScalarType::Integer, "indices" } })
+            .AddOverload(GatherEvaluate<Integer8>, { { ScalarType::Integer8, "source" }, { ScalarType::Integer, "indices" } })
+            .AddOverload(GatherEvaluate<Bool>, { { ScalarType::Bool, "source" }, { ScalarType::Integer, "indices" } })
+            .SetAttachmentComparer<Integer>()
+            .SetAttachmentHasher<Integer>()
+            .SetAttachmentSerializer<Integer>()
+            .SetGradientOfOperand(GatherGradient);
+        return op;
+    }
+
+    Tensor Gather(const Tensor & i_source, const Tensor & i_indices, Integer i_axis)
+    {
+        if(i_axis == 0)
+            return GetOperatorGather().Invoke({ i_source, i_indices });
+        return GetOperatorGather().Invoke({ i_source, i_indices }, i_axis);
+    }
+}
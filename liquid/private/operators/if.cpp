@@ -30,20 +30,12 @@ namespace liquid
         scalar_types.push_back(fallback_value_type.GetScalarType());
 
         // all operands partecipate in shape deduction
-        std::vector<FixedShape> shapes;
-        shapes.reserve(i_operands.size());
+        std::vector<TensorType> types;
+        types.reserve(i_operands.size());
         for (size_t operand_index = 0; operand_index < i_operands.size(); operand_index++)
-        {
-            const TensorType & operand_type = i_operands[operand_index].GetExpression()->GetType();
-            if(operand_type.HasFixedShape())
-                shapes.push_back(operand_type.GetFixedShape());
-        }
+            types.push_back(i_operands[operand_index].GetExpression()->GetType());
 
-        ScalarType const scalar_type = DeduceScalarType(scalar_types);
-        if(shapes.size() == i_operands.size())
-            return { scalar_type, Broadcast(shapes) };
-        else
-            return { scalar_type };
+        return { DeduceScalarType(scalar_types), BroadcastShapes(types) };
     }
 
     template <typename SCALAR_TYPE>
@@ -108,6 +100,78 @@ namespace liquid
         return If(grad_ops);
     }
 
+    /* Removes the branches that can't be taken, and merges the branches that select
+        the same value. The operands are [Condition, Value]* Fallback. The result type
+        was already deduced from all the operands, so dropping a condition that would
+        broadcast the result is not a problem. */
+    bool IfCanonicalizeAdjust(std::vector<Tensor> & i_operands)
+    {
+        size_t const condition_count = i_operands.size() / 2;
+        for (size_t condition_index = 0; condition_index < condition_count; condition_index++)
+        {
+            const Tensor & condition = i_operands[condition_index * 2];
+            const Tensor & value = i_operands[condition_index * 2 + 1];
+
+            // if(..., true, x, ...) -> if(..., x)
+            if(IsUniformConstant(condition, true))
+            {
+                i_operands.erase(i_operands.begin() + condition_index * 2 + 2, i_operands.end());
+                i_operands.erase(i_operands.begin() + condition_index * 2);
+                return true;
+            }
+
+            // if(..., false, x, ...) -> if(...)
+            if(IsUniformConstant(condition, false))
+            {
+                i_operands.erase(i_operands.begin() + condition_index * 2, 
+                    i_operands.begin() + condition_index * 2 + 2);
+                return true;
+            }
+
+            // if(..., c, x, ..., c, y, ...) -> if(..., c, x, ...)
+            for (size_t prev_index = 0; prev_index < condition_index; prev_index++)
+            {
+                if(AreIdentical(i_operands[prev_index * 2], condition))
+                {
+                    i_operands.erase(i_operands.begin() + condition_index * 2, 
+                        i_operands.begin() + condition_index * 2 + 2);
+                    return true;
+                }
+            }
+
+            // if(..., c1, x, c2, x, ...) -> if(..., c1 || c2, x, ...)
+            if(condition_index + 1 < condition_count && 
+                AreIdentical(value, i_operands[condition_index * 2 + 3]))
+            {
+                i_operands[condition_index * 2] = condition || i_operands[condition_index * 2 + 2];
+                i_operands.erase(i_operands.begin() + condition_index * 2 + 2, 
+                    i_operands.begin() + condition_index * 2 + 4);
+                return true;
+            }
+        }
+
+        // if(..., c, x, x) -> if(..., x)
+        if(condition_count != 0 && AreIdentical(i_operands[i_operands.size() - 2], i_operands.back()))
+        {
+            i_operands.erase(i_operands.end() - 3, i_operands.end() - 1);
+            return true;
+        }
+
+        return false;
+    }
+
+    // if(x) -> x
+    std::optional<Tensor> IfCanonicalizeReplace(const Tensor & i_source)
+    {
+        const std::vector<Tensor> & operands = i_source.GetExpression()->GetOperands();
+        if(operands.size() == 1 && 
+            operands[0].GetExpression()->GetType() == i_source.GetExpression()->GetType())
+        {
+            return operands[0];
+        }
+        return {};
+    }
+
     const char g_if_description[] = 
         "Performs a component-wise value selection based on a set a conditions.\n"
         "The return value is a tensor in which every element is taken from the first"
@@ -126,14 +190,29 @@ namespace liquid
         static auto const op = Operator("if")
             .SetDoc(g_if_description, g_if_return_type)
             .SetDeduceType(IfDeduceType)
+            .SetShapeConstraints(Operator::BroadcastConstraints)
+            .AddCanonicalize(IfCanonicalizeAdjust)
+            .AddCanonicalize(IfCanonicalizeReplace)
             .AddOverload(IfEvaluate<Real>, {
                 { ScalarType::Bool, "condition" },
                 { ScalarType::Real, "value" },
                 { ScalarType::Real, "fallback" }  }, 2) // the first 2 parameters are the variadic pack
+            .AddOverload(IfEvaluate<Real32>, {
+                { ScalarType::Bool, "condition" },
+                { ScalarType::Real32, "value" },
+                { ScalarType::Real32, "fallback" }  }, 2) // the first 2 parameters are the variadic pack
             .AddOverload(IfEvaluate<Integer>, {
                 { ScalarType::Bool, "condition" },
                 { ScalarType::Integer, "value" },
                 { ScalarType::Integer, "fallback" }  }, 2) // the first 2 parameters are the variadic pack
+            .AddOverload(IfEvaluate<Integer32>, {
+                { ScalarType::Bool, "condition" },
+                { ScalarType::Integer32, "value" },
+                { ScalarType::Integer32, "fallback" }  }, 2) // the first 2 parameters are the variadic pack
+            .AddOverload(IfEvaluate<Integer8>, {
+                { ScalarType::Bool, "condition" },
+                { ScalarType::Integer8, "value" },
+                { ScalarType::Integer8, "fallback" }  }, 2) // the first 2 parameters are the variadic pack
             .AddOverload(IfEvaluate<Bool>, {
                 { ScalarType::Bool, "condition" },
                 { ScalarType::Bool, "value" },
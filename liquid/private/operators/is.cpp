@@ -85,11 +85,13 @@ namespace liquid
     extern const Operator & GetOperatorIs()
     {
         static auto const op = Operator("is")
+            .SetCost(Operator::ZeroFlopsCost)
             .SetDeduceType(IsDeduceType)
             .SetEligibleForPropagation(IsEligibleForPropagation)
             .AddOverload(IsEvaluate, {{ ScalarType::Any, "source" }} )
             .SetAttachmentComparer<TensorType>()
-            .SetAttachmentHasher<TensorType>();
+            .SetAttachmentHasher<TensorType>()
+            .SetAttachmentSerializer<TensorType>();
         return op;
     }
 
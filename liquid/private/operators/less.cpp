@@ -18,10 +18,7 @@ namespace liquid
         const TensorType & first_type = i_operands.at(0).GetExpression()->GetType();
         const TensorType & second_type = i_operands.at(1).GetExpression()->GetType();
 
-        if(first_type.HasFixedShape() && second_type.HasFixedShape())
-            return { ScalarType::Bool, Broadcast({first_type.GetFixedShape(), second_type.GetFixedShape()}) };
-        else
-            return { ScalarType::Bool };
+        return { ScalarType::Bool, BroadcastShapes({ first_type, second_type }) };
     }
 
     template <typename SCALAR_TYPE>
@@ -44,8 +41,12 @@ namespace liquid
     {
         static auto const op = Operator("less")
             .SetDeduceType(LessDeduceType)
+            .SetShapeConstraints(Operator::BroadcastConstraints)
             .AddOverload(LessEvaluate<Real>, { { ScalarType::Real, "first" }, { ScalarType::Real, "second" } })
+            .AddOverload(LessEvaluate<Real32>, { { ScalarType::Real32, "first" }, { ScalarType::Real32, "second" } })
             .AddOverload(LessEvaluate<Integer>, { { ScalarType::Integer, "first" }, { ScalarType::Integer, "second" } })
+            .AddOverload(LessEvaluate<Integer32>, { { ScalarType::Integer32, "first" }, { ScalarType::Integer32, "second" } })
+            .AddOverload(LessEvaluate<Integer8>, { { ScalarType::Integer8, "first" }, { ScalarType::Integer8, "second" } })
             .AddOverload(LessEvaluate<Bool>, { { ScalarType::Bool, "first" }, { ScalarType::Bool, "second" } });
         return op;
     }
@@ -9,18 +9,32 @@
 #include "tensor_value.h"
 #include "tensor_type.h"
 #include "indices.h"
+#include "fast_math.h"
 #include <cmath>
 
 namespace liquid
 {
-    TensorValue LogEvaluate(const TensorType & i_result_type, const TensorValue & i_operand)
+    template <typename SCALAR_TYPE>
+        TensorValue LogEvaluate(const TensorType & i_result_type, const TensorValue & i_operand)
     {
         const FixedShape & result_shape = i_result_type.GetFixedShape();
-        SharedArray<Real> result(static_cast<size_t>(result_shape.GetLinearSize()));
+        if constexpr(std::is_same_v<SCALAR_TYPE, Real>)
+        {
+            if(GetPrecision() == Precision::Fast)
+            {
+                // the storage of the result wraps like the storage of the operand
+                Span<const Real> const source = i_operand.GetAs<Real>();
+                SharedArray<Real> result(source.size());
+                FastLog(source.data(), result.data(), source.size());
+                return TensorValue(std::move(result), result_shape);
+            }
+        }
+
+        SharedArray<SCALAR_TYPE> result(static_cast<size_t>(result_shape.GetLinearSize()));
 
         for (Indices indices(result_shape); indices; indices++)
         {
-            auto const element = indices.At<Real>(i_operand);
+            auto const element = indices.At<SCALAR_TYPE>(i_operand);
             indices[result] = std::log(element);
         }
 
@@ -37,7 +51,9 @@ namespace liquid
     extern const Operator & GetOperatorLog()
     {
         static auto const op = Operator("log")
-            .AddOverload(LogEvaluate, { {ScalarType::Real, "operand"} } )
+            .SetCost(Operator::ElementwiseCost<8>)
+            .AddOverload(LogEvaluate<Real>, { {ScalarType::Real, "operand"} } )
+            .AddOverload(LogEvaluate<Real32>, { {ScalarType::Real32, "operand"} } )
             .SetGradientOfOperand(LogGradient);
         return op;
     }
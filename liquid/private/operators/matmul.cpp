@@ -0,0 +1,311 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "expression.h"
+#include "operator.h"
+#include "tensor_value.h"
+#include "tensor_type.h"
+#include "matmul_kernel.h"
+#include <algorithm>
+
+namespace liquid
+{
+    extern const Operator & GetOperatorMatMul();
+
+    /* The gradient of a matrix product is a matrix product with transposed operands.
+        Transpositions are attached to the expression, so that no transposed copy of an
+        operand is ever materialized. Vectors are never transposed. */
+    enum class MatMulFlags : uint8_t
+    {
+        None = 0,
+        TransposeFirst = 1 << 0,
+        TransposeSecond = 1 << 1
+    };
+
+    MatMulFlags operator | (MatMulFlags i_first, MatMulFlags i_second)
+    {
+        return static_cast<MatMulFlags>(static_cast<int>(i_first) | static_cast<int>(i_second));
+    }
+
+    MatMulFlags GetMatMulFlags(const std::any & i_attachment)
+    {
+        return i_attachment.has_value() ? std::any_cast<MatMulFlags>(i_attachment) : MatMulFlags::None;
+    }
+
+    // the product of op(first) [rows, inner] and op(second) [inner, columns]
+    struct MatMulShape
+    {
+        Integer m_rows = 1;
+        Integer m_inner = 1;
+        Integer m_columns = 1;
+        bool m_transpose_first = false;
+        bool m_transpose_second = false;
+        std::vector<Integer> m_result_dimensions;
+    };
+
+    MatMulShape GetMatMulShape(const std::any & i_attachment,
+        const FixedShape & i_first, const FixedShape & i_second)
+    {
+        Span<const Integer> const first = i_first.GetDimensions();
+        Span<const Integer> const second = i_second.GetDimensions();
+        if(first.size() < 1 || first.size() > 2 || second.size() < 1 || second.size() > 2)
+            Panic("matmul: the operands must be vectors or matrices, the shapes are ",
+                i_first, " and ", i_second);
+
+        MatMulShape shape;
+        MatMulFlags const flags = GetMatMulFlags(i_attachment);
+        shape.m_transpose_first = first.size() == 2 && HasFlags(flags, MatMulFlags::TransposeFirst);
+        shape.m_transpose_second = second.size() == 2 && HasFlags(flags, MatMulFlags::TransposeSecond);
+
+        // a vector is a row as first operand, and a column as second operand
+        if(first.size() == 2)
+        {
+            shape.m_rows = first[shape.m_transpose_first ? 1 : 0];
+            shape.m_inner = first[shape.m_transpose_first ? 0 : 1];
+            shape.m_result_dimensions.push_back(shape.m_rows);
+        }
+        else
+            shape.m_inner = first[0];
+
+        Integer second_inner = second[0];
+        if(second.size() == 2)
+        {
+            second_inner = second[shape.m_transpose_second ? 1 : 0];
+            shape.m_columns = second[shape.m_transpose_second ? 0 : 1];
+            shape.m_result_dimensions.push_back(shape.m_columns);
+        }
+
+        if(shape.m_inner != second_inner)
+            Panic("matmul: the inner dimensions do not match, the shapes are ",
+                i_first, " and ", i_second);
+
+        return shape;
+    }
+
+    /* Like GetMatMulShape, for symbolic shapes: returns the dimensions of the result, and adds
+        to o_constraints the equality of the inner dimensions. */
+    std::optional<std::vector<Tensor>> TryGetMatMulDimensions(const std::any & i_attachment,
+        const TensorType & i_first, const TensorType & i_second, std::vector<Tensor> * o_constraints)
+    {
+        auto const first = TryGetDimensions(i_first);
+        auto const second = TryGetDimensions(i_second);
+        if(!first || !second)
+            return {};
+        if(first->size() < 1 || first->size() > 2 || second->size() < 1 || second->size() > 2)
+            Panic("matmul: the operands must be vectors or matrices, the shapes are ",
+                i_first, " and ", i_second);
+
+        MatMulFlags const flags = GetMatMulFlags(i_attachment);
+        bool const transpose_first = first->size() == 2 && HasFlags(flags, MatMulFlags::TransposeFirst);
+        bool const transpose_second = second->size() == 2 && HasFlags(flags, MatMulFlags::TransposeSecond);
+
+        std::vector<Tensor> result_dimensions;
+        Tensor inner = (*first)[0];
+        if(first->size() == 2)
+        {
+            result_dimensions.push_back((*first)[transpose_first ? 1 : 0]);
+            inner = (*first)[transpose_first ? 0 : 1];
+        }
+
+        Tensor second_inner = (*second)[0];
+        if(second->size() == 2)
+        {
+            second_inner = (*second)[transpose_second ? 1 : 0];
+            result_dimensions.push_back((*second)[transpose_second ? 0 : 1]);
+        }
+
+        if(IsConstant(inner) && IsConstant(second_inner) && !AreIdentical(inner, second_inner))
+            Panic("matmul: the inner dimensions do not match, the shapes are ",
+                i_first, " and ", i_second);
+        if(o_constraints != nullptr && !AreIdentical(inner, second_inner))
+            AddShapeConstraint(*o_constraints, inner == second_inner);
+
+        return result_dimensions;
+    }
+
+    TensorType MatMulDeduceType(const std::any & i_attachment, Span<const Tensor> i_operands)
+    {
+        const TensorType & first_type = i_operands.at(0).GetExpression()->GetType();
+        const TensorType & second_type = i_operands.at(1).GetExpression()->GetType();
+        ScalarType const scalar_type = DeduceScalarType({ first_type.GetScalarType(), second_type.GetScalarType() });
+
+        if(first_type.HasFixedShape() && second_type.HasFixedShape())
+        {
+            MatMulShape const shape = GetMatMulShape(i_attachment,
+                first_type.GetFixedShape(), second_type.GetFixedShape());
+            return { scalar_type, FixedShape(shape.m_result_dimensions) };
+        }
+        else if(auto const dimensions = TryGetMatMulDimensions(i_attachment, first_type, second_type, nullptr))
+            return { scalar_type, MakeShapeVector(*dimensions) };
+        else
+            return { scalar_type };
+    }
+
+    std::vector<Tensor> MatMulShapeConstraints(const std::any & i_attachment, Span<const Tensor> i_operands)
+    {
+        std::vector<Tensor> constraints;
+        TryGetMatMulDimensions(i_attachment, i_operands.at(0).GetExpression()->GetType(),
+            i_operands.at(1).GetExpression()->GetType(), &constraints);
+        return constraints;
+    }
+
+    /* Returns op(i_value) as a dense row-major [rows, columns] matrix. The storage of the
+        value is used directly if it's not transposed, not wrapped and not a view, otherwise
+        the matrix is packed in o_buffer following the storage strides. */
+    template <typename SCALAR_TYPE>
+        const SCALAR_TYPE * GetDenseMatrix(const TensorValue & i_value, Integer i_rows, Integer i_columns,
+            bool i_transpose, std::vector<SCALAR_TYPE> & o_buffer)
+    {
+        Span<const SCALAR_TYPE> const storage = i_value.GetStorageAs<SCALAR_TYPE>();
+        size_t const rows = static_cast<size_t>(i_rows);
+        size_t const columns = static_cast<size_t>(i_columns);
+        if(!i_transpose && !i_value.IsView() && storage.size() == rows * columns)
+            return storage.data();
+
+        // a vector is either a row or a column, so it has a single stride
+        Span<const Integer> const strides = i_value.GetStorageStrides();
+        Integer row_stride = strides[0], column_stride = strides[0];
+        if(strides.size() == 2)
+        {
+            row_stride = strides[i_transpose ? 1 : 0];
+            column_stride = strides[i_transpose ? 0 : 1];
+        }
+
+        o_buffer.resize(rows * columns);
+        Integer const offset = i_value.GetStorageOffset();
+        for(size_t row = 0; row < rows; row++)
+            for(size_t column = 0; column < columns; column++)
+            {
+                Integer const stored_index = offset + static_cast<Integer>(row) * row_stride +
+                    static_cast<Integer>(column) * column_stride;
+                o_buffer[row * columns + column] = storage[static_cast<size_t>(stored_index) % storage.size()];
+            }
+        return o_buffer.data();
+    }
+
+    template <typename SCALAR_TYPE>
+        TensorValue MatMulEvaluate(const std::any & i_attachment,
+            const TensorType & i_result_type, Span<const TensorValue> i_operands)
+    {
+        const TensorValue & first = i_operands.at(0);
+        const TensorValue & second = i_operands.at(1);
+        MatMulShape const shape = GetMatMulShape(i_attachment, first.GetShape(), second.GetShape());
+
+        std::vector<SCALAR_TYPE> first_buffer, second_buffer;
+        const SCALAR_TYPE * const a = GetDenseMatrix(first, shape.m_rows, shape.m_inner,
+            shape.m_transpose_first, first_buffer);
+        const SCALAR_TYPE * const b = GetDenseMatrix(second, shape.m_inner, shape.m_columns,
+            shape.m_transpose_second, second_buffer);
+
+        const FixedShape & result_shape = i_result_type.GetFixedShape();
+        SharedArray<SCALAR_TYPE> result(static_cast<size_t>(result_shape.GetLinearSize()));
+        MatMulKernel(a, b, result.data(), static_cast<size_t>(shape.m_rows),
+            static_cast<size_t>(shape.m_inner), static_cast<size_t>(shape.m_columns));
+
+        return TensorValue(std::move(result), result_shape);
+    }
+
+    // a multiply-add for every element of the result and every element of the inner dimension
+    Operator::Cost MatMulCost(const std::any & i_attachment,
+        const TensorType & i_result_type, Span<const Tensor> i_operands)
+    {
+        const TensorType & first_type = i_operands.at(0).GetExpression()->GetType();
+        const TensorType & second_type = i_operands.at(1).GetExpression()->GetType();
+        Integer inner = 1;
+        if(first_type.HasFixedShape() && second_type.HasFixedShape())
+            inner = GetMatMulShape(i_attachment, first_type.GetFixedShape(), second_type.GetFixedShape()).m_inner;
+        return { 2 * inner * Operator::GetElementCount(i_result_type), Operator::GetByteSize(i_result_type) };
+    }
+
+    Tensor MatMul(const Tensor & i_first, const Tensor & i_second, MatMulFlags i_flags)
+    {
+        if(i_flags == MatMulFlags::None)
+            return GetOperatorMatMul().Invoke({ i_first, i_second });
+        return GetOperatorMatMul().Invoke({ i_first, i_second }, i_flags);
+    }
+
+    // the outer product of two vectors, as product of a column [rows, 1] by a row [1, columns]
+    Tensor Outer(const Tensor & i_column, const Tensor & i_row)
+    {
+        return MatMul(Stack({ i_column }, 1), Stack({ i_row }), MatMulFlags::None);
+    }
+
+    Tensor MatMulGradient(const Tensor & i_self,
+        const Tensor & i_self_gradient, size_t i_operand_index)
+    {
+        const Tensor & first = i_self.GetExpression()->GetOperands().at(0);
+        const Tensor & second = i_self.GetExpression()->GetOperands().at(1);
+        const Tensor & gradient = i_self_gradient;
+        if(!first.GetExpression()->GetType().HasFixedShape() || !second.GetExpression()->GetType().HasFixedShape())
+            Panic("matmul: the gradient requires operands with a fixed shape");
+
+        MatMulShape const shape = GetMatMulShape(i_self.GetExpression()->GetAttachment(),
+            first.GetExpression()->GetType().GetFixedShape(), second.GetExpression()->GetType().GetFixedShape());
+        bool const first_is_matrix = first.GetExpression()->GetType().GetFixedShape().GetRank() == 2;
+        bool const second_is_matrix = second.GetExpression()->GetType().GetFixedShape().GetRank() == 2;
+        auto const transpose = [](bool i_first, bool i_second) {
+            return (i_first ? MatMulFlags::TransposeFirst : MatMulFlags::None) |
+                (i_second ? MatMulFlags::TransposeSecond : MatMulFlags::None); };
+
+        // the product is op(first) op(second), the gradient of op(x) is transposed again if x is
+        if(i_operand_index == 0)
+        {
+            if(!first_is_matrix && !second_is_matrix)
+                return gradient * second;
+            if(!first_is_matrix)
+                return MatMul(second, gradient, transpose(shape.m_transpose_second, false));
+            if(!second_is_matrix)
+                return shape.m_transpose_first ? Outer(second, gradient) : Outer(gradient, second);
+            if(shape.m_transpose_first)
+                return MatMul(second, gradient, transpose(shape.m_transpose_second, true));
+            return MatMul(gradient, second, transpose(false, !shape.m_transpose_second));
+        }
+        else
+        {
+            if(!first_is_matrix && !second_is_matrix)
+                return gradient * first;
+            if(!second_is_matrix)
+                return MatMul(first, gradient, transpose(!shape.m_transpose_first, false));
+            if(!first_is_matrix)
+                return shape.m_transpose_second ? Outer(gradient, first) : Outer(first, gradient);
+            if(shape.m_transpose_second)
+                return MatMul(gradient, first, transpose(true, shape.m_transpose_first));
+            return MatMul(first, gradient, transpose(!shape.m_transpose_first, false));
+        }
+    }
+
+    const char g_matmul_description[] =
+        "Returns the matrix product of the operands, that can be matrices or vectors. "
+        "A vector is a row if it's the first operand, and a column if it's the second operand.";
+
+    const char g_matmul_return_type[] =
+        "The return scalar type is deduced permorming numeric promotion from the operands.\n"
+        "The return shape is [rows, columns], where any dimension of a vector operand is omitted: "
+        "the product of two vectors is a scalar.";
+
+    extern const Operator & GetOperatorMatMul()
+    {
+        static auto const op = Operator("matmul")
+            .SetDoc(g_matmul_description, g_matmul_return_type)
+            .SetDeduceType(MatMulDeduceType)
+            .SetShapeConstraints(MatMulShapeConstraints)
+            .SetCost(MatMulCost)
+            .AddOverload(MatMulEvaluate<Real>, { { ScalarType::Real, "first" }, { ScalarType::Real, "second" } })
+            .AddOverload(MatMulEvaluate<Real32>, { { ScalarType::Real32, "first" }, { ScalarType::Real32, "second" } })
+            .AddOverload(MatMulEvaluate<Integer>, { { ScalarType::Integer, "first" }, { ScalarType::Integer, "second" } })
+            .AddOverload(MatMulEvaluate<Integer32>, { { ScalarType::Integer32, "first" }, { ScalarType::Integer32, "second" } })
+            .AddOverload(MatMulEvaluate<Integer8>, { { ScalarType::Integer8, "first" }, { ScalarType::Integer8, "second" } })
+            .SetAttachmentComparer<MatMulFlags>()
+            .SetAttachmentHasher<MatMulFlags>()
+            .SetAttachmentSerializer<MatMulFlags>()
+            .SetGradientOfOperand(MatMulGradient);
+        return op;
+    }
+
+    Tensor MatMul(const Tensor & i_first, const Tensor & i_second)
+    {
+        return MatMul(i_first, i_second, MatMulFlags::None);
+    }
+}
@@ -9,6 +9,8 @@
 #include "tensor_value.h"
 #include "tensor_type.h"
 #include "indices.h"
+#include <unordered_map>
+#include <algorithm>
 
 namespace liquid
 {
@@ -51,65 +53,67 @@ namespace liquid
         const Tensor & zero = MakeConstant<0>();
         for(const auto & operand : i_source.GetExpression()->GetOperands())
             if(AreIdentical(operand, zero))
-                return zero;
+                return LiteralOfType(zero, i_source.GetScalarType());
 
         return {};
     }
 
+    /* pow(a, b) * ... * pow(a, c) * ... * a -> pow(a, b + c + 1) * ...
+        (merge pow's with the same base). Operands are grouped by the hash of their base
+        in a single pass, and the operand vector is rebuilt only if some group has more
+        than one operand. The merged pow takes the position of the first operand of the group.
+        Integer bases are not merged, since pow would promote them to real. */
     bool MulCanonicalizeAdjust(std::vector<Tensor> & i_operands)
     {
+        struct Group
+        {
+            Tensor m_base;
+            std::vector<Tensor> m_exponents;
+            size_t m_first_operand;
+        };
+        std::vector<Group> groups;
+        std::unordered_map<Hash::Word, std::vector<size_t>> buckets; // base hash -> indices of groups
         bool some_adjustement = false;
 
-        /* pow(a, b) * ... * pow(a, c) -> pow(a, b+c) * ...
-            (merge pow's with the same base) */
-        for(size_t i = 0; i < i_operands.size(); i++)
+        for(size_t operand_index = 0; operand_index < i_operands.size(); operand_index++)
         {
-            const auto & operand = i_operands[i];
-            if(!operand.GetExpression()->OperatorIs(GetOperatorPow()))
+            const Tensor & operand = i_operands[operand_index];
+            bool const is_pow = operand.GetExpression()->OperatorIs(GetOperatorPow());
+            const Tensor & base = is_pow ? operand.GetExpression()->GetOperand(0) : operand;
+            Tensor const exponent = is_pow ? operand.GetExpression()->GetOperand(1) : MakeConstant<1>();
+            if(IsIntegral(base.GetScalarType()))
+            {
+                groups.push_back(Group{base, {exponent}, operand_index});
                 continue;
-
-            const Tensor & base = operand.GetExpression()->GetOperand(0);
-            Tensor new_exponent = operand.GetExpression()->GetOperand(1);
-            size_t matches = 0; // sumber of subsequent pow's with identical base
-
-            /* serach other pow's with a matching base. On a match,
-                the exponent is summed to new_exponent, and the operand
-                is removed. */
-            for(size_t j = i + 1; j < i_operands.size(); )
-            { 
-                const auto & other_operand = i_operands[j];
-                if(other_operand.GetExpression()->OperatorIs(GetOperatorPow()))
-                {
-                    const Tensor & other_base = other_operand.GetExpression()->GetOperand(0);
-                    const Tensor & other_exponent = other_operand.GetExpression()->GetOperand(1);
-                    if(AreIdentical(base, other_base))
-                    {
-                        // accumulate exponents
-                        new_exponent += other_exponent;
-
-                        i_operands.erase(i_operands.begin() + j);
-                        matches++;
-                        continue;
-                    }
-                }
-                else if(AreIdentical(base, other_operand))
-                {
-                    // accumulate exponents
-                    new_exponent += 1;
-
-                    i_operands.erase(i_operands.begin() + j);
-                    matches++;
-                    continue;
-                }
-                j++;
             }
 
-            // replace the i-th operand with the merged pow
-            if(matches > 0)
+            std::vector<size_t> & bucket = buckets[base.GetExpression()->GetHash().GetValue()];
+            auto const group_it = std::find_if(bucket.begin(), bucket.end(), 
+                [&](size_t i_group_index){ return AreIdentical(groups[i_group_index].m_base, base); });
+            if(group_it != bucket.end())
             {
-                i_operands[i] = Pow(base, new_exponent);
+                groups[*group_it].m_exponents.push_back(exponent);
                 some_adjustement = true;
             }
+            else
+            {
+                bucket.push_back(groups.size());
+                groups.push_back(Group{base, {exponent}, operand_index});
+            }
+        }
+
+        if(some_adjustement)
+        {
+            std::vector<Tensor> merged_operands;
+            merged_operands.reserve(groups.size());
+            for(const Group & group : groups)
+            {
+                if(group.m_exponents.size() == 1)
+                    merged_operands.push_back(i_operands[group.m_first_operand]);
+                else
+                    merged_operands.push_back(Pow(group.m_base, Add(group.m_exponents)));
+            }
+            i_operands = std::move(merged_operands);
         }
 
         return some_adjustement;
@@ -124,7 +128,10 @@ namespace liquid
             .AddCanonicalize(MulCanonicalizeAdjust)
             .AddCanonicalize(MulCanonicalizeReplace)
             .AddOverload(MulEvaluate<Real>, { {ScalarType::Real, "factor"} }, 1)
+            .AddOverload(MulEvaluate<Real32>, { {ScalarType::Real32, "factor"} }, 1)
             .AddOverload(MulEvaluate<Integer>, { {ScalarType::Integer, "factor"} }, 1)
+            .AddOverload(MulEvaluate<Integer32>, { {ScalarType::Integer32, "factor"} }, 1)
+            .AddOverload(MulEvaluate<Integer8>, { {ScalarType::Integer8, "factor"} }, 1)
             .SetGradientOfOperand(MulGradient);
         return op;
     }
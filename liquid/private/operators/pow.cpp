@@ -9,26 +9,145 @@
 #include "tensor_value.h"
 #include "tensor_type.h"
 #include "indices.h"
+#include "fast_math.h"
+#include "index_kernel.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <optional>
 
 namespace liquid
 {
     extern const Operator & GetOperatorPow();
 
-    TensorValue PowEvaluate(const TensorType & i_result_type, Span<const TensorValue> i_operands)
+    /* Exponentiation by squaring accumulates the rounding errors of the multiplications, up
+        to 46 ulp with 63 as exponent. In Precision::Exact it is used only when the result is
+        correctly rounded, like the one of std::pow: x^2 and 1/x. */
+    constexpr Integer g_max_squaring_exponent = 64;
+
+    // if the exponent is the same integer for all the elements, and it can be squared, returns it
+    std::optional<Integer> GetSquaringExponent(const TensorValue & i_exponent)
+    {
+        std::optional<Integer> exponent;
+        if(i_exponent.GetScalarType() == ScalarType::Integer)
+        {
+            Span<const Integer> const storage = i_exponent.GetAs<Integer>();
+            if(storage.size() == 1 && std::abs(storage[0]) <= g_max_squaring_exponent)
+                exponent = storage[0];
+        }
+        else
+        {
+            Span<const Real> const storage = i_exponent.GetAs<Real>();
+            if(storage.size() == 1 && std::abs(storage[0]) <= g_max_squaring_exponent &&
+                    storage[0] == std::trunc(storage[0]))
+                exponent = static_cast<Integer>(storage[0]);
+        }
+
+        if(exponent && GetPrecision() == Precision::Exact && (*exponent < -1 || *exponent > 2))
+            return {};
+        return exponent;
+    }
+
+    bool IsSquareRoot(const TensorValue & i_exponent)
+    {
+        if(i_exponent.GetScalarType() != ScalarType::Real)
+            return false;
+        Span<const Real> const storage = i_exponent.GetAs<Real>();
+        return storage.size() == 1 && storage[0] == 0.5;
+    }
+
+    // elements of the operand broadcast to the shape of the result, in row-major order
+    const Real * GetBroadcastElements(const TensorValue & i_operand,
+        const FixedShape & i_result_shape, SharedArray<Real> & o_buffer)
+    {
+        if(i_operand.GetShape() == i_result_shape)
+            return GetUnwrapped(i_operand, o_buffer);
+
+        o_buffer = SharedArray<Real>(NumericCast<size_t>(i_result_shape.GetLinearSize()));
+        for (Indices indices(i_result_shape); indices; indices++)
+            indices[o_buffer] = indices.At<Real>(i_operand);
+        return o_buffer.data();
+    }
+
+    /* Multiplies the powers of the bases by squaring, for every bit of the exponent. The
+        loops run on blocks of elements, so that they are vectorized and the powers stay in
+        the L1 cache. A negative exponent takes the reciprocal of the result. */
+    void PowBySquaring(const Real * i_bases, Integer i_exponent, Real * o_dest, size_t i_count)
+    {
+        constexpr size_t block_size = 256;
+        Real powers[block_size];
+        for(size_t block = 0; block < i_count; block += block_size)
+        {
+            size_t const size = std::min(block_size, i_count - block);
+            Real * const dest = o_dest + block;
+            std::copy(i_bases + block, i_bases + block + size, powers);
+            std::fill(dest, dest + size, 1.);
+
+            for(Integer bits = std::abs(i_exponent); bits != 0; bits >>= 1)
+            {
+                if(bits & 1)
+                    for(size_t index = 0; index < size; index++)
+                        dest[index] *= powers[index];
+                if(bits > 1)
+                    for(size_t index = 0; index < size; index++)
+                        powers[index] *= powers[index];
+            }
+
+            if(i_exponent < 0)
+                for(size_t index = 0; index < size; index++)
+                    dest[index] = 1. / dest[index];
+        }
+    }
+
+    // adding zero makes sqrt(-0) = +0, as pow(-0, 0.5)
+    void PowSquareRoot(const Real * i_bases, Real * o_dest, size_t i_count)
+    {
+        for(size_t index = 0; index < i_count; index++)
+            o_dest[index] = std::sqrt(i_bases[index]) + 0.;
+
+        for(size_t index = 0; index < i_count; index++)
+            if(i_bases[index] == -std::numeric_limits<Real>::infinity())
+                o_dest[index] = std::numeric_limits<Real>::infinity();
+    }
+
+    template <typename SCALAR_TYPE>
+        TensorValue PowEvaluate(const TensorType & i_result_type, Span<const TensorValue> i_operands)
     {
         const FixedShape & result_shape = i_result_type.GetFixedShape();
-        SharedArray<Real> result(static_cast<size_t>(result_shape.GetLinearSize()));
+        SharedArray<SCALAR_TYPE> result(static_cast<size_t>(result_shape.GetLinearSize()));
 
         const TensorValue & base = i_operands.at(0);
         const TensorValue & exponent = i_operands.at(1);
 
-        if(exponent.GetScalarType() == ScalarType::Real)
+        if constexpr(std::is_same_v<SCALAR_TYPE, Real>)
+        {
+            // the same exponent for all the elements: std::pow is not used for small integers and 0.5
+            std::optional<Integer> const squaring_exponent = GetSquaringExponent(exponent);
+            if(squaring_exponent || IsSquareRoot(exponent))
+            {
+                SharedArray<Real> bases;
+                const Real * const elements = GetBroadcastElements(base, result_shape, bases);
+                if(squaring_exponent)
+                    PowBySquaring(elements, *squaring_exponent, result.data(), result.size());
+                else
+                    PowSquareRoot(elements, result.data(), result.size());
+                return TensorValue(std::move(result), result_shape);
+            }
+            else if(exponent.GetScalarType() == ScalarType::Real && GetPrecision() == Precision::Fast)
+            {
+                SharedArray<Real> bases, exponents;
+                FastPow(GetBroadcastElements(base, result_shape, bases), GetBroadcastElements(exponent, result_shape, exponents),
+                    result.data(), result.size());
+                return TensorValue(std::move(result), result_shape);
+            }
+        }
+
+        if(exponent.GetScalarType() == i_result_type.GetScalarType())
         {
             for (Indices indices(result_shape); indices; indices++)
             {
-                auto const base_el = indices.At<Real>(base);
-                auto const exponent_el = indices.At<Real>(exponent);
+                auto const base_el = indices.At<SCALAR_TYPE>(base);
+                auto const exponent_el = indices.At<SCALAR_TYPE>(exponent);
                 indices[result] = std::pow(base_el, exponent_el);
             }
         }
@@ -36,9 +155,9 @@ namespace liquid
         {
             for (Indices indices(result_shape); indices; indices++)
             {
-                auto const base_el = indices.At<Real>(base);
+                auto const base_el = indices.At<SCALAR_TYPE>(base);
                 auto const exponent_el = indices.At<Integer>(exponent);
-                indices[result] = std::pow(base_el, exponent_el);
+                indices[result] = static_cast<SCALAR_TYPE>(std::pow(base_el, exponent_el));
             }
         }
         else
@@ -67,12 +186,13 @@ namespace liquid
 
         /* pow(real a, 0) where a != 0 -> 1
            pow(0, 0) -> undeterminate (see https://en.wikipedia.org/wiki/Zero_to_the_power_of_zero) */
+        ScalarType const scalar_type = i_source.GetScalarType();
         if(AreIdentical(exponent, zero))
         {
             if(AreIdentical(base, zero))
                 return {}; // do nothing
             else
-                return one;
+                return LiteralOfType(one, scalar_type);
         }
 
         // pow(real a, 1) -> a
@@ -81,11 +201,11 @@ namespace liquid
 
         // pow(0, real a) where a != 0 -> 0
         if(AreIdentical(base, zero))
-            return zero;
+            return LiteralOfType(zero, scalar_type);
 
         // pow(1, real a) -> 1
         if(AreIdentical(base, one))
-            return one;
+            return LiteralOfType(one, scalar_type);
 
         // (real a ^ real b) ^ real c -> a ^ (b*c)
         // or: pow(pow(real a, real b), real c) -> pow(a, b*c)
@@ -102,15 +222,27 @@ namespace liquid
     extern const Operator & GetOperatorPow()
     {
         static auto const op = Operator("pow")
+            .SetCost(Operator::ElementwiseCost<8>)
             .AddCanonicalize(PowCanonicalizeReplace)
-            .AddOverload(PowEvaluate, { {ScalarType::Real, "base"}, {ScalarType::Integer, "exponent"} } )
-            .AddOverload(PowEvaluate, { {ScalarType::Real, "base"}, {ScalarType::Real, "exponent"} } )
+            .AddOverload(PowEvaluate<Real>, { {ScalarType::Real, "base"}, {ScalarType::Integer, "exponent"} } )
+            .AddOverload(PowEvaluate<Real>, { {ScalarType::Real, "base"}, {ScalarType::Real, "exponent"} } )
+            .AddOverload(PowEvaluate<Real32>, { {ScalarType::Real32, "base"}, {ScalarType::Integer, "exponent"} } )
+            .AddOverload(PowEvaluate<Real32>, { {ScalarType::Real32, "base"}, {ScalarType::Real32, "exponent"} } )
             .SetGradientOfOperand(PowGradient);
         return op;
     }
 
     Tensor Pow(const Tensor & i_base, const Tensor & i_exponent)
     {
+        /* pow(a, 1) -> a and pow(a, 0) -> 1 are done before the overload resolution, that
+            would promote an integer base to real */
+        if(IsIntegral(i_base.GetScalarType()) && !IsConstant(i_base))
+        {
+            if(AreIdentical(i_exponent, MakeConstant<1>()))
+                return i_base;
+            if(AreIdentical(i_exponent, MakeConstant<0>()))
+                return LiteralOfType(MakeConstant<1>(), i_base.GetScalarType());
+        }
         return GetOperatorPow().Invoke({i_base, i_exponent});
     }
 
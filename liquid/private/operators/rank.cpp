@@ -33,11 +33,22 @@ namespace liquid
         return TensorValue(SharedArray<Integer>{ shape.GetRank() }, i_result_type.GetFixedShape());
     }
 
+    // the rank of a symbolic shape is known at compile time
+    std::optional<Tensor> RankCanonicalize(const Tensor & i_source)
+    {
+        const TensorType & type = i_source.GetExpression()->GetOperand(0).GetExpression()->GetType();
+        if(std::optional<size_t> const rank = TryGetRank(type))
+            return Tensor(NumericCast<Integer>(*rank));
+        return {};
+    }
+
     extern const Operator & GetOperatorRank()
     {
         static auto const op = Operator("rank")
+            .SetCost(Operator::ZeroFlopsCost)
             .SetDeduceType(RankDeduceType)
             .SetEligibleForPropagation(RankEligibleForPropagation)
+            .AddCanonicalize(RankCanonicalize)
             .AddOverload({ RankEvaluate, {{ ScalarType::Any, "source" } }});
         return op;
     }
@@ -0,0 +1,566 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "expression.h"
+#include "operator.h"
+#include "tensor_value.h"
+#include "tensor_type.h"
+#include <algorithm>
+#include <limits>
+#include <future>
+#include <thread>
+
+namespace liquid
+{
+    extern const Operator & GetOperatorAdd();
+    extern const Operator & GetOperatorMul();
+    extern const Operator & GetOperatorAnd();
+    extern const Operator & GetOperatorOr();
+    extern const Operator & GetOperatorSum();
+    extern const Operator & GetOperatorProduct();
+
+    /* Reductions have a bit for every reduced axis as attachment. Without attachment all
+        the axes are reduced, so that the reduction of a tensor whose shape is not known yet
+        can be expressed. */
+    using ReduceAxes = uint64_t;
+
+    ReduceAxes GetReduceAxes(const std::any & i_attachment, size_t i_rank)
+    {
+        if(i_attachment.has_value())
+            return std::any_cast<ReduceAxes>(i_attachment);
+        return i_rank >= 64 ? ~ReduceAxes(0) : (ReduceAxes(1) << i_rank) - 1;
+    }
+
+    bool IsReducedAxis(ReduceAxes i_axes, size_t i_axis)
+    {
+        return (i_axes >> i_axis) & 1;
+    }
+
+    struct SumReduction
+    {
+        static constexpr const char * s_name = "sum";
+
+        template <typename SCALAR_TYPE> static SCALAR_TYPE Identity() { return 0; }
+        template <typename SCALAR_TYPE> static SCALAR_TYPE Combine(SCALAR_TYPE i_first, SCALAR_TYPE i_second)
+            { return i_first + i_second; }
+
+        // sum(a + b) -> sum(a) + sum(b), and a uniform addend is multiplied by the reduced element count
+        static const Operator * GetDistributive() { return &GetOperatorAdd(); }
+        static std::optional<Tensor> Repeat(const Tensor & i_uniform, Integer i_count)
+        {
+            // the count has the scalar type of the addend, so it must be exact in it
+            ScalarType const scalar_type = i_uniform.GetScalarType();
+            if((scalar_type == ScalarType::Integer8 && i_count > std::numeric_limits<Integer8>::max()) ||
+                    (scalar_type == ScalarType::Integer32 && i_count > std::numeric_limits<Integer32>::max()) ||
+                    (scalar_type == ScalarType::Real32 && i_count > (Integer(1) << std::numeric_limits<Real32>::digits)))
+                return {};
+            return i_uniform * LiteralOfType(i_count, scalar_type);
+        }
+    };
+
+    struct ProductReduction
+    {
+        static constexpr const char * s_name = "product";
+
+        template <typename SCALAR_TYPE> static SCALAR_TYPE Identity() { return 1; }
+        template <typename SCALAR_TYPE> static SCALAR_TYPE Combine(SCALAR_TYPE i_first, SCALAR_TYPE i_second)
+            { return i_first * i_second; }
+
+        // pow would promote integers to reals, so uniform factors are not distributed
+        static const Operator * GetDistributive() { return &GetOperatorMul(); }
+        static std::optional<Tensor> Repeat(const Tensor &, Integer) { return {}; }
+    };
+
+    struct MinReduction
+    {
+        static constexpr const char * s_name = "min";
+
+        template <typename SCALAR_TYPE> static SCALAR_TYPE Identity()
+        {
+            if constexpr(std::numeric_limits<SCALAR_TYPE>::has_infinity)
+                return std::numeric_limits<SCALAR_TYPE>::infinity();
+            else
+                return std::numeric_limits<SCALAR_TYPE>::max();
+        }
+        template <typename SCALAR_TYPE> static SCALAR_TYPE Combine(SCALAR_TYPE i_first, SCALAR_TYPE i_second)
+            { return std::min(i_first, i_second); }
+
+        static const Operator * GetDistributive() { return nullptr; }
+        static std::optional<Tensor> Repeat(const Tensor &, Integer) { return {}; }
+    };
+
+    struct MaxReduction
+    {
+        static constexpr const char * s_name = "max";
+
+        template <typename SCALAR_TYPE> static SCALAR_TYPE Identity()
+        {
+            if constexpr(std::numeric_limits<SCALAR_TYPE>::has_infinity)
+                return -std::numeric_limits<SCALAR_TYPE>::infinity();
+            else
+                return std::numeric_limits<SCALAR_TYPE>::lowest();
+        }
+        template <typename SCALAR_TYPE> static SCALAR_TYPE Combine(SCALAR_TYPE i_first, SCALAR_TYPE i_second)
+            { return std::max(i_first, i_second); }
+
+        static const Operator * GetDistributive() { return nullptr; }
+        static std::optional<Tensor> Repeat(const Tensor &, Integer) { return {}; }
+    };
+
+    struct AllReduction
+    {
+        static constexpr const char * s_name = "all";
+
+        template <typename SCALAR_TYPE> static SCALAR_TYPE Identity() { return true; }
+        template <typename SCALAR_TYPE> static SCALAR_TYPE Combine(SCALAR_TYPE i_first, SCALAR_TYPE i_second)
+            { return i_first && i_second; }
+
+        // all(a && s) -> all(a) && s, but all over an empty axis is true whatever s is
+        static const Operator * GetDistributive() { return &GetOperatorAnd(); }
+        static std::optional<Tensor> Repeat(const Tensor & i_uniform, Integer i_count)
+            { return i_count != 0 ? std::optional<Tensor>(i_uniform) : std::nullopt; }
+    };
+
+    struct AnyReduction
+    {
+        static constexpr const char * s_name = "any";
+
+        template <typename SCALAR_TYPE> static SCALAR_TYPE Identity() { return false; }
+        template <typename SCALAR_TYPE> static SCALAR_TYPE Combine(SCALAR_TYPE i_first, SCALAR_TYPE i_second)
+            { return i_first || i_second; }
+
+        // any(a || s) -> any(a) || s, but any over an empty axis is false whatever s is
+        static const Operator * GetDistributive() { return &GetOperatorOr(); }
+        static std::optional<Tensor> Repeat(const Tensor & i_uniform, Integer i_count)
+            { return i_count != 0 ? std::optional<Tensor>(i_uniform) : std::nullopt; }
+    };
+
+    // the shape of the result, without the reduced axes, for fixed or symbolic dimensions
+    template <typename DIMENSION>
+        std::vector<DIMENSION> GetKeptDimensions(const char * i_name, Span<const DIMENSION> i_dimensions, ReduceAxes i_axes)
+    {
+        for(size_t axis = i_dimensions.size(); axis < 64; axis++)
+            if(IsReducedAxis(i_axes, axis))
+                Panic(i_name, ": the axis ", axis, " is out of range for the rank ", i_dimensions.size());
+
+        std::vector<DIMENSION> kept;
+        for(size_t axis = 0; axis < i_dimensions.size(); axis++)
+            if(!IsReducedAxis(i_axes, axis))
+                kept.push_back(i_dimensions[axis]);
+        return kept;
+    }
+
+    template <typename REDUCTION>
+        TensorType ReduceDeduceType(const std::any & i_attachment, Span<const Tensor> i_operands)
+    {
+        const TensorType & type = i_operands.at(0).GetExpression()->GetType();
+        if(type.HasFixedShape())
+        {
+            Span<const Integer> const dimensions = type.GetFixedShape().GetDimensions();
+            ReduceAxes const axes = GetReduceAxes(i_attachment, dimensions.size());
+            return { type.GetScalarType(), FixedShape(GetKeptDimensions(REDUCTION::s_name, dimensions, axes)) };
+        }
+        else if(auto const dimensions = TryGetDimensions(type))
+        {
+            ReduceAxes const axes = GetReduceAxes(i_attachment, dimensions->size());
+            return { type.GetScalarType(), MakeShapeVector(GetKeptDimensions(REDUCTION::s_name, Span<const Tensor>(*dimensions), axes)) };
+        }
+        else
+            return type.GetScalarType();
+    }
+
+    /* Pairwise reduction: the range is halved until it's short, and short ranges are reduced
+        with 4 independent accumulators. The error of a floating point sum grows with the depth
+        of the tree rather than with the element count. */
+    template <typename REDUCTION, typename SCALAR_TYPE>
+        SCALAR_TYPE ReduceRange(const SCALAR_TYPE * i_elements, size_t i_count)
+    {
+        constexpr size_t leaf_count = 256;
+        if(i_count > leaf_count)
+        {
+            size_t const half = i_count / 2;
+            return REDUCTION::Combine(ReduceRange<REDUCTION>(i_elements, half),
+                ReduceRange<REDUCTION>(i_elements + half, i_count - half));
+        }
+
+        SCALAR_TYPE accumulators[4] = { REDUCTION::template Identity<SCALAR_TYPE>(),
+            REDUCTION::template Identity<SCALAR_TYPE>(), REDUCTION::template Identity<SCALAR_TYPE>(),
+            REDUCTION::template Identity<SCALAR_TYPE>() };
+        size_t index = 0;
+        for(; index + 4 <= i_count; index += 4)
+            for(size_t lane = 0; lane < 4; lane++)
+                accumulators[lane] = REDUCTION::Combine(accumulators[lane], i_elements[index + lane]);
+        for(; index < i_count; index++)
+            accumulators[0] = REDUCTION::Combine(accumulators[0], i_elements[index]);
+        return REDUCTION::Combine(REDUCTION::Combine(accumulators[0], accumulators[1]),
+            REDUCTION::Combine(accumulators[2], accumulators[3]));
+    }
+
+    /* Returns the elements of the source with the kept axes first and the reduced axes last,
+        so that every element of the result is the reduction of a contiguous range. The source
+        is read with its storage strides, so views are not copied twice. */
+    template <typename SCALAR_TYPE>
+        SharedArray<SCALAR_TYPE> MoveReducedAxesLast(const TensorValue & i_source, ReduceAxes i_axes)
+    {
+        const FixedShape & shape = i_source.GetShape();
+        Span<const Integer> const dimensions = shape.GetDimensions();
+        Span<const Integer> const source_strides = i_source.GetStorageStrides();
+        Span<const SCALAR_TYPE> const storage = i_source.GetStorageAs<SCALAR_TYPE>();
+        size_t const rank = dimensions.size();
+
+        // the source axes in the order of the destination
+        std::vector<size_t> order;
+        for(size_t axis = 0; axis < rank; axis++)
+            if(!IsReducedAxis(i_axes, axis))
+                order.push_back(axis);
+        for(size_t axis = 0; axis < rank; axis++)
+            if(IsReducedAxis(i_axes, axis))
+                order.push_back(axis);
+
+        SharedArray<SCALAR_TYPE> result(static_cast<size_t>(shape.GetLinearSize()));
+        if(result.empty())
+            return result;
+
+        std::vector<Integer> counters(rank);
+
+        // the destination is written sequentially, the source index follows the counters
+        Integer source_index = i_source.GetStorageOffset();
+        for(SCALAR_TYPE & element : result)
+        {
+            element = storage[static_cast<size_t>(source_index) % storage.size()];
+            for(size_t position = rank; position-- > 0; )
+            {
+                size_t const axis = order[position];
+                source_index += source_strides[axis];
+                if(++counters[axis] < dimensions[axis])
+                    break;
+                source_index -= source_strides[axis] * dimensions[axis];
+                counters[axis] = 0;
+            }
+        }
+        return result;
+    }
+
+    /* Every element of the result reduces a contiguous range of 'reduced' elements. Ranges are
+        split in chunks of fixed length, and the chunks are reduced in parallel if the source is
+        large. The partial results of the chunks are then reduced pairwise. Since the chunks do not
+        depend on the number of threads, neither does the result. */
+    template <typename REDUCTION, typename SCALAR_TYPE>
+        TensorValue ReduceEvaluate(const std::any & i_attachment,
+            const TensorType & i_result_type, Span<const TensorValue> i_operands)
+    {
+        const TensorValue & source = i_operands.at(0);
+        const FixedShape & source_shape = source.GetShape();
+        Span<const Integer> const dimensions = source_shape.GetDimensions();
+        ReduceAxes const axes = GetReduceAxes(i_attachment, dimensions.size());
+        Span<const SCALAR_TYPE> const storage = source.GetStorageAs<SCALAR_TYPE>();
+
+        // if the reduced axes are already the last ones, and the storage is dense, it's used in place
+        bool reduced_are_last = true;
+        size_t reduced = 1;
+        for(size_t axis = 0; axis < dimensions.size(); axis++)
+        {
+            if(IsReducedAxis(axes, axis))
+                reduced *= static_cast<size_t>(dimensions[axis]);
+            else if(reduced != 1)
+                reduced_are_last = false;
+        }
+        SharedArray<SCALAR_TYPE> buffer;
+        const SCALAR_TYPE * elements = storage.data();
+        if(!reduced_are_last || source.IsView() || storage.size() != static_cast<size_t>(source_shape.GetLinearSize()))
+        {
+            buffer = MoveReducedAxesLast<SCALAR_TYPE>(source, axes);
+            elements = buffer.data();
+        }
+
+        const FixedShape & result_shape = i_result_type.GetFixedShape();
+        size_t const kept = static_cast<size_t>(result_shape.GetLinearSize());
+
+        constexpr size_t chunk_length = size_t(1) << 14;
+        constexpr size_t parallel_threshold = size_t(1) << 20;
+        size_t const chunks_per_element = std::max<size_t>(1, (reduced + chunk_length - 1) / chunk_length);
+        SharedArray<SCALAR_TYPE> partials(kept * chunks_per_element);
+
+        auto const reduce_chunks = [&](size_t i_begin, size_t i_end) {
+            for(size_t chunk = i_begin; chunk < i_end; chunk++)
+            {
+                size_t const start = (chunk % chunks_per_element) * chunk_length;
+                partials[chunk] = ReduceRange<REDUCTION>(elements + (chunk / chunks_per_element) * reduced + start,
+                    std::min(chunk_length, reduced - start));
+            }
+        };
+
+        size_t const task_count = kept * reduced < parallel_threshold ? 1 : std::clamp<size_t>(
+            std::thread::hardware_concurrency(), 1, partials.size());
+        size_t const chunks_per_task = (partials.size() + task_count - 1) / task_count;
+        std::vector<std::future<void>> tasks;
+        tasks.reserve(task_count);
+        for(size_t task = 1; task < task_count; task++)
+        {
+            size_t const begin = std::min(task * chunks_per_task, partials.size());
+            size_t const end = std::min(begin + chunks_per_task, partials.size());
+            tasks.push_back(std::async(std::launch::async, reduce_chunks, begin, end));
+        }
+        reduce_chunks(0, std::min(chunks_per_task, partials.size()));
+        for(auto & task : tasks)
+            task.get();
+
+        SharedArray<SCALAR_TYPE> result(kept);
+        for(size_t index = 0; index < kept; index++)
+            result[index] = ReduceRange<REDUCTION>(partials.data() + index * chunks_per_element, chunks_per_element);
+
+        return TensorValue(std::move(result), result_shape);
+    }
+
+    // a reduction combines every reduced element with the others
+    Operator::Cost ReduceCost([[maybe_unused]] const std::any & i_attachment,
+        const TensorType & i_result_type, Span<const Tensor> i_operands)
+    {
+        return { Operator::GetElementCount(i_operands.at(0).GetExpression()->GetType()),
+            Operator::GetByteSize(i_result_type) };
+    }
+
+    // reduce(x) -> x if no axis is reduced
+    std::optional<Tensor> ReduceCanonicalizeNoAxes(const Tensor & i_source)
+    {
+        const Expression & expression = *i_source.GetExpression();
+        const std::any & attachment = expression.GetAttachment();
+        if(attachment.has_value() && std::any_cast<ReduceAxes>(attachment) == 0)
+            return expression.GetOperands().at(0);
+        return {};
+    }
+
+    /* reduce(op(a, b)) -> op(reduce(a), reduce(b)), if op is the elementwise version of the
+        reduction. This is done only if no operand is broadcast along the reduced axes, so the
+        large intermediate of op is never computed. Uniform operands (scalars) are handled by
+        REDUCTION::Repeat, since they are broadcast along all the reduced axes. */
+    template <typename REDUCTION>
+        std::optional<Tensor> ReduceCanonicalizeDistribute(const Tensor & i_source)
+    {
+        const Operator * const distributive = REDUCTION::GetDistributive();
+        const Expression & expression = *i_source.GetExpression();
+        const Tensor & operand = expression.GetOperands().at(0);
+        if(distributive == nullptr || !operand.GetExpression()->OperatorIs(*distributive))
+            return {};
+
+        const TensorType & operand_type = operand.GetExpression()->GetType();
+        if(!operand_type.HasFixedShape())
+            return {};
+        const FixedShape & shape = operand_type.GetFixedShape();
+        ReduceAxes const axes = GetReduceAxes(expression.GetAttachment(), shape.GetDimensions().size());
+
+        Integer reduced_count = 1;
+        for(size_t axis = 0; axis < shape.GetDimensions().size(); axis++)
+            if(IsReducedAxis(axes, axis))
+                reduced_count *= shape.GetDimension(static_cast<Integer>(axis));
+
+        std::vector<Tensor> reduced_operands;
+        bool some_full_operand = false;
+        for(const Tensor & term : operand.GetExpression()->GetOperands())
+        {
+            const TensorType & term_type = term.GetExpression()->GetType();
+            if(!term_type.HasFixedShape())
+                return {};
+
+            if(term_type.GetFixedShape() == shape)
+            {
+                reduced_operands.push_back(expression.GetOperator().Invoke({ term }, expression.GetAttachment()));
+                some_full_operand = true;
+            }
+            else if(term_type.GetFixedShape().GetRank() == 0)
+            {
+                std::optional<Tensor> repeated = REDUCTION::Repeat(term, reduced_count);
+                if(!repeated)
+                    return {};
+                reduced_operands.push_back(std::move(*repeated));
+            }
+            else
+                return {};
+        }
+
+        if(!some_full_operand)
+            return {};
+        return distributive->Invoke(reduced_operands);
+    }
+
+    // the gradient of the result is repeated along the reduced axes
+    Tensor ExpandReduced(const Tensor & i_reduced, const Tensor & i_source, ReduceAxes i_axes)
+    {
+        const TensorType & source_type = i_source.GetExpression()->GetType();
+        if(!source_type.HasFixedShape())
+            Panic("reduction: the gradient requires an operand with a fixed shape");
+
+        Span<const Integer> const dimensions = source_type.GetFixedShape().GetDimensions();
+        Tensor result = i_reduced;
+        for(size_t axis = 0; axis < dimensions.size(); axis++)
+            if(IsReducedAxis(i_axes, axis))
+                result = Stack(std::vector<Tensor>(static_cast<size_t>(dimensions[axis]), result),
+                    static_cast<Integer>(axis));
+        return result;
+    }
+
+    ReduceAxes GetReduceAxes(const Tensor & i_reduction)
+    {
+        const Expression & expression = *i_reduction.GetExpression();
+        const TensorType & source_type = expression.GetOperands().at(0).GetExpression()->GetType();
+        size_t const rank = source_type.HasFixedShape() ? source_type.GetFixedShape().GetDimensions().size() : 0;
+        return GetReduceAxes(expression.GetAttachment(), rank);
+    }
+
+    Tensor SumGradient(const Tensor & i_self, const Tensor & i_self_gradient, [[maybe_unused]] size_t i_operand_index)
+    {
+        const Tensor & source = i_self.GetExpression()->GetOperands().at(0);
+        return ExpandReduced(i_self_gradient, source, GetReduceAxes(i_self));
+    }
+
+    /* The derivative of an element is the product of the other elements along the reduced axes.
+        Dividing the product by the element would not be finite where the element is zero, so
+        the zeros are replaced by 1 and counted: if there is one zero only its derivative is not
+        zero, if there are many all the derivatives are zero. */
+    Tensor ProductGradient(const Tensor & i_self, const Tensor & i_self_gradient, [[maybe_unused]] size_t i_operand_index)
+    {
+        const Expression & expression = *i_self.GetExpression();
+        const Tensor & source = expression.GetOperands().at(0);
+        ReduceAxes const axes = GetReduceAxes(i_self);
+
+        Tensor const is_zero = source == 0;
+        Tensor const non_zero = If(is_zero, 1, source);
+        Tensor const non_zero_product = ExpandReduced(
+            GetOperatorProduct().Invoke({ non_zero }, expression.GetAttachment()), source, axes);
+        Tensor const zero_count = ExpandReduced(
+            GetOperatorSum().Invoke({ If(is_zero, 1, 0) }, expression.GetAttachment()), source, axes);
+
+        Tensor const derivative = If(zero_count == 0, non_zero_product / non_zero,
+            is_zero && zero_count == 1, non_zero_product, 0);
+        return ExpandReduced(i_self_gradient, source, axes) * derivative;
+    }
+
+    // the gradient flows to the elements equal to the extreme
+    Tensor ExtremeGradient(const Tensor & i_self, const Tensor & i_self_gradient, [[maybe_unused]] size_t i_operand_index)
+    {
+        const Tensor & source = i_self.GetExpression()->GetOperands().at(0);
+        ReduceAxes const axes = GetReduceAxes(i_self);
+        return If(source == ExpandReduced(i_self, source, axes),
+            ExpandReduced(i_self_gradient, source, axes), 0);
+    }
+
+    const char g_reduce_return_type[] =
+        "The return scalar type is the scalar type of the operand.\n"
+        "The return shape is the shape of the operand without the reduced axes. If no axis is "
+        "specified, all axes are reduced, and the result is a scalar.";
+
+    template <typename REDUCTION>
+        Operator MakeReduceOperator(const char * i_description)
+    {
+        return Operator(REDUCTION::s_name)
+            .SetDoc(i_description, g_reduce_return_type)
+            .SetDeduceType(ReduceDeduceType<REDUCTION>)
+            .SetCost(ReduceCost)
+            .template SetAttachmentComparer<ReduceAxes>()
+            .template SetAttachmentHasher<ReduceAxes>()
+            .template SetAttachmentSerializer<ReduceAxes>()
+            .AddCanonicalize(ReduceCanonicalizeNoAxes)
+            .AddCanonicalize(ReduceCanonicalizeDistribute<REDUCTION>);
+    }
+
+    extern const Operator & GetOperatorSum()
+    {
+        static auto const op = MakeReduceOperator<SumReduction>("Returns the sum of the elements along the reduced axes.")
+            .AddOverload(ReduceEvaluate<SumReduction, Real>, { { ScalarType::Real, "source" } })
+            .AddOverload(ReduceEvaluate<SumReduction, Real32>, { { ScalarType::Real32, "source" } })
+            .AddOverload(ReduceEvaluate<SumReduction, Integer>, { { ScalarType::Integer, "source" } })
+            .AddOverload(ReduceEvaluate<SumReduction, Integer32>, { { ScalarType::Integer32, "source" } })
+            .AddOverload(ReduceEvaluate<SumReduction, Integer8>, { { ScalarType::Integer8, "source" } })
+            .SetGradientOfOperand(SumGradient);
+        return op;
+    }
+
+    extern const Operator & GetOperatorProduct()
+    {
+        static auto const op = MakeReduceOperator<ProductReduction>("Returns the product of the elements along the reduced axes.")
+            .AddOverload(ReduceEvaluate<ProductReduction, Real>, { { ScalarType::Real, "source" } })
+            .AddOverload(ReduceEvaluate<ProductReduction, Real32>, { { ScalarType::Real32, "source" } })
+            .AddOverload(ReduceEvaluate<ProductReduction, Integer>, { { ScalarType::Integer, "source" } })
+            .AddOverload(ReduceEvaluate<ProductReduction, Integer32>, { { ScalarType::Integer32, "source" } })
+            .AddOverload(ReduceEvaluate<ProductReduction, Integer8>, { { ScalarType::Integer8, "source" } })
+            .SetGradientOfOperand(ProductGradient);
+        return op;
+    }
+
+    extern const Operator & GetOperatorMin()
+    {
+        static auto const op = MakeReduceOperator<MinReduction>("Returns the minimum of the elements along the reduced axes.")
+            .AddOverload(ReduceEvaluate<MinReduction, Real>, { { ScalarType::Real, "source" } })
+            .AddOverload(ReduceEvaluate<MinReduction, Real32>, { { ScalarType::Real32, "source" } })
+            .AddOverload(ReduceEvaluate<MinReduction, Integer>, { { ScalarType::Integer, "source" } })
+            .AddOverload(ReduceEvaluate<MinReduction, Integer32>, { { ScalarType::Integer32, "source" } })
+            .AddOverload(ReduceEvaluate<MinReduction, Integer8>, { { ScalarType::Integer8, "source" } })
+            .SetGradientOfOperand(ExtremeGradient);
+        return op;
+    }
+
+    extern const Operator & GetOperatorMax()
+    {
+        static auto const op = MakeReduceOperator<MaxReduction>("Returns the maximum of the elements along the reduced axes.")
+            .AddOverload(ReduceEvaluate<MaxReduction, Real>, { { ScalarType::Real, "source" } })
+            .AddOverload(ReduceEvaluate<MaxReduction, Real32>, { { ScalarType::Real32, "source" } })
+            .AddOverload(ReduceEvaluate<MaxReduction, Integer>, { { ScalarType::Integer, "source" } })
+            .AddOverload(ReduceEvaluate<MaxReduction, Integer32>, { { ScalarType::Integer32, "source" } })
+            .AddOverload(ReduceEvaluate<MaxReduction, Integer8>, { { ScalarType::Integer8, "source" } })
+            .SetGradientOfOperand(ExtremeGradient);
+        return op;
+    }
+
+    extern const Operator & GetOperatorAll()
+    {
+        static auto const op = MakeReduceOperator<AllReduction>("Returns true where all the elements along the reduced axes are true.")
+            .AddOverload(ReduceEvaluate<AllReduction, Bool>, { { ScalarType::Bool, "source" } });
+        return op;
+    }
+
+    extern const Operator & GetOperatorAny()
+    {
+        static auto const op = MakeReduceOperator<AnyReduction>("Returns true where any of the elements along the reduced axes is true.")
+            .AddOverload(ReduceEvaluate<AnyReduction, Bool>, { { ScalarType::Bool, "source" } });
+        return op;
+    }
+
+    /* Reduces the given axes. If the shape of the source is known and all the axes are
+        reduced the axes are not attached, so the result is identical to the one of the
+        overload without axes. */
+    Tensor Reduce(const Operator & i_operator, const Tensor & i_source, Span<const Integer> i_axes)
+    {
+        ReduceAxes axes = 0;
+        for(Integer const axis : i_axes)
+        {
+            if(axis < 0 || axis >= 64)
+                Panic(i_operator.GetName(), ": the axis ", axis, " is out of range");
+            axes |= ReduceAxes(1) << axis;
+        }
+
+        const TensorType & type = i_source.GetExpression()->GetType();
+        if(type.HasFixedShape() && axes == GetReduceAxes({}, type.GetFixedShape().GetDimensions().size()))
+            return i_operator.Invoke({ i_source });
+        return i_operator.Invoke({ i_source }, axes);
+    }
+
+    Tensor Sum(const Tensor & i_source) { return GetOperatorSum().Invoke({ i_source }); }
+    Tensor Sum(const Tensor & i_source, Span<const Integer> i_axes) { return Reduce(GetOperatorSum(), i_source, i_axes); }
+
+    Tensor Product(const Tensor & i_source) { return GetOperatorProduct().Invoke({ i_source }); }
+    Tensor Product(const Tensor & i_source, Span<const Integer> i_axes) { return Reduce(GetOperatorProduct(), i_source, i_axes); }
+
+    Tensor Min(const Tensor & i_source) { return GetOperatorMin().Invoke({ i_source }); }
+    Tensor Min(const Tensor & i_source, Span<const Integer> i_axes) { return Reduce(GetOperatorMin(), i_source, i_axes); }
+
+    Tensor Max(const Tensor & i_source) { return GetOperatorMax().Invoke({ i_source }); }
+    Tensor Max(const Tensor & i_source, Span<const Integer> i_axes) { return Reduce(GetOperatorMax(), i_source, i_axes); }
+
+    Tensor All(const Tensor & i_source) { return GetOperatorAll().Invoke({ i_source }); }
+    Tensor All(const Tensor & i_source, Span<const Integer> i_axes) { return Reduce(GetOperatorAll(), i_source, i_axes); }
+
+    Tensor Any(const Tensor & i_source) { return GetOperatorAny().Invoke({ i_source }); }
+    Tensor Any(const Tensor & i_source, Span<const Integer> i_axes) { return Reduce(GetOperatorAny(), i_source, i_axes); }
+}
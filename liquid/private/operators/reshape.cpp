@@ -0,0 +1,105 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "expression.h"
+#include "operator.h"
+#include "tensor_value.h"
+#include "tensor_type.h"
+#include <algorithm>
+
+namespace liquid
+{
+    extern const Operator & GetOperatorReshape();
+
+    TensorType ReshapeDeduceType(const std::any & i_attachment, Span<const Tensor> i_operands)
+    {
+        const TensorType & source_type = i_operands.at(0).GetExpression()->GetType();
+        const FixedShape & shape = std::any_cast<const FixedShape &>(i_attachment);
+        if(source_type.HasFixedShape() && source_type.GetFixedShape().GetLinearSize() != shape.GetLinearSize())
+            Panic("reshape: can't reshape ", source_type.GetFixedShape(), " to ", shape,
+                ", the element counts are different");
+        return { source_type.GetScalarType(), shape };
+    }
+
+    // whether the elements of the value are in the storage in row-major order, possibly wrapped
+    bool IsRowMajor(const TensorValue & i_value)
+    {
+        if(!i_value.IsView())
+            return true;
+
+        const FixedShape & shape = i_value.GetShape();
+        Span<const Integer> const strides = i_value.GetStorageStrides();
+        for(size_t dimension = 0; dimension < strides.size(); dimension++)
+            if(shape.GetDimension(NumericCast<Integer>(dimension)) != 1 &&
+                    strides[dimension] != shape.GetStride(NumericCast<Integer>(dimension + 1)))
+                return false;
+        return true;
+    }
+
+    /* A reshape never changes the linear order of the elements, so the result is a view with
+        row-major strides. A view with a different layout is copied once, and then reshaped. */
+    template <typename SCALAR_TYPE>
+        TensorValue ReshapeEvaluate([[maybe_unused]] const std::any & i_attachment,
+            const TensorType & i_result_type, Span<const TensorValue> i_operands)
+    {
+        const TensorValue & source = i_operands.at(0);
+        const FixedShape & result_shape = i_result_type.GetFixedShape();
+        Span<const Integer> const strides = result_shape.GetStrides().subspan(1);
+        if(IsRowMajor(source))
+            return TensorValue(source, result_shape, strides, source.GetStorageOffset());
+
+        TensorValue const dense(SharedArray<const SCALAR_TYPE>(source.GetAs<SCALAR_TYPE>()), source.GetShape());
+        return TensorValue(dense, result_shape, strides, 0);
+    }
+
+    // reshape(x) -> x if the shape does not change, reshape(reshape(x)) -> reshape(x)
+    std::optional<Tensor> ReshapeCanonicalize(const Tensor & i_source)
+    {
+        const Expression & expression = *i_source.GetExpression();
+        const Tensor & operand = expression.GetOperands().at(0);
+        const TensorType & operand_type = operand.GetExpression()->GetType();
+        if(operand_type.HasFixedShape() && operand_type.GetFixedShape() == expression.GetType().GetFixedShape())
+            return operand;
+        if(operand.GetExpression()->OperatorIs(GetOperatorReshape()))
+            return GetOperatorReshape().Invoke({ operand.GetExpression()->GetOperands().at(0) }, expression.GetAttachment());
+        return {};
+    }
+
+    Tensor ReshapeGradient(const Tensor & i_self, const Tensor & i_self_gradient, [[maybe_unused]] size_t i_operand_index)
+    {
+        const Tensor & source = i_self.GetExpression()->GetOperands().at(0);
+        const TensorType & source_type = source.GetExpression()->GetType();
+        if(!source_type.HasFixedShape())
+            Panic("reshape: the gradient requires an operand with a fixed shape");
+        return GetOperatorReshape().Invoke({ i_self_gradient }, source_type.GetFixedShape());
+    }
+
+    extern const Operator & GetOperatorReshape()
+    {
+        static auto const op = Operator("reshape")
+            .SetDoc("Returns the elements of the source, in the same order, with a different shape.",
+                "The return scalar type is the scalar type of the source.\n"
+                "The return shape is the requested one, that must have the same number of elements of the source.")
+            .SetDeduceType(ReshapeDeduceType)
+            .SetCost(Operator::ViewCost)
+            .AddOverload(ReshapeEvaluate<Real>, { { ScalarType::Real, "source" } })
+            .AddOverload(ReshapeEvaluate<Real32>, { { ScalarType::Real32, "source" } })
+            .AddOverload(ReshapeEvaluate<Integer>, { { ScalarType::Integer, "source" } })
+            .AddOverload(ReshapeEvaluate<Integer32>, { { ScalarType::Integer32, "source" } })
+            .AddOverload(ReshapeEvaluate<Integer8>, { { ScalarType::Integer8, "source" } })
+            .AddOverload(ReshapeEvaluate<Bool>, { { ScalarType::Bool, "source" } })
+            .SetAttachmentComparer<FixedShape>()
+            .SetAttachmentHasher<FixedShape>()
+            .SetAttachmentSerializer<FixedShape>()
+            .AddCanonicalize(ReshapeCanonicalize)
+            .SetGradientOfOperand(ReshapeGradient);
+        return op;
+    }
+
+    Tensor Reshape(const Tensor & i_source, Span<const Integer> i_shape)
+    {
+        return GetOperatorReshape().Invoke({ i_source }, FixedShape(i_shape));
+    }
+}
@@ -0,0 +1,143 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "expression.h"
+#include "operator.h"
+#include "tensor_value.h"
+#include "tensor_type.h"
+#include "index_kernel.h"
+#include <algorithm>
+
+namespace liquid
+{
+    extern const Operator & GetOperatorScatterAdd();
+
+    // the axis is attached only if it's not zero
+    Integer GetScatterAxis(const std::any & i_attachment)
+    {
+        return i_attachment.has_value() ? std::any_cast<Integer>(i_attachment) : 0;
+    }
+
+    TensorType ScatterAddDeduceType(const std::any & i_attachment, Span<const Tensor> i_operands)
+    {
+        const TensorType & target_type = i_operands.at(0).GetExpression()->GetType();
+        const TensorType & indices_type = i_operands.at(1).GetExpression()->GetType();
+        const TensorType & updates_type = i_operands.at(2).GetExpression()->GetType();
+        ScalarType const scalar_type = DeduceScalarType({ target_type.GetScalarType(), updates_type.GetScalarType() });
+        if(!target_type.HasFixedShape() || !indices_type.HasFixedShape() || !updates_type.HasFixedShape())
+            return scalar_type;
+
+        // the updates have the shape of the elements gathered from the target at the indices
+        FixedShape const gathered = GetGatheredShape("scatter_add", target_type.GetFixedShape(),
+            indices_type.GetFixedShape(), GetScatterAxis(i_attachment));
+        if(gathered != updates_type.GetFixedShape())
+            Panic("scatter_add: the updates have the shape ", updates_type.GetFixedShape(),
+                ", the expected shape is ", gathered);
+
+        return { scalar_type, target_type.GetFixedShape() };
+    }
+
+    /* Every block of the updates is added to the block of the target selected by its index,
+        so repeated indices accumulate. Contiguous indices select a single larger block for
+        every outer group. */
+    template <typename SCALAR_TYPE>
+        TensorValue ScatterAddEvaluate(const std::any & i_attachment,
+            const TensorType & i_result_type, Span<const TensorValue> i_operands)
+    {
+        const TensorValue & target = i_operands.at(0);
+        const TensorValue & indices_value = i_operands.at(1);
+        const TensorValue & updates = i_operands.at(2);
+        IndexedAxis const shape = GetIndexedAxis(target.GetShape(), GetScatterAxis(i_attachment));
+
+        SharedArray<Integer> indices_buffer;
+        Span<const Integer> const indices(GetUnwrapped(indices_value, indices_buffer),
+            NumericCast<size_t>(indices_value.GetShape().GetLinearSize()));
+        IndexSequence const sequence = CheckIndices("scatter_add", indices, shape.m_dimension);
+
+        SharedArray<SCALAR_TYPE> result;
+        const SCALAR_TYPE * const target_elements = GetUnwrapped(target, result);
+        if(result.empty())
+            result = SharedArray<SCALAR_TYPE>(Span<const SCALAR_TYPE>(target_elements,
+                NumericCast<size_t>(target.GetShape().GetLinearSize())));
+
+        SharedArray<SCALAR_TYPE> updates_buffer;
+        const SCALAR_TYPE * source = GetUnwrapped(updates, updates_buffer);
+
+        for(size_t outer = 0; outer < shape.m_outer; outer++)
+        {
+            SCALAR_TYPE * const group = result.data() + outer * shape.m_dimension * shape.m_inner;
+            if(sequence.m_contiguous && !indices.empty())
+            {
+                size_t const length = indices.size() * shape.m_inner;
+                SCALAR_TYPE * const dest = group + NumericCast<size_t>(indices[0]) * shape.m_inner;
+                for(size_t element = 0; element < length; element++)
+                    dest[element] += source[element];
+                source += length;
+                continue;
+            }
+
+            for(Integer index : indices)
+            {
+                SCALAR_TYPE * const dest = group + NumericCast<size_t>(index) * shape.m_inner;
+                for(size_t element = 0; element < shape.m_inner; element++)
+                    dest[element] += source[element];
+                source += shape.m_inner;
+            }
+        }
+        return TensorValue(std::move(result), i_result_type.GetFixedShape());
+    }
+
+    // an addition for every element of the updates
+    Operator::Cost ScatterAddCost([[maybe_unused]] const std::any & i_attachment,
+        const TensorType & i_result_type, Span<const Tensor> i_operands)
+    {
+        return { Operator::GetElementCount(i_operands.at(2).GetExpression()->GetType()),
+            Operator::GetByteSize(i_result_type) };
+    }
+
+    Tensor ScatterAddGradient(const Tensor & i_self, const Tensor & i_self_gradient, size_t i_operand_index)
+    {
+        const Expression & expression = *i_self.GetExpression();
+        switch(i_operand_index)
+        {
+            case 0: return i_self_gradient;
+            case 2: return Gather(i_self_gradient, expression.GetOperands().at(1), GetScatterAxis(expression.GetAttachment()));
+            default: Panic("scatter_add: the indices are not differentiable");
+        }
+    }
+
+    extern const Operator & GetOperatorScatterAdd()
+    {
+        static auto const op = Operator("scatter_add")
+            .SetDoc("Returns the target with the updates added at the indices along an axis. Repeated indices accumulate.",
+                "The return scalar type is deduced performing numeric promotion from the target and the updates.\n"
+                "The return shape is the shape of the target. The shape of the updates is the shape of the target "
+                "with the axis replaced by the shape of the indices.")
+            .SetDeduceType(ScatterAddDeduceType)
+            .SetCost(ScatterAddCost)
+            .AddOverload(ScatterAddEvaluate<Real>, { { ScalarType::Real, "target" }, { ScalarType::Integer, "indices" },
+                { ScalarType::Real, "updates" } })
+            .AddOverload(ScatterAddEvaluate<Real32>, { { ScalarType::Real32, "target" }, { ScalarType::Integer, "indices" },
+                { ScalarType::Real32, "updates" } })
+            .AddOverload(ScatterAddEvaluate<Integer>, { { ScalarType::Integer, "target" }, { ScalarType::Integer, "indices" },
+                { ScalarType::Integer, "updates" } })
+            .AddOverload(ScatterAddEvaluate<Integer32>, { { ScalarType::Integer32, "target" }, { ScalarType::Integer, "indices" },
+                { ScalarType::Integer32, "updates" } })
+            .AddOverload(ScatterAddEvaluate<Integer8>, { { ScalarType::Integer8, "target" }, { ScalarType::Integer, "indices" },
+                { ScalarType::Integer8, "updates" } })
+            .SetAttachmentComparer<Integer>()
+            .SetAttachmentHasher<Integer>()
+            .SetAttachmentSerializer<Integer>()
+            .SetGradientOfOperand(ScatterAddGradient);
+        return op;
+    }
+
+    Tensor ScatterAdd(const Tensor & i_target, const Tensor & i_indices, const Tensor & i_updates, Integer i_axis)
+    {
+        if(i_axis == 0)
+            return GetOperatorScatterAdd().Invoke({ i_target, i_indices, i_updates });
+        return GetOperatorScatterAdd().Invoke({ i_target, i_indices, i_updates }, i_axis);
+    }
+}
@@ -16,7 +16,7 @@ namespace liquid
         Span<const Tensor> i_operands)
     {
         // shape_of_shape is a vector
-        Tensor const shape_of_shape = { { Rank(i_operands.at(0)) } };
+        Tensor const shape_of_shape = Stack({ Rank(i_operands.at(0)) });
         return { ScalarType::Integer, shape_of_shape };
     }
 
@@ -41,13 +41,27 @@ namespace liquid
         return TensorValue(std::move(result), i_result_type.GetFixedShape());
     }
 
+    // the shape of a tensor with a symbolic shape is the vector of its dimensions
+    std::optional<Tensor> ShapeCanonicalize(const Tensor & i_source)
+    {
+        const TensorType & type = i_source.GetExpression()->GetOperand(0).GetExpression()->GetType();
+        if(auto const dimensions = TryGetDimensions(type))
+            return Stack(*dimensions);
+        return {};
+    }
+
     extern const Operator & GetOperatorShape()
     {
         static auto const op = Operator("shape")
+            .SetCost(Operator::ZeroFlopsCost)
             .SetDeduceType(ShapeDeduceType)
             .SetEligibleForPropagation(ShapeEligibleForPropagation)
+            .AddCanonicalize(ShapeCanonicalize)
             .AddOverload(ShapeEvaluate, {{ ScalarType::Real, "source" }} )
+            .AddOverload(ShapeEvaluate, {{ ScalarType::Real32, "source" }} )
             .AddOverload(ShapeEvaluate, {{ ScalarType::Integer, "source" }} )
+            .AddOverload(ShapeEvaluate, {{ ScalarType::Integer32, "source" }} )
+            .AddOverload(ShapeEvaluate, {{ ScalarType::Integer8, "source" }} )
             .AddOverload(ShapeEvaluate, {{ ScalarType::Bool, "source" }} );
         return op;
     }
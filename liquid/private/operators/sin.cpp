@@ -9,18 +9,32 @@
 #include "tensor_value.h"
 #include "tensor_type.h"
 #include "indices.h"
+#include "fast_math.h"
 #include <cmath>
 
 namespace liquid
 {
-    TensorValue SinEvaluate(const TensorType & i_result_type, const TensorValue & i_operand)
+    template <typename SCALAR_TYPE>
+        TensorValue SinEvaluate(const TensorType & i_result_type, const TensorValue & i_operand)
     {
         const FixedShape & result_shape = i_result_type.GetFixedShape();
-        SharedArray<Real> result(static_cast<size_t>(result_shape.GetLinearSize()));
+        if constexpr(std::is_same_v<SCALAR_TYPE, Real>)
+        {
+            if(GetPrecision() == Precision::Fast)
+            {
+                // the storage of the result wraps like the storage of the operand
+                Span<const Real> const source = i_operand.GetAs<Real>();
+                SharedArray<Real> result(source.size());
+                FastSin(source.data(), result.data(), source.size());
+                return TensorValue(std::move(result), result_shape);
+            }
+        }
+
+        SharedArray<SCALAR_TYPE> result(static_cast<size_t>(result_shape.GetLinearSize()));
 
         for (Indices indices(result_shape); indices; indices++)
         {
-            auto const element = indices.At<Real>(i_operand);
+            auto const element = indices.At<SCALAR_TYPE>(i_operand);
             indices[result] = std::sin(element);
         }
 
@@ -37,7 +51,9 @@ namespace liquid
     extern const Operator & GetOperatorSin()
     {
         static auto const op = Operator("sin")
-            .AddOverload(SinEvaluate, { {ScalarType::Real, "operand"} } )
+            .SetCost(Operator::ElementwiseCost<8>)
+            .AddOverload(SinEvaluate<Real>, { {ScalarType::Real, "operand"} } )
+            .AddOverload(SinEvaluate<Real32>, { {ScalarType::Real32, "operand"} } )
             .SetGradientOfOperand(SinGradient);
         return op;
     }
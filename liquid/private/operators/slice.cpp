@@ -0,0 +1,139 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "expression.h"
+#include "operator.h"
+#include "tensor_value.h"
+#include "tensor_type.h"
+#include <algorithm>
+
+namespace liquid
+{
+    extern const Operator & GetOperatorSlice();
+
+    /* The attachment is { axis, start, stop, step }. Negative start and stop count from the
+        end of the axis, and are clamped like Python slices. */
+    struct SliceRange
+    {
+        Integer m_axis = 0;
+        Integer m_start = 0;
+        Integer m_step = 1;
+        Integer m_count = 0;
+    };
+
+    SliceRange GetSliceRange(const std::any & i_attachment, const FixedShape & i_shape)
+    {
+        const std::vector<Integer> & attachment = std::any_cast<const std::vector<Integer> &>(i_attachment);
+        SliceRange range;
+        range.m_axis = attachment.at(0);
+        range.m_step = attachment.at(3);
+        if(range.m_axis < 0 || range.m_axis >= i_shape.GetRank())
+            Panic("slice: the axis ", range.m_axis, " is out of range for the rank ", i_shape.GetRank());
+        if(range.m_step == 0)
+            Panic("slice: the step can't be zero");
+
+        Integer const dimension = i_shape.GetDimension(range.m_axis);
+        auto const normalize = [&](Integer i_index) {
+            if(i_index < 0)
+                i_index += dimension;
+            return range.m_step > 0 ? std::clamp<Integer>(i_index, 0, dimension) :
+                std::clamp<Integer>(i_index, -1, dimension - 1);
+        };
+        range.m_start = normalize(attachment.at(1));
+        Integer const stop = normalize(attachment.at(2));
+
+        Integer const distance = range.m_step > 0 ? stop - range.m_start : range.m_start - stop;
+        Integer const step = range.m_step > 0 ? range.m_step : -range.m_step;
+        range.m_count = std::max<Integer>(0, (distance + step - 1) / step);
+        return range;
+    }
+
+    FixedShape GetSlicedShape(const FixedShape & i_shape, const SliceRange & i_range)
+    {
+        std::vector<Integer> dimensions(i_shape.GetDimensions().begin(), i_shape.GetDimensions().end());
+        dimensions[NumericCast<size_t>(i_range.m_axis)] = i_range.m_count;
+        return FixedShape(dimensions);
+    }
+
+    TensorType SliceDeduceType(const std::any & i_attachment, Span<const Tensor> i_operands)
+    {
+        const TensorType & source_type = i_operands.at(0).GetExpression()->GetType();
+        if(!source_type.HasFixedShape())
+            return source_type.GetScalarType();
+
+        const FixedShape & shape = source_type.GetFixedShape();
+        return { source_type.GetScalarType(), GetSlicedShape(shape, GetSliceRange(i_attachment, shape)) };
+    }
+
+    // the result is a view: the stride of the axis is multiplied by the step
+    TensorValue SliceEvaluate(const std::any & i_attachment,
+        const TensorType & i_result_type, Span<const TensorValue> i_operands)
+    {
+        const TensorValue & source = i_operands.at(0);
+        SliceRange const range = GetSliceRange(i_attachment, source.GetShape());
+        size_t const axis = NumericCast<size_t>(range.m_axis);
+
+        std::vector<Integer> strides(source.GetStorageStrides().begin(), source.GetStorageStrides().end());
+        Integer const offset = source.GetStorageOffset() + range.m_start * strides[axis];
+        strides[axis] *= range.m_step;
+        return TensorValue(source, i_result_type.GetFixedShape(), strides, offset);
+    }
+
+    // slice(x) -> x if all the elements are taken in order
+    std::optional<Tensor> SliceCanonicalize(const Tensor & i_source)
+    {
+        const Expression & expression = *i_source.GetExpression();
+        const Tensor & operand = expression.GetOperands().at(0);
+        const TensorType & operand_type = operand.GetExpression()->GetType();
+        if(!operand_type.HasFixedShape())
+            return {};
+
+        SliceRange const range = GetSliceRange(expression.GetAttachment(), operand_type.GetFixedShape());
+        if(range.m_start == 0 && range.m_step == 1 && range.m_count == operand_type.GetFixedShape().GetDimension(range.m_axis))
+            return operand;
+        return {};
+    }
+
+    // the gradient is scattered to the sliced positions
+    Tensor SliceGradient(const Tensor & i_self, const Tensor & i_self_gradient, [[maybe_unused]] size_t i_operand_index)
+    {
+        const Tensor & source = i_self.GetExpression()->GetOperands().at(0);
+        const TensorType & source_type = source.GetExpression()->GetType();
+        if(!source_type.HasFixedShape())
+            Panic("slice: the gradient requires an operand with a fixed shape");
+
+        const FixedShape & shape = source_type.GetFixedShape();
+        SliceRange const range = GetSliceRange(i_self.GetExpression()->GetAttachment(), shape);
+        SharedArray<Integer> indices(NumericCast<size_t>(range.m_count));
+        for(size_t index = 0; index < indices.size(); index++)
+            indices[index] = range.m_start + NumericCast<Integer>(index) * range.m_step;
+
+        Tensor const zero = Cast(source_type.GetScalarType(), Tensor(0, shape.GetDimensions()));
+        return ScatterAdd(zero, MakeConstant(TensorValue(std::move(indices), FixedShape({ range.m_count }))),
+            i_self_gradient, range.m_axis);
+    }
+
+    extern const Operator & GetOperatorSlice()
+    {
+        static auto const op = Operator("slice")
+            .SetDoc("Returns the elements of the source from start to stop, excluded, with the given step along an axis.",
+                "The return scalar type is the scalar type of the source.\n"
+                "The return shape is the shape of the source, with the dimension of the axis equal to the number of taken elements.")
+            .SetDeduceType(SliceDeduceType)
+            .SetCost(Operator::ViewCost)
+            .AddOverload(SliceEvaluate, { { ScalarType::Any, "source" } })
+            .SetAttachmentComparer<std::vector<Integer>>()
+            .SetAttachmentHasher<std::vector<Integer>>()
+            .SetAttachmentSerializer<std::vector<Integer>>()
+            .AddCanonicalize(SliceCanonicalize)
+            .SetGradientOfOperand(SliceGradient);
+        return op;
+    }
+
+    Tensor Slice(const Tensor & i_source, Integer i_axis, Integer i_start, Integer i_stop, Integer i_step)
+    {
+        return GetOperatorSlice().Invoke({ i_source }, std::vector<Integer>{ i_axis, i_start, i_stop, i_step });
+    }
+}
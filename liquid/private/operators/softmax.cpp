@@ -0,0 +1,285 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "expression.h"
+#include "operator.h"
+#include "tensor_value.h"
+#include "tensor_type.h"
+#include "index_kernel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace liquid
+{
+    extern const Operator & GetOperatorSoftmax();
+    extern const Operator & GetOperatorLogSumExp();
+
+    /* Softmax and log-sum-exp have the axis as attachment. Without attachment the axis
+        is the last one. */
+    Integer GetSoftmaxAxis(const std::any & i_attachment, Integer i_rank)
+    {
+        return i_attachment.has_value() ? std::any_cast<Integer>(i_attachment) : i_rank - 1;
+    }
+
+    Integer GetSoftmaxAxis(const char * i_name, const std::any & i_attachment, size_t i_rank)
+    {
+        Integer const rank = NumericCast<Integer>(i_rank);
+        Integer const axis = GetSoftmaxAxis(i_attachment, rank);
+        if(axis < 0 || axis >= rank)
+            Panic(i_name, ": the axis ", axis, " is out of range for the rank ", rank);
+        return axis;
+    }
+
+    // the shape of the source with the dimension of the axis equal to 1
+    std::vector<Integer> GetSoftmaxKeptDimensions(const FixedShape & i_shape, Integer i_axis)
+    {
+        std::vector<Integer> dimensions(i_shape.GetDimensions().begin(), i_shape.GetDimensions().end());
+        dimensions[NumericCast<size_t>(i_axis)] = 1;
+        return dimensions;
+    }
+
+    /* The elements are read as rows of lanes: with the axis in the middle every lane is an
+        inner position, while a contiguous axis is split in rows of g_log_sum_exp_lanes lanes
+        that are merged at the end. */
+    constexpr size_t g_log_sum_exp_lanes = 8;
+    constexpr size_t g_log_sum_exp_block_rows = 16;
+
+    // the elements are shifted by the maximum, unless it's infinite
+    Real GetLogSumExpShift(Real i_max)
+    {
+        return std::isfinite(i_max) ? i_max : 0;
+    }
+
+    /* Accumulates rows of lanes in a running maximum and a sum of exp(x - maximum) for every
+        lane. The maximum of a block of rows is found first, so the sum is rescaled once per
+        block, and every inner loop runs over contiguous lanes. */
+    void AccumulateLogSumExp(const Real * i_source, size_t i_rows, size_t i_lanes, Real * io_max, Real * io_sum)
+    {
+        std::vector<Real> block_max(i_lanes);
+        for(size_t first_row = 0; first_row < i_rows; first_row += g_log_sum_exp_block_rows)
+        {
+            size_t const rows = std::min(g_log_sum_exp_block_rows, i_rows - first_row);
+            const Real * const block = i_source + first_row * i_lanes;
+
+            std::copy_n(io_max, i_lanes, block_max.data());
+            for(size_t row = 0; row < rows; row++)
+                for(size_t lane = 0; lane < i_lanes; lane++)
+                    block_max[lane] = std::max(block_max[lane], block[row * i_lanes + lane]);
+
+            for(size_t lane = 0; lane < i_lanes; lane++)
+            {
+                Real const shift = GetLogSumExpShift(block_max[lane]);
+                if(io_sum[lane] != 0)
+                    io_sum[lane] *= std::exp(GetLogSumExpShift(io_max[lane]) - shift);
+                io_max[lane] = block_max[lane];
+                block_max[lane] = shift;
+            }
+
+            for(size_t row = 0; row < rows; row++)
+                for(size_t lane = 0; lane < i_lanes; lane++)
+                    io_sum[lane] += std::exp(block[row * i_lanes + lane] - block_max[lane]);
+        }
+    }
+
+    Real MergeLogSumExp(const Real * i_max, const Real * i_sum, size_t i_lanes)
+    {
+        Real const max = *std::max_element(i_max, i_max + i_lanes);
+        Real const shift = GetLogSumExpShift(max);
+        Real sum = 0;
+        for(size_t lane = 0; lane < i_lanes; lane++)
+            if(i_sum[lane] != 0)
+                sum += i_sum[lane] * std::exp(GetLogSumExpShift(i_max[lane]) - shift);
+        return shift + std::log(sum);
+    }
+
+    /* Computes the log-sum-exp of the elements along the axis in one pass, for every outer
+        group and inner position. The result is laid out as [outer, inner]. */
+    std::vector<Real> ComputeLogSumExp(const Real * i_elements, const IndexedAxis & i_shape)
+    {
+        Real const lowest = -std::numeric_limits<Real>::infinity();
+        std::vector<Real> result(i_shape.m_outer * i_shape.m_inner);
+        for(size_t outer = 0; outer < i_shape.m_outer; outer++)
+        {
+            const Real * const group = i_elements + outer * i_shape.m_dimension * i_shape.m_inner;
+            if(i_shape.m_inner == 1)
+            {
+                Real max[g_log_sum_exp_lanes], sum[g_log_sum_exp_lanes] = {};
+                std::fill_n(max, g_log_sum_exp_lanes, lowest);
+                size_t const rows = i_shape.m_dimension / g_log_sum_exp_lanes;
+                AccumulateLogSumExp(group, rows, g_log_sum_exp_lanes, max, sum);
+                AccumulateLogSumExp(group + rows * g_log_sum_exp_lanes,
+                    i_shape.m_dimension - rows * g_log_sum_exp_lanes, 1, max, sum);
+                result[outer] = MergeLogSumExp(max, sum, g_log_sum_exp_lanes);
+            }
+            else
+            {
+                std::vector<Real> max(i_shape.m_inner, lowest), sum(i_shape.m_inner);
+                AccumulateLogSumExp(group, i_shape.m_dimension, i_shape.m_inner, max.data(), sum.data());
+                Real * const dest = result.data() + outer * i_shape.m_inner;
+                for(size_t inner = 0; inner < i_shape.m_inner; inner++)
+                    dest[inner] = GetLogSumExpShift(max[inner]) + std::log(sum[inner]);
+            }
+        }
+        return result;
+    }
+
+    TensorType LogSumExpDeduceType(const std::any & i_attachment, Span<const Tensor> i_operands)
+    {
+        const TensorType & source_type = i_operands.at(0).GetExpression()->GetType();
+        if(source_type.HasFixedShape())
+        {
+            const FixedShape & shape = source_type.GetFixedShape();
+            size_t const axis = NumericCast<size_t>(GetSoftmaxAxis("log_sum_exp", i_attachment, shape.GetDimensions().size()));
+            std::vector<Integer> dimensions(shape.GetDimensions().begin(), shape.GetDimensions().end());
+            dimensions.erase(dimensions.begin() + NumericCast<std::ptrdiff_t>(axis));
+            return { ScalarType::Real, FixedShape(dimensions) };
+        }
+        else if(auto dimensions = TryGetDimensions(source_type))
+        {
+            size_t const axis = NumericCast<size_t>(GetSoftmaxAxis("log_sum_exp", i_attachment, dimensions->size()));
+            dimensions->erase(dimensions->begin() + NumericCast<std::ptrdiff_t>(axis));
+            return { ScalarType::Real, MakeShapeVector(*dimensions) };
+        }
+        else
+            return ScalarType::Real;
+    }
+
+    TensorType SoftmaxDeduceType(const std::any & i_attachment, Span<const Tensor> i_operands)
+    {
+        const TensorType & source_type = i_operands.at(0).GetExpression()->GetType();
+        std::optional<size_t> const rank = TryGetRank(source_type);
+        if(!rank)
+            return ScalarType::Real;
+
+        GetSoftmaxAxis("softmax", i_attachment, *rank);
+        return { ScalarType::Real, source_type.GetShape() };
+    }
+
+    TensorValue LogSumExpEvaluate(const std::any & i_attachment,
+        const TensorType & i_result_type, Span<const TensorValue> i_operands)
+    {
+        const TensorValue & source = i_operands.at(0);
+        IndexedAxis const shape = GetIndexedAxis(source.GetShape(),
+            GetSoftmaxAxis(i_attachment, source.GetShape().GetRank()));
+
+        SharedArray<Real> source_buffer;
+        std::vector<Real> const log_sum_exp = ComputeLogSumExp(GetUnwrapped(source, source_buffer), shape);
+        return TensorValue(SharedArray<Real>(Span<const Real>(log_sum_exp.data(), log_sum_exp.size())),
+            i_result_type.GetFixedShape());
+    }
+
+    // every element is exp(x - logsumexp), so no division is needed
+    TensorValue SoftmaxEvaluate(const std::any & i_attachment,
+        const TensorType & i_result_type, Span<const TensorValue> i_operands)
+    {
+        const TensorValue & source = i_operands.at(0);
+        IndexedAxis const shape = GetIndexedAxis(source.GetShape(),
+            GetSoftmaxAxis(i_attachment, source.GetShape().GetRank()));
+
+        SharedArray<Real> source_buffer;
+        const Real * const elements = GetUnwrapped(source, source_buffer);
+        std::vector<Real> const log_sum_exp = ComputeLogSumExp(elements, shape);
+
+        SharedArray<Real> result(NumericCast<size_t>(source.GetShape().GetLinearSize()));
+        for(size_t outer = 0; outer < shape.m_outer; outer++)
+        {
+            const Real * const shifts = log_sum_exp.data() + outer * shape.m_inner;
+            size_t const group = outer * shape.m_dimension * shape.m_inner;
+            for(size_t row = 0; row < shape.m_dimension; row++)
+            {
+                size_t const first = group + row * shape.m_inner;
+                for(size_t inner = 0; inner < shape.m_inner; inner++)
+                    result[first + inner] = std::exp(elements[first + inner] - shifts[inner]);
+            }
+        }
+        return TensorValue(std::move(result), i_result_type.GetFixedShape());
+    }
+
+    // an exponential for every element of the source
+    Operator::Cost SoftmaxCost([[maybe_unused]] const std::any & i_attachment,
+        const TensorType & i_result_type, Span<const Tensor> i_operands)
+    {
+        return { Operator::GetElementCount(i_operands.at(0).GetExpression()->GetType()),
+            Operator::GetByteSize(i_result_type) };
+    }
+
+    const FixedShape & GetSoftmaxSourceShape(const char * i_name, const Tensor & i_source)
+    {
+        const TensorType & source_type = i_source.GetExpression()->GetType();
+        if(!source_type.HasFixedShape())
+            Panic(i_name, ": the gradient requires an operand with a fixed shape");
+        return source_type.GetFixedShape();
+    }
+
+    // the gradient of log-sum-exp is the softmax
+    Tensor LogSumExpGradient(const Tensor & i_self, const Tensor & i_self_gradient, [[maybe_unused]] size_t i_operand_index)
+    {
+        const Expression & expression = *i_self.GetExpression();
+        const Tensor & source = expression.GetOperands().at(0);
+        const FixedShape & shape = GetSoftmaxSourceShape("log_sum_exp", source);
+        Integer const axis = GetSoftmaxAxis(expression.GetAttachment(), shape.GetRank());
+        return Softmax(source, axis) * Reshape(i_self_gradient, GetSoftmaxKeptDimensions(shape, axis));
+    }
+
+    // softmax(x) * (g - sum(g * softmax(x))), the sum being along the axis
+    Tensor SoftmaxGradient(const Tensor & i_self, const Tensor & i_self_gradient, [[maybe_unused]] size_t i_operand_index)
+    {
+        const Expression & expression = *i_self.GetExpression();
+        const FixedShape & shape = GetSoftmaxSourceShape("softmax", expression.GetOperands().at(0));
+        Integer const axis = GetSoftmaxAxis(expression.GetAttachment(), shape.GetRank());
+        Tensor const projection = Reshape(Sum(i_self_gradient * i_self, { axis }), GetSoftmaxKeptDimensions(shape, axis));
+        return i_self * (i_self_gradient - projection);
+    }
+
+    extern const Operator & GetOperatorLogSumExp()
+    {
+        static auto const op = Operator("log_sum_exp")
+            .SetDoc("Returns the logarithm of the sum of the exponentials of the elements along an axis, the last one by default.",
+                "The return scalar type is real.\n"
+                "The return shape is the shape of the operand without the axis.")
+            .SetDeduceType(LogSumExpDeduceType)
+            .SetCost(SoftmaxCost)
+            .AddOverload(LogSumExpEvaluate, { { ScalarType::Real, "source" } })
+            .SetAttachmentComparer<Integer>()
+            .SetAttachmentHasher<Integer>()
+            .SetAttachmentSerializer<Integer>()
+            .SetGradientOfOperand(LogSumExpGradient);
+        return op;
+    }
+
+    extern const Operator & GetOperatorSoftmax()
+    {
+        static auto const op = Operator("softmax")
+            .SetDoc("Returns the exponentials of the elements divided by their sum along an axis, the last one by default.",
+                "The return scalar type is real.\n"
+                "The return shape is the shape of the operand.")
+            .SetDeduceType(SoftmaxDeduceType)
+            .SetCost(SoftmaxCost)
+            .AddOverload(SoftmaxEvaluate, { { ScalarType::Real, "source" } })
+            .SetAttachmentComparer<Integer>()
+            .SetAttachmentHasher<Integer>()
+            .SetAttachmentSerializer<Integer>()
+            .SetGradientOfOperand(SoftmaxGradient);
+        return op;
+    }
+
+    /* If the rank of the source is known and the axis is the last one, the axis is not
+        attached, so the result is identical to the one of the overload without axis. */
+    Tensor InvokeSoftmax(const Operator & i_operator, const Tensor & i_source, Integer i_axis)
+    {
+        const TensorType & type = i_source.GetExpression()->GetType();
+        if(type.HasFixedShape() && i_axis == type.GetFixedShape().GetRank() - 1)
+            return i_operator.Invoke({ i_source });
+        return i_operator.Invoke({ i_source }, i_axis);
+    }
+
+    Tensor Softmax(const Tensor & i_source) { return GetOperatorSoftmax().Invoke({ i_source }); }
+    Tensor Softmax(const Tensor & i_source, Integer i_axis) { return InvokeSoftmax(GetOperatorSoftmax(), i_source, i_axis); }
+
+    Tensor LogSumExp(const Tensor & i_source) { return GetOperatorLogSumExp().Invoke({ i_source }); }
+    Tensor LogSumExp(const Tensor & i_source, Integer i_axis) { return InvokeSoftmax(GetOperatorLogSumExp(), i_source, i_axis); }
+}
@@ -9,10 +9,19 @@
 #include "tensor_value.h"
 #include "tensor_type.h"
 #include "indices.h"
+#include <algorithm>
+#include <numeric>
+#include <functional>
 
 namespace liquid
 {
-    TensorType StackDeduceType([[maybe_unused]] const std::any & i_attachment,
+    // the axis is attached only if it's not zero
+    Integer GetStackAxis(const std::any & i_attachment)
+    {
+        return i_attachment.has_value() ? std::any_cast<Integer>(i_attachment) : 0;
+    }
+
+    TensorType StackDeduceType(const std::any & i_attachment,
         Span<const Tensor> i_operands)
     {
         auto const common_type = DeduceType(i_operands);
@@ -21,38 +30,95 @@ namespace liquid
         {
             Span<const Integer> const source_dimensions = common_type.GetFixedShape().GetDimensions();
 
-            Integer axis = 0;
+            Integer const axis = GetStackAxis(i_attachment);
+            if(axis < 0 || axis > NumericCast<Integer>(source_dimensions.size()))
+                Panic("stack: the axis ", axis, " is out of range for the rank ", source_dimensions.size());
 
             std::vector<Integer> dest_dimenions = Concatenate(
-                Span(source_dimensions).subspan(0, axis),
+                Span(source_dimensions).subspan(0, static_cast<size_t>(axis)),
                 Span{ NumericCast<Integer>(i_operands.size()) },
-                Span(source_dimensions).subspan(axis) );
+                Span(source_dimensions).subspan(static_cast<size_t>(axis)) );
             
             return { common_type.GetScalarType(), FixedShape(dest_dimenions) };
         }
+        else if(auto const source_dimensions = TryGetDimensions(common_type))
+        {
+            Integer const axis = GetStackAxis(i_attachment);
+            if(axis < 0 || axis > NumericCast<Integer>(source_dimensions->size()))
+                Panic("stack: the axis ", axis, " is out of range for the rank ", source_dimensions->size());
+
+            std::vector<Tensor> dest_dimensions = *source_dimensions;
+            dest_dimensions.insert(dest_dimensions.begin() + axis, Tensor(NumericCast<Integer>(i_operands.size())));
+            return { common_type.GetScalarType(), MakeShapeVector(dest_dimensions) };
+        }
         else
             return common_type.GetScalarType();
     }
 
+    // true if the dimensions of the operand are a suffix of the dimensions of the common shape
+    bool IsSuffixBroadcast(const FixedShape & i_operand_shape, Span<const Integer> i_common_dimensions)
+    {
+        Span<const Integer> const dimensions = i_operand_shape.GetDimensions();
+        return dimensions.size() <= i_common_dimensions.size() && std::equal(
+            dimensions.begin(), dimensions.end(),
+            i_common_dimensions.begin() + (i_common_dimensions.size() - dimensions.size()));
+    }
+
+    /* Stacking is a sequence of block copies: the result is made of 'outer' groups (the product
+        of the dimensions before the axis), each containing one block of 'inner' elements (the
+        product of the dimensions from the axis on) for every operand. When the shape of an operand
+        is a suffix of the common shape, its logical elements in row-major order are its storage 
+        repeated, so every block is copied with at most a few contiguous copies. Other broadcasts
+        are copied element by element. */
     template <typename SCALAR_TYPE>
-        TensorValue StackEvaluate(const TensorType & i_result_type, Span<const TensorValue> i_operands)
+        TensorValue StackEvaluate(const std::any & i_attachment,
+            const TensorType & i_result_type, Span<const TensorValue> i_operands)
     {
         const FixedShape & result_shape = i_result_type.GetFixedShape();
         SharedArray<SCALAR_TYPE> result(static_cast<size_t>(result_shape.GetLinearSize()));
 
-        Integer axis = 0;
+        size_t const axis = static_cast<size_t>(GetStackAxis(i_attachment));
+        Span<const Integer> const result_dimensions = result_shape.GetDimensions();
+        std::vector<Integer> const common_dimensions = Concatenate(
+            result_dimensions.subspan(0, axis), result_dimensions.subspan(axis + 1));
+        
+        size_t const operand_count = i_operands.size();
+        size_t const outer = static_cast<size_t>(std::accumulate(common_dimensions.begin(), 
+            common_dimensions.begin() + axis, Integer(1), std::multiplies<Integer>()));
+        size_t const inner = static_cast<size_t>(std::accumulate(common_dimensions.begin() + axis,
+            common_dimensions.end(), Integer(1), std::multiplies<Integer>()));
 
-        std::vector<Integer> result_indices;
-        for (size_t operand_index = 0; operand_index < i_operands.size(); operand_index++)
+        for (size_t operand_index = 0; operand_index < operand_count; operand_index++)
         {
-            const FixedShape & op_shape = i_operands[operand_index].GetShape();
-            for (Indices source_indices(op_shape); source_indices; source_indices++)
+            const TensorValue & operand = i_operands[operand_index];
+            if(IsSuffixBroadcast(operand.GetShape(), common_dimensions))
+            {
+                Span<const SCALAR_TYPE> const source = operand.GetAs<SCALAR_TYPE>();
+                size_t source_index = 0;
+                for (size_t outer_index = 0; outer_index < outer; outer_index++)
+                {
+                    SCALAR_TYPE * dest = result.data() + (outer_index * operand_count + operand_index) * inner;
+                    for (size_t remaining = inner; remaining != 0; )
+                    {
+                        size_t const count = std::min(remaining, source.size() - source_index);
+                        dest = std::copy_n(source.data() + source_index, count, dest);
+                        source_index = (source_index + count) % source.size();
+                        remaining -= count;
+                    }
+                }
+            }
+            else
             {
-                result_indices = source_indices.GetIndices();
-                result_indices.insert(result_indices.begin() + axis, NumericCast<Integer>(operand_index));
+                FixedShape const common_shape(common_dimensions);
+                std::vector<Integer> result_indices;
+                for (Indices source_indices(common_shape); source_indices; source_indices++)
+                {
+                    result_indices = source_indices.GetIndices();
+                    result_indices.insert(result_indices.begin() + axis, NumericCast<Integer>(operand_index));
 
-                Integer const linear_index = result_shape.GetPhysicalLinearIndex(result_indices);
-                result[linear_index] = source_indices.At<SCALAR_TYPE>(i_operands[operand_index]);
+                    Integer const linear_index = result_shape.GetPhysicalLinearIndex(result_indices);
+                    result[linear_index] = source_indices.At<SCALAR_TYPE>(operand);
+                }
             }
         }
 
@@ -62,9 +128,17 @@ namespace liquid
     extern const Operator & GetOperatorStack()
     {
         static auto const op = Operator("stack")
+            .SetCost(Operator::ZeroFlopsCost)
             .SetDeduceType(StackDeduceType)
+            .SetShapeConstraints(Operator::BroadcastConstraints)
+            .SetAttachmentComparer<Integer>()
+            .SetAttachmentHasher<Integer>()
+            .SetAttachmentSerializer<Integer>()
             .AddOverload(StackEvaluate<Integer>, { {ScalarType::Integer, "source"} }, 1 )
+            .AddOverload(StackEvaluate<Integer32>, { {ScalarType::Integer32, "source"} }, 1 )
+            .AddOverload(StackEvaluate<Integer8>, { {ScalarType::Integer8, "source"} }, 1 )
             .AddOverload(StackEvaluate<Real>, { {ScalarType::Real, "source"} }, 1 )
+            .AddOverload(StackEvaluate<Real32>, { {ScalarType::Real32, "source"} }, 1 )
             .AddOverload(StackEvaluate<Bool>, { {ScalarType::Bool, "source"} }, 1 );
         return op;
     }
@@ -73,4 +147,11 @@ namespace liquid
     {
         return GetOperatorStack().Invoke(i_tensors);
     }
+
+    Tensor Stack(Span<Tensor const> i_tensors, Integer i_axis)
+    {
+        if(i_axis == 0)
+            return Stack(i_tensors);
+        return GetOperatorStack().Invoke(i_tensors, i_axis);
+    }
 }
@@ -0,0 +1,160 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "expression.h"
+#include "operator.h"
+#include "tensor_value.h"
+#include "tensor_type.h"
+#include <algorithm>
+#include <numeric>
+
+namespace liquid
+{
+    extern const Operator & GetOperatorTranspose();
+
+    /* The attachment is the permutation of the axes: the axis i of the result is the axis
+        i_axes[i] of the source. Without attachment the order of the axes is reversed. */
+    std::vector<Integer> GetTransposeAxes(const std::any & i_attachment, size_t i_rank)
+    {
+        if(i_attachment.has_value())
+            return std::any_cast<const std::vector<Integer> &>(i_attachment);
+
+        std::vector<Integer> axes(i_rank);
+        std::iota(axes.rbegin(), axes.rend(), 0);
+        return axes;
+    }
+
+    // checks that the axes are a permutation, the shape is printed in the message
+    template <typename SHAPE>
+        std::vector<Integer> GetTransposeAxes(const std::any & i_attachment, size_t i_rank, const SHAPE & i_shape)
+    {
+        std::vector<Integer> axes = GetTransposeAxes(i_attachment, i_rank);
+
+        std::vector<Integer> sorted = axes;
+        std::sort(sorted.begin(), sorted.end());
+        bool is_permutation = sorted.size() == i_rank;
+        for(size_t index = 0; index < sorted.size() && is_permutation; index++)
+            is_permutation = sorted[index] == NumericCast<Integer>(index);
+        if(!is_permutation)
+            Panic("transpose: the axes [", Span<const Integer>(axes), "] are not a permutation for the shape ", i_shape);
+
+        return axes;
+    }
+
+    std::vector<Integer> GetTransposeAxes(const std::any & i_attachment, const FixedShape & i_shape)
+    {
+        return GetTransposeAxes(i_attachment, i_shape.GetDimensions().size(), i_shape);
+    }
+
+    TensorType TransposeDeduceType(const std::any & i_attachment, Span<const Tensor> i_operands)
+    {
+        const TensorType & source_type = i_operands.at(0).GetExpression()->GetType();
+        if(source_type.HasFixedShape())
+        {
+            const FixedShape & shape = source_type.GetFixedShape();
+            std::vector<Integer> const axes = GetTransposeAxes(i_attachment, shape);
+            return { source_type.GetScalarType(), FixedShape(Transform(axes,
+                [&](Integer i_axis){ return shape.GetDimension(i_axis); })) };
+        }
+        else if(auto const dimensions = TryGetDimensions(source_type))
+        {
+            std::vector<Integer> const axes = GetTransposeAxes(i_attachment, dimensions->size(), source_type);
+            return { source_type.GetScalarType(), MakeShapeVector(Transform(axes,
+                [&](Integer i_axis){ return (*dimensions)[NumericCast<size_t>(i_axis)]; })) };
+        }
+        else
+            return source_type.GetScalarType();
+    }
+
+    // the result is a view of the source with permuted strides
+    TensorValue TransposeEvaluate(const std::any & i_attachment,
+        const TensorType & i_result_type, Span<const TensorValue> i_operands)
+    {
+        const TensorValue & source = i_operands.at(0);
+        Span<const Integer> const source_strides = source.GetStorageStrides();
+        std::vector<Integer> const axes = GetTransposeAxes(i_attachment, source.GetShape());
+        std::vector<Integer> const strides = Transform(axes,
+            [&](Integer i_axis){ return source_strides[NumericCast<size_t>(i_axis)]; });
+        return TensorValue(source, i_result_type.GetFixedShape(), strides, source.GetStorageOffset());
+    }
+
+    /* transpose(x) -> x if the permutation is the identity,
+        transpose(transpose(x)) -> transpose(x) with the composed permutation */
+    std::optional<Tensor> TransposeCanonicalize(const Tensor & i_source)
+    {
+        const Expression & expression = *i_source.GetExpression();
+        const Tensor & operand = expression.GetOperands().at(0);
+        const TensorType & operand_type = operand.GetExpression()->GetType();
+        if(!operand_type.HasFixedShape())
+            return {};
+
+        std::vector<Integer> const axes = GetTransposeAxes(expression.GetAttachment(), operand_type.GetFixedShape());
+        bool identity = true;
+        for(size_t index = 0; index < axes.size(); index++)
+            identity = identity && axes[index] == NumericCast<Integer>(index);
+        if(identity)
+            return operand;
+
+        const Expression & inner = *operand.GetExpression();
+        if(inner.OperatorIs(GetOperatorTranspose()))
+        {
+            const Tensor & source = inner.GetOperands().at(0);
+            std::vector<Integer> const inner_axes = GetTransposeAxes(
+                inner.GetAttachment(), source.GetExpression()->GetType().GetFixedShape());
+            std::vector<Integer> const composed = Transform(axes,
+                [&](Integer i_axis){ return inner_axes[NumericCast<size_t>(i_axis)]; });
+            return Transpose(source, composed);
+        }
+
+        return {};
+    }
+
+    Tensor TransposeGradient(const Tensor & i_self, const Tensor & i_self_gradient, [[maybe_unused]] size_t i_operand_index)
+    {
+        const Tensor & source = i_self.GetExpression()->GetOperands().at(0);
+        const TensorType & source_type = source.GetExpression()->GetType();
+        if(!source_type.HasFixedShape())
+            Panic("transpose: the gradient requires an operand with a fixed shape");
+
+        // the gradient is transposed with the inverse permutation
+        std::vector<Integer> const axes = GetTransposeAxes(i_self.GetExpression()->GetAttachment(), source_type.GetFixedShape());
+        std::vector<Integer> inverse(axes.size());
+        for(size_t index = 0; index < axes.size(); index++)
+            inverse[NumericCast<size_t>(axes[index])] = NumericCast<Integer>(index);
+        return Transpose(i_self_gradient, inverse);
+    }
+
+    extern const Operator & GetOperatorTranspose()
+    {
+        static auto const op = Operator("transpose")
+            .SetDoc("Returns the source with the axes permuted. Without axes the order of the axes is reversed.",
+                "The return scalar type is the scalar type of the source.\n"
+                "The dimension i of the return shape is the dimension axes[i] of the source.")
+            .SetDeduceType(TransposeDeduceType)
+            .SetCost(Operator::ViewCost)
+            .AddOverload(TransposeEvaluate, { { ScalarType::Any, "source" } })
+            .SetAttachmentComparer<std::vector<Integer>>()
+            .SetAttachmentHasher<std::vector<Integer>>()
+            .SetAttachmentSerializer<std::vector<Integer>>()
+            .AddCanonicalize(TransposeCanonicalize)
+            .SetGradientOfOperand(TransposeGradient);
+        return op;
+    }
+
+    Tensor Transpose(const Tensor & i_source)
+    {
+        return GetOperatorTranspose().Invoke({ i_source });
+    }
+
+    // if the shape is known and the axes are reversed, the axes are not attached
+    Tensor Transpose(const Tensor & i_source, Span<const Integer> i_axes)
+    {
+        std::vector<Integer> axes(i_axes.begin(), i_axes.end());
+        const TensorType & type = i_source.GetExpression()->GetType();
+        if(type.HasFixedShape() && axes == GetTransposeAxes({}, type.GetFixedShape().GetDimensions().size()))
+            return GetOperatorTranspose().Invoke({ i_source });
+        return GetOperatorTranspose().Invoke({ i_source }, std::move(axes));
+    }
+}
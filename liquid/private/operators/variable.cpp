@@ -25,11 +25,13 @@ namespace liquid
     extern const Operator & GetOperatorVariable()
     {
         static auto const op = Operator("variable")
+            .SetCost(Operator::ZeroFlopsCost)
             .SetDeduceType(VariableDeduceType)
             .AddOverload({}, {})
             .SetEligibleForPropagation(VariableEligibleForPropagation)
             .SetAttachmentComparer<TensorType>()
-            .SetAttachmentHasher<TensorType>();
+            .SetAttachmentHasher<TensorType>()
+            .SetAttachmentSerializer<TensorType>();
         return op;
     }
 
@@ -43,9 +43,15 @@ namespace liquid
         if(!IsVariable(i_new_variable))
             Panic("Scope::AddVariable", i_new_variable, " is not a variable");
         std::string const & name = i_new_variable.GetExpression()->GetName();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
         if(!name.empty())
         {
-            Member const existing = TryLookup(name);
+            Member existing;
+            if(auto const declaration = TryFindDeclaration(name))
+                existing = *declaration;
+            else
+                existing = TryLookupInherited(name);
 
             if(std::holds_alternative<Tensor>(existing))
                 Panic("Scope::AddVariable - duplicate members:\n", 
@@ -71,12 +77,25 @@ namespace liquid
     Scope::Member Scope::TryLookup(std::string_view i_name) const
     {
         // try to find a variable
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(auto const declaration = TryFindDeclaration(i_name))
+                return *declaration;
+        }
+
+        return TryLookupInherited(i_name);
+    }
+
+    const Tensor * Scope::TryFindDeclaration(std::string_view i_name) const
+    {
         auto const val_it = std::find_if(m_declarations.begin(), m_declarations.end(), 
             [i_name](const Tensor & i_candidate){
                 return i_candidate.GetExpression()->GetName() == i_name; });
-        if(val_it != m_declarations.end())
-            return *val_it;
+        return val_it != m_declarations.end() ? &*val_it : nullptr;
+    }
 
+    Scope::Member Scope::TryLookupInherited(std::string_view i_name) const
+    {
         if(m_parent != nullptr)
         {
             // try an inherited member
@@ -12,9 +12,12 @@
 #include <memory>
 #include <variant>
 #include <functional>
+#include <mutex>
 
 namespace liquid
 {
+    /* Scopes can be used concurrently: declarations are guarded by a mutex. Nested
+        locks are always taken from an inner scope to its parent, so they can't deadlock. */
     class Scope : public std::enable_shared_from_this<Scope>
     {
     public:
@@ -48,9 +51,17 @@ namespace liquid
     protected:
         Scope(const std::shared_ptr<const Scope> & i_parent);
 
+    private:
+        // m_mutex must be locked by the caller
+        const Tensor * TryFindDeclaration(std::string_view i_name) const;
+
+        // looks in the parent scope, or in the book if this is the root
+        Member TryLookupInherited(std::string_view i_name) const;
+
     private:
         std::vector<Rule> m_rules;
         std::vector<Tensor> m_values;
+        mutable std::mutex m_mutex; // guards m_declarations
         std::vector<Tensor> m_declarations;
         std::shared_ptr<const Scope> const m_parent;
     };
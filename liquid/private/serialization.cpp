@@ -0,0 +1,364 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "serialization.h"
+#include "expression.h"
+#include "book.h"
+#include <istream>
+#include <ostream>
+
+namespace liquid
+{
+    namespace
+    {
+        constexpr char g_magic[] = { 'l', 'i', 'q', 'u', 'i', 'd', 'b', 'n' };
+        constexpr uint32_t g_version = 1;
+        constexpr uint32_t g_byte_order_mark = 0x01020304;
+
+        // records of the stream, each introduced by a tag
+        enum class RecordTag : uint8_t { Node = 1, Roots = 2 };
+
+        // how the shape of a TensorType is stored
+        enum class ShapeKind : uint8_t { Undefined = 0, Fixed = 1, Variable = 2 };
+
+        template <typename SCALAR_TYPE>
+            void WriteScalars(BinaryWriter & i_dest, const TensorValue & i_value)
+        {
+            auto const & scalars = i_value.GetAs<SCALAR_TYPE>();
+            i_dest.WriteSize(scalars.size());
+            if constexpr(std::is_same_v<SCALAR_TYPE, Bool>)
+            {
+                for(Bool scalar : scalars)
+                    i_dest << static_cast<uint8_t>(scalar ? 1 : 0);
+            }
+            else
+            {
+                auto const address = reinterpret_cast<const unsigned char*>(scalars.data());
+                i_dest << Span(address, scalars.size() * sizeof(SCALAR_TYPE));
+            }
+        }
+
+        template <typename SCALAR_TYPE>
+            TensorValue ReadScalars(BinaryReader & i_source, const FixedShape & i_shape)
+        {
+            SharedArray<SCALAR_TYPE> scalars(i_source.ReadSize());
+            if constexpr(std::is_same_v<SCALAR_TYPE, Bool>)
+            {
+                for(Bool & scalar : scalars)
+                    scalar = i_source.Read<uint8_t>() != 0;
+            }
+            else
+            {
+                auto const address = reinterpret_cast<unsigned char*>(scalars.data());
+                i_source.Read(Span(address, scalars.size() * sizeof(SCALAR_TYPE)));
+            }
+            return TensorValue(std::move(scalars), i_shape);
+        }
+    }
+
+    BinaryWriter::BinaryWriter(std::ostream & i_dest)
+        : m_dest(i_dest)
+    {
+        m_dest.write(g_magic, sizeof(g_magic));
+        m_buffers.emplace_back();
+        *this << g_version << g_byte_order_mark;
+        *this << static_cast<uint8_t>(sizeof(Real)) << static_cast<uint8_t>(sizeof(Integer));
+        m_dest.write(m_buffers.back().data(), m_buffers.back().size());
+        m_buffers.pop_back();
+    }
+
+    BinaryWriter & BinaryWriter::operator << (Span<const unsigned char> i_data)
+    {
+        if(m_buffers.empty())
+            Panic("BinaryWriter - no node is being written");
+        m_buffers.back().append(reinterpret_cast<const char*>(i_data.data()), i_data.size());
+        return *this;
+    }
+
+    void BinaryWriter::WriteSize(size_t i_size)
+    {
+        do {
+            auto byte = static_cast<uint8_t>(i_size & 0x7F);
+            i_size >>= 7;
+            if(i_size != 0)
+                byte |= 0x80;
+            *this << byte;
+        } while(i_size != 0);
+    }
+
+    size_t BinaryWriter::AddNode(const Tensor & i_tensor)
+    {
+        const Expression & expression = *i_tensor.GetExpression();
+        auto const it = m_node_indices.find(&expression);
+        if(it != m_node_indices.end())
+            return it->second;
+
+        WriteNode(expression);
+
+        size_t const node_index = m_node_indices.size();
+        m_node_indices.insert(std::make_pair(&expression, node_index));
+        return node_index;
+    }
+
+    void BinaryWriter::WriteNode(const Expression & i_expression)
+    {
+        /* the payload of the node is accumulated in its own buffer, so that
+            dependencies found while writing it can be written before it */
+        m_buffers.emplace_back();
+
+        const Operator & op = i_expression.GetOperator();
+        *this << op.GetName();
+        WriteSize(op.GetOverloadIndex(i_expression.GetOverload()));
+        *this << i_expression.GetName() << i_expression.GetDoc();
+        *this << i_expression.GetType();
+
+        const std::any & attachment = i_expression.GetAttachment();
+        *this << static_cast<uint8_t>(attachment.has_value() ? 1 : 0);
+        if(attachment.has_value())
+            op.WriteAttachment(*this, attachment);
+
+        const std::vector<Tensor> & operands = i_expression.GetOperands();
+        WriteSize(operands.size());
+        for(const Tensor & operand : operands)
+            WriteSize(AddNode(operand));
+
+        std::string const payload = std::move(m_buffers.back());
+        m_buffers.pop_back();
+
+        m_dest.put(static_cast<char>(RecordTag::Node));
+        m_dest.write(payload.data(), payload.size());
+    }
+
+    void BinaryWriter::WriteRoots(Span<const size_t> i_node_indices)
+    {
+        m_buffers.emplace_back();
+        WriteSize(i_node_indices.size());
+        for(size_t node_index : i_node_indices)
+            WriteSize(node_index);
+        std::string const payload = std::move(m_buffers.back());
+        m_buffers.pop_back();
+
+        m_dest.put(static_cast<char>(RecordTag::Roots));
+        m_dest.write(payload.data(), payload.size());
+        if(!m_dest)
+            Panic("BinaryWriter - write failure");
+    }
+
+    BinaryWriter & operator << (BinaryWriter & i_dest, std::string_view i_string)
+    {
+        i_dest.WriteSize(i_string.length());
+        auto const address = reinterpret_cast<const unsigned char*>(i_string.data());
+        return i_dest << Span(address, i_string.length());
+    }
+
+    BinaryWriter & operator << (BinaryWriter & i_dest, const FixedShape & i_shape)
+    {
+        i_dest.WriteSize(i_shape.GetDimensions().size());
+        for(Integer dimension : i_shape.GetDimensions())
+            i_dest.WriteSize(NumericCast<size_t>(dimension));
+        return i_dest;
+    }
+
+    BinaryWriter & operator << (BinaryWriter & i_dest, const std::vector<Integer> & i_integers)
+    {
+        i_dest.WriteSize(i_integers.size());
+        for(Integer integer : i_integers)
+            i_dest << integer;
+        return i_dest;
+    }
+
+    BinaryWriter & operator << (BinaryWriter & i_dest, const TensorType & i_type)
+    {
+        i_dest << i_type.GetScalarType();
+        if(i_type.HasFixedShape())
+            i_dest << ShapeKind::Fixed << i_type.GetFixedShape();
+        else if(i_type.HasVariableShape())
+        {
+            i_dest << ShapeKind::Variable;
+            i_dest.WriteSize(i_dest.AddNode(i_type.GetVariableShape()));
+        }
+        else
+            i_dest << ShapeKind::Undefined;
+        return i_dest;
+    }
+
+    BinaryWriter & operator << (BinaryWriter & i_dest, const TensorValue & i_value)
+    {
+        i_dest << i_value.GetScalarType() << i_value.GetShape();
+        switch(i_value.GetScalarType())
+        {
+            case ScalarType::Real: WriteScalars<Real>(i_dest, i_value); break;
+            case ScalarType::Integer: WriteScalars<Integer>(i_dest, i_value); break;
+            case ScalarType::Bool: WriteScalars<Bool>(i_dest, i_value); break;
+            case ScalarType::Real32: WriteScalars<Real32>(i_dest, i_value); break;
+            case ScalarType::Integer32: WriteScalars<Integer32>(i_dest, i_value); break;
+            case ScalarType::Integer8: WriteScalars<Integer8>(i_dest, i_value); break;
+            default: Panic("BinaryWriter - unsupported scalar type: ", i_value.GetScalarType());
+        }
+        return i_dest;
+    }
+
+    BinaryReader::BinaryReader(std::istream & i_source)
+        : m_source(i_source)
+    {
+        char magic[sizeof(g_magic)] = {};
+        m_source.read(magic, sizeof(magic));
+        if(!m_source || !std::equal(std::begin(magic), std::end(magic), std::begin(g_magic)))
+            Panic("BinaryReader - not a liquid binary stream");
+
+        auto const version = Read<uint32_t>();
+        if(version != g_version)
+            Panic("BinaryReader - unsupported version ", version);
+
+        auto const byte_order_mark = Read<uint32_t>();
+        auto const sizeof_real = Read<uint8_t>();
+        auto const sizeof_integer = Read<uint8_t>();
+        if(byte_order_mark != g_byte_order_mark ||
+                sizeof_real != sizeof(Real) || sizeof_integer != sizeof(Integer))
+            Panic("BinaryReader - the stream was written by an incompatible machine");
+    }
+
+    void BinaryReader::Read(Span<unsigned char> o_data)
+    {
+        m_source.read(reinterpret_cast<char*>(o_data.data()),
+            static_cast<std::streamsize>(o_data.size()));
+        if(!m_source)
+            Panic("BinaryReader - unexpected end of stream");
+    }
+
+    size_t BinaryReader::ReadSize()
+    {
+        size_t result = 0;
+        for(size_t shift = 0; ; shift += 7)
+        {
+            if(shift >= sizeof(size_t) * 8)
+                Panic("BinaryReader - bad size");
+            auto const byte = Read<uint8_t>();
+            result |= static_cast<size_t>(byte & 0x7F) << shift;
+            if((byte & 0x80) == 0)
+                return result;
+        }
+    }
+
+    const Tensor & BinaryReader::GetNode(size_t i_node_index) const
+    {
+        if(i_node_index >= m_nodes.size())
+            Panic("BinaryReader - bad node index ", i_node_index,
+                ", ", m_nodes.size(), " nodes read so far");
+        return m_nodes[i_node_index];
+    }
+
+    void BinaryReader::ReadNode()
+    {
+        auto const operator_name = Read<std::string>();
+        const Operator & op = Book::Get().GetOperator(operator_name);
+        const Operator::Overload & overload = op.GetOverload(ReadSize());
+        auto const name = Read<std::string>();
+        auto const doc = Read<std::string>();
+        auto const type = Read<TensorType>();
+
+        std::any attachment;
+        if(Read<uint8_t>() != 0)
+            attachment = op.ReadAttachment(*this);
+
+        std::vector<Tensor> operands;
+        size_t const operand_count = ReadSize();
+        operands.reserve(operand_count);
+        for(size_t operand_index = 0; operand_index < operand_count; operand_index++)
+            operands.push_back(GetNode(ReadSize()));
+
+        // the expression is rebuilt as is, without invoking the operator
+        m_nodes.push_back(std::make_shared<const Expression>(
+            name, doc, type, op, overload, operands, attachment));
+    }
+
+    std::vector<Tensor> BinaryReader::ReadGraph()
+    {
+        for(;;)
+        {
+            auto const tag = Read<RecordTag>();
+            if(tag == RecordTag::Node)
+                ReadNode();
+            else if(tag == RecordTag::Roots)
+            {
+                std::vector<Tensor> roots;
+                size_t const root_count = ReadSize();
+                roots.reserve(root_count);
+                for(size_t root_index = 0; root_index < root_count; root_index++)
+                    roots.push_back(GetNode(ReadSize()));
+                return roots;
+            }
+            else
+                Panic("BinaryReader - unrecognized record ", static_cast<int>(tag));
+        }
+    }
+
+    template <> std::string BinaryReader::Read<std::string>()
+    {
+        std::string result(ReadSize(), ' ');
+        Read(Span(reinterpret_cast<unsigned char*>(result.data()), result.size()));
+        return result;
+    }
+
+    template <> FixedShape BinaryReader::Read<FixedShape>()
+    {
+        std::vector<Integer> dimensions(ReadSize());
+        for(Integer & dimension : dimensions)
+            dimension = NumericCast<Integer>(ReadSize());
+        return FixedShape(dimensions);
+    }
+
+    template <> std::vector<Integer> BinaryReader::Read<std::vector<Integer>>()
+    {
+        std::vector<Integer> integers(ReadSize());
+        for(Integer & integer : integers)
+            integer = Read<Integer>();
+        return integers;
+    }
+
+    template <> TensorType BinaryReader::Read<TensorType>()
+    {
+        auto const scalar_type = Read<ScalarType>();
+        switch(Read<ShapeKind>())
+        {
+            case ShapeKind::Undefined: return TensorType(scalar_type);
+            case ShapeKind::Fixed: return TensorType(scalar_type, Read<FixedShape>());
+            case ShapeKind::Variable: return TensorType(scalar_type, GetNode(ReadSize()));
+            default: Panic("BinaryReader - unrecognized shape kind");
+        }
+    }
+
+    template <> TensorValue BinaryReader::Read<TensorValue>()
+    {
+        auto const scalar_type = Read<ScalarType>();
+        auto const shape = Read<FixedShape>();
+        switch(scalar_type)
+        {
+            case ScalarType::Real: return ReadScalars<Real>(*this, shape);
+            case ScalarType::Integer: return ReadScalars<Integer>(*this, shape);
+            case ScalarType::Bool: return ReadScalars<Bool>(*this, shape);
+            case ScalarType::Real32: return ReadScalars<Real32>(*this, shape);
+            case ScalarType::Integer32: return ReadScalars<Integer32>(*this, shape);
+            case ScalarType::Integer8: return ReadScalars<Integer8>(*this, shape);
+            default: Panic("BinaryReader - unsupported scalar type: ", scalar_type);
+        }
+    }
+
+    void WriteBinary(std::ostream & i_dest, Span<const Tensor> i_tensors)
+    {
+        BinaryWriter writer(i_dest);
+        std::vector<size_t> roots;
+        roots.reserve(i_tensors.size());
+        for(const Tensor & tensor : i_tensors)
+            roots.push_back(writer.AddNode(tensor));
+        writer.WriteRoots(roots);
+    }
+
+    std::vector<Tensor> ReadBinary(std::istream & i_source)
+    {
+        BinaryReader reader(i_source);
+        return reader.ReadGraph();
+    }
+}
@@ -0,0 +1,119 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#include "private_common.h"
+#include "liquid/span.h"
+#include "liquid/tensor.h"
+#include <type_traits>
+#include <string_view>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <iosfwd>
+
+namespace liquid
+{
+    class Expression;
+    class FixedShape;
+    class TensorType;
+    class TensorValue;
+
+    /* Writes expression graphs in a compact and machine dependent binary format.
+        Every unique node is written once, and only after all the nodes it refers
+        to (operands, variable shapes, attachments), so that a node always refers
+        to other nodes with backward indices. */
+    class BinaryWriter
+    {
+    public:
+
+        BinaryWriter(std::ostream & i_dest);
+
+        BinaryWriter(const BinaryWriter &) = delete;
+        BinaryWriter & operator = (const BinaryWriter &) = delete;
+
+        BinaryWriter & operator << (Span<const unsigned char> i_data);
+
+        // unsigned LEB128
+        void WriteSize(size_t i_size);
+
+        /* returns the index of the node of the tensor, writing it (and all its
+            dependencies) if it was not already written */
+        size_t AddNode(const Tensor & i_tensor);
+
+        void WriteRoots(Span<const size_t> i_node_indices);
+
+    private:
+        void WriteNode(const Expression & i_expression);
+
+    private:
+        std::ostream & m_dest;
+        std::vector<std::string> m_buffers; // stack of nodes being written
+        std::unordered_map<const Expression *, size_t> m_node_indices;
+    };
+
+    template <typename TYPE, typename = std::enable_if_t<
+            std::is_arithmetic_v<TYPE> || std::is_enum_v<TYPE> >>
+        BinaryWriter & operator << (BinaryWriter & i_dest, const TYPE & i_object)
+    {
+        auto const address = reinterpret_cast<const unsigned char*>(&i_object);
+        return i_dest << Span(address, sizeof(TYPE));
+    }
+
+    BinaryWriter & operator << (BinaryWriter & i_dest, std::string_view i_string);
+
+    BinaryWriter & operator << (BinaryWriter & i_dest, const FixedShape & i_shape);
+
+    BinaryWriter & operator << (BinaryWriter & i_dest, const std::vector<Integer> & i_integers);
+
+    BinaryWriter & operator << (BinaryWriter & i_dest, const TensorType & i_type);
+
+    BinaryWriter & operator << (BinaryWriter & i_dest, const TensorValue & i_value);
+
+    /* Reads expression graphs written by BinaryWriter. Nodes are rebuilt as they
+        were written: no type deduction, canonicalization or constant propagation
+        is performed. */
+    class BinaryReader
+    {
+    public:
+
+        BinaryReader(std::istream & i_source);
+
+        BinaryReader(const BinaryReader &) = delete;
+        BinaryReader & operator = (const BinaryReader &) = delete;
+
+        void Read(Span<unsigned char> o_data);
+
+        size_t ReadSize();
+
+        template <typename TYPE>
+            TYPE Read()
+        {
+            static_assert(std::is_arithmetic_v<TYPE> || std::is_enum_v<TYPE>,
+                "BinaryReader::Read - unsupported type");
+            TYPE result;
+            Read(Span(reinterpret_cast<unsigned char*>(&result), sizeof(TYPE)));
+            return result;
+        }
+
+        const Tensor & GetNode(size_t i_node_index) const;
+
+        // reads all nodes and returns the roots
+        std::vector<Tensor> ReadGraph();
+
+    private:
+        void ReadNode();
+
+    private:
+        std::istream & m_source;
+        std::vector<Tensor> m_nodes;
+    };
+
+    template <> std::string BinaryReader::Read<std::string>();
+    template <> FixedShape BinaryReader::Read<FixedShape>();
+    template <> std::vector<Integer> BinaryReader::Read<std::vector<Integer>>();
+    template <> TensorType BinaryReader::Read<TensorType>();
+    template <> TensorValue BinaryReader::Read<TensorValue>();
+}
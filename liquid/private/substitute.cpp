@@ -0,0 +1,203 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "liquid/tensor.h"
+#include "expression.h"
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+namespace liquid
+{
+    extern const Operator & GetOperatorIf();
+
+    namespace
+    {
+        /* Applies many rules in a single iterative traversal of the graph. Rules
+            are indexed by the hash of the expression they replace, and every unique
+            node is visited once. Nodes are rebuilt bottom-up only if some operand
+            changed, so operators whose operands all became constant are evaluated
+            as soon as the operands are available. Replacements are not substituted
+            again.
+            The operands of an 'If' are visited lazily: first the conditions, then only
+            the values that may be selected. A value whose condition became uniformly
+            false, or that follows a condition that became uniformly true, is left as it
+            is, and it's dropped by the canonicalization of the 'If'. */
+        class Substitution
+        {
+        public:
+
+            Substitution(Span<const Rule> i_rules)
+            {
+                m_rules.reserve(i_rules.size());
+                for(const Rule & rule : i_rules)
+                {
+                    if(IsUniformConstant(rule.m_when, false))
+                        continue;
+
+                    Tensor replacement = IsUniformConstant(rule.m_when, true) ? rule.m_with :
+                        If(rule.m_when, rule.m_with, rule.m_what);
+
+                    m_rules[rule.m_what.GetExpression()->GetHash().GetValue()].push_back(
+                        { rule.m_what, std::move(replacement) });
+                }
+            }
+
+            Tensor Apply(const Tensor & i_where)
+            {
+                if(m_rules.empty() || TryReplace(i_where))
+                    return Find(i_where);
+
+                // every rule usually matches a variable used by an operation
+                m_results.reserve(m_rules.size() * 4);
+
+                std::vector<Frame> stack{ { &i_where, Stage::Unvisited } };
+                while(!stack.empty())
+                {
+                    Frame & frame = stack.back();
+                    const Tensor & tensor = *frame.m_tensor;
+                    const Expression & expression = *tensor.GetExpression();
+                    if(frame.m_stage == Stage::OperandsPushed)
+                    {
+                        m_results.emplace(&expression, Rebuild(tensor));
+                        stack.pop_back();
+                        continue;
+                    }
+
+                    if(frame.m_stage == Stage::ConditionsPushed)
+                    {
+                        frame.m_stage = Stage::OperandsPushed;
+                        PushSelectableValues(expression.GetOperands(), stack);
+                        continue;
+                    }
+
+                    // shared nodes may have been pushed more than once
+                    if(m_results.find(&expression) != m_results.end())
+                    {
+                        stack.pop_back();
+                        continue;
+                    }
+
+                    const std::vector<Tensor> & operands = expression.GetOperands();
+                    if(expression.OperatorIs(GetOperatorIf()))
+                    {
+                        frame.m_stage = Stage::ConditionsPushed;
+                        for(size_t index = 0; index + 1 < operands.size(); index += 2)
+                            Push(operands[index], stack);
+                    }
+                    else
+                    {
+                        frame.m_stage = Stage::OperandsPushed;
+                        for(const Tensor & operand : operands)
+                            Push(operand, stack);
+                    }
+                }
+                return Find(i_where);
+            }
+
+        private:
+
+            struct Replacement
+            {
+                Tensor m_what;
+                Tensor m_with;
+            };
+
+            /* a node is rebuilt when it's visited again, after all its operands. The
+                values of an 'If' are pushed only after its conditions are substituted. */
+            enum class Stage { Unvisited, ConditionsPushed, OperandsPushed };
+            struct Frame
+            {
+                const Tensor * m_tensor;
+                Stage m_stage;
+            };
+
+            void Push(const Tensor & i_tensor, std::vector<Frame> & io_stack)
+            {
+                if(m_results.find(i_tensor.GetExpression().get()) == m_results.end() &&
+                    !TryReplace(i_tensor))
+                {
+                    io_stack.push_back({ &i_tensor, Stage::Unvisited });
+                }
+            }
+
+            // pushes the values of an 'If' that may be selected given the substituted conditions
+            void PushSelectableValues(const std::vector<Tensor> & i_if_operands, std::vector<Frame> & io_stack)
+            {
+                for(size_t index = 0; index + 1 < i_if_operands.size(); index += 2)
+                {
+                    const Tensor & condition = Find(i_if_operands[index]);
+                    if(IsUniformConstant(condition, true))
+                    {
+                        Push(i_if_operands[index + 1], io_stack);
+                        return;
+                    }
+                    if(!IsUniformConstant(condition, false))
+                        Push(i_if_operands[index + 1], io_stack);
+                }
+                Push(i_if_operands.back(), io_stack);
+            }
+
+            const Tensor & Find(const Tensor & i_tensor) const
+            {
+                auto const it = m_results.find(i_tensor.GetExpression().get());
+                return it != m_results.end() ? it->second : i_tensor;
+            }
+
+            bool TryReplace(const Tensor & i_tensor)
+            {
+                auto const bucket = m_rules.find(i_tensor.GetExpression()->GetHash().GetValue());
+                if(bucket == m_rules.end())
+                    return false;
+
+                for(const Replacement & replacement : bucket->second)
+                {
+                    if(AreIdentical(replacement.m_what, i_tensor))
+                    {
+                        m_results.emplace(i_tensor.GetExpression().get(), replacement.m_with);
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            Tensor Rebuild(const Tensor & i_tensor) const
+            {
+                const Expression & expression = *i_tensor.GetExpression();
+
+                std::vector<Tensor> operands;
+                operands.reserve(expression.GetOperands().size());
+                bool some_operand_replaced = false;
+                for(const Tensor & operand : expression.GetOperands())
+                {
+                    operands.push_back(Find(operand));
+                    some_operand_replaced = some_operand_replaced ||
+                        operands.back().GetExpression() != operand.GetExpression();
+                }
+
+                if(!some_operand_replaced)
+                    return i_tensor;
+
+                return expression.GetOperator().Invoke(expression.GetName(), 
+                    expression.GetDoc(), operands, expression.GetAttachment());
+            }
+
+        private:
+            std::unordered_map<Hash::Word, std::vector<Replacement>> m_rules;
+            std::unordered_map<const Expression *, Tensor> m_results;
+        };
+    }
+
+    Tensor Substitute(const Tensor & i_where, const Tensor & i_what,
+        const Tensor & i_with, const Tensor & i_when)
+    {
+        return Substitute(i_where, { Rule{ i_what, i_with, i_when } });
+    }
+
+    Tensor Substitute(const Tensor & i_where, Span<const Rule> i_rules)
+    {
+        return Substitution(i_rules).Apply(i_where);
+    }
+}
@@ -20,26 +20,47 @@ namespace liquid
     {
         if (IsConstant(*this))
         {
-            const TensorValue & value = GetConstantValue(*this);
+            const TensorValue & source_value = GetConstantValue(*this);
             switch (GetScalarType())
             {
                 case ScalarType::Real:
                 {
-                    TensorValue value(Span(value.GetAs<Real>()), FixedShape(i_shape));
+                    TensorValue value(Span(source_value.GetAs<Real>()), FixedShape(i_shape));
                     m_expression = MakeConstant(value).GetExpression();
                     break;
                 }
 
                 case ScalarType::Integer:
                 {
-                    TensorValue value(Span(value.GetAs<Integer>()), FixedShape(i_shape));
+                    TensorValue value(Span(source_value.GetAs<Integer>()), FixedShape(i_shape));
                     m_expression = MakeConstant(value).GetExpression();
                     break;
                 }
 
                 case ScalarType::Bool:
                 {
-                    TensorValue value(Span(value.GetAs<Bool>()), FixedShape(i_shape));
+                    TensorValue value(Span(source_value.GetAs<Bool>()), FixedShape(i_shape));
+                    m_expression = MakeConstant(value).GetExpression();
+                    break;
+                }
+
+                case ScalarType::Real32:
+                {
+                    TensorValue value(Span(source_value.GetAs<Real32>()), FixedShape(i_shape));
+                    m_expression = MakeConstant(value).GetExpression();
+                    break;
+                }
+
+                case ScalarType::Integer32:
+                {
+                    TensorValue value(Span(source_value.GetAs<Integer32>()), FixedShape(i_shape));
+                    m_expression = MakeConstant(value).GetExpression();
+                    break;
+                }
+
+                case ScalarType::Integer8:
+                {
+                    TensorValue value(Span(source_value.GetAs<Integer8>()), FixedShape(i_shape));
                     m_expression = MakeConstant(value).GetExpression();
                     break;
                 }
@@ -1,4 +1,3 @@
-
 //   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
 // Distributed under the Boost Software License, Version 1.0.
 //    (See accompanying file LICENSE_1_0.txt or copy at
@@ -6,28 +5,127 @@
 
 #include "liquid/tensor.h"
 #include "expression.h"
+#include <unordered_map>
+#include <vector>
+#include <limits>
 
 namespace liquid
 {
-    std::ostream & operator << (std::ostream & i_dest, const Tensor & i_tensor)
+    namespace
     {
-        if(IsConstant(i_tensor))
+        /* Prints an expression graph visiting every unique node once. Operations
+            referenced more than once get a label, and are printed once in a let
+            binding that precedes the root:
+                let $0 = sin(x); add($0, exp($0)) */
+        class TensorPrinter
         {
-            switch(i_tensor.GetScalarType())
+        public:
+
+            TensorPrinter(std::ostream & i_dest)
+                : m_dest(i_dest)
             {
-                case ScalarType::Real: i_dest << GetConstantStorage<Real>(i_tensor); break;
-                case ScalarType::Integer: i_dest << GetConstantStorage<Integer>(i_tensor); break;
-                case ScalarType::Bool: i_dest << GetConstantStorage<Bool>(i_tensor); break;
-                default: Panic("PrintTensor: unsupported scalar type");
             }
-        }
-        else if(IsVariable(i_tensor))
-        {
-            i_dest << i_tensor.GetExpression()->GetName();
-        }
-        else
-            i_dest << i_tensor.GetExpression()->GetOperator().GetName() 
-                << "(" << Span(i_tensor.GetExpression()->GetOperands()) << ")";
+
+            void Print(const Tensor & i_tensor)
+            {
+                CountReferences(i_tensor);
+
+                // the post-order guarantees that bindings are printed after their dependencies
+                size_t label_count = 0;
+                for(const Tensor * tensor : m_post_order)
+                {
+                    Node & node = m_nodes[tensor->GetExpression().get()];
+                    if(node.m_references > 1 && !IsLeaf(*tensor))
+                    {
+                        m_dest << (label_count == 0 ? "let " : ", ") << "$" << label_count << " = ";
+                        PrintDefinition(*tensor);
+                        node.m_label = label_count++;
+                    }
+                }
+                if(label_count != 0)
+                    m_dest << "; ";
+
+                PrintReference(i_tensor);
+            }
+
+        private:
+
+            static bool IsLeaf(const Tensor & i_tensor)
+            {
+                return IsConstant(i_tensor) || IsVariable(i_tensor);
+            }
+
+            void CountReferences(const Tensor & i_tensor)
+            {
+                Node & node = m_nodes[i_tensor.GetExpression().get()];
+                if(node.m_references++ != 0)
+                    return;
+
+                for(const Tensor & operand : i_tensor.GetExpression()->GetOperands())
+                    CountReferences(operand);
+                m_post_order.push_back(&i_tensor);
+            }
+
+            void PrintReference(const Tensor & i_tensor)
+            {
+                auto const it = m_nodes.find(i_tensor.GetExpression().get());
+                if(it != m_nodes.end() && it->second.m_label != s_no_label)
+                    m_dest << "$" << it->second.m_label;
+                else
+                    PrintDefinition(i_tensor);
+            }
+
+            void PrintDefinition(const Tensor & i_tensor)
+            {
+                if(IsConstant(i_tensor))
+                {
+                    switch(i_tensor.GetScalarType())
+                    {
+                        case ScalarType::Real: m_dest << GetConstantStorage<Real>(i_tensor); break;
+                        case ScalarType::Integer: m_dest << GetConstantStorage<Integer>(i_tensor); break;
+                        case ScalarType::Bool: m_dest << GetConstantStorage<Bool>(i_tensor); break;
+                        case ScalarType::Real32: m_dest << GetConstantStorage<Real32>(i_tensor); break;
+                        case ScalarType::Integer32: m_dest << GetConstantStorage<Integer32>(i_tensor); break;
+                        case ScalarType::Integer8: m_dest << GetConstantStorage<Integer8>(i_tensor); break;
+                        default: Panic("PrintTensor: unsupported scalar type");
+                    }
+                }
+                else if(IsVariable(i_tensor))
+                {
+                    m_dest << i_tensor.GetExpression()->GetName();
+                }
+                else
+                {
+                    m_dest << i_tensor.GetExpression()->GetOperator().GetName() << "(";
+                    auto const & operands = i_tensor.GetExpression()->GetOperands();
+                    for(size_t i = 0; i < operands.size(); i++)
+                    {
+                        if(i != 0)
+                            m_dest << ", ";
+                        PrintReference(operands[i]);
+                    }
+                    m_dest << ")";
+                }
+            }
+
+        private:
+            constexpr static size_t s_no_label = std::numeric_limits<size_t>::max();
+
+            struct Node
+            {
+                size_t m_references = 0;
+                size_t m_label = s_no_label;
+            };
+
+            std::ostream & m_dest;
+            std::unordered_map<const Expression *, Node> m_nodes;
+            std::vector<const Tensor *> m_post_order;
+        };
+    }
+
+    std::ostream & operator << (std::ostream & i_dest, const Tensor & i_tensor)
+    {
+        TensorPrinter(i_dest).Print(i_tensor);
         return i_dest;
     }
 }
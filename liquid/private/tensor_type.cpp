@@ -6,9 +6,12 @@
 
 #include "tensor_type.h"
 #include "expression.h"
+#include <algorithm>
 
 namespace liquid
 {
+    extern const Operator & GetOperatorStack();
+
     ScalarType DeduceScalarType(Span<const ScalarType> i_operand_types)
     {
         ScalarType result_type = ScalarType::Any;
@@ -23,7 +26,8 @@ namespace liquid
                 if(IsNumeric(result_type) && IsNumeric(operand_type))
                 {
                     // numeric promotion
-                    result_type = ScalarType::Real;
+                    if(GetNumericRank(operand_type) > GetNumericRank(result_type))
+                        result_type = operand_type;
                 }
                 else
                 {
@@ -37,23 +41,120 @@ namespace liquid
     TensorType DeduceType(Span<const TensorType> i_operand_types)
     {
         std::vector<ScalarType> scalar_types;
-        std::vector<FixedShape> shapes;
-
         scalar_types.reserve(i_operand_types.size());
-        shapes.reserve(i_operand_types.size());
-
         for (auto const & operand_type : i_operand_types)
-        {
             scalar_types.push_back(operand_type.GetScalarType());
-            if(operand_type.HasFixedShape())
-                shapes.push_back(operand_type.GetFixedShape());
+
+        return { DeduceScalarType(scalar_types), BroadcastShapes(i_operand_types) };
+    }
+
+    std::optional<std::vector<Tensor>> TryGetDimensions(const TensorType & i_type)
+    {
+        if(i_type.HasFixedShape())
+            return Transform(i_type.GetFixedShape().GetDimensions(),
+                [](Integer i_dimension){ return Tensor(i_dimension); });
+
+        if(!i_type.HasVariableShape())
+            return {};
+
+        const Expression & shape_vector = *i_type.GetVariableShape().GetExpression();
+        if(!shape_vector.OperatorIs(GetOperatorStack()) || shape_vector.GetAttachment().has_value())
+            return {};
+        for(const Tensor & dimension : shape_vector.GetOperands())
+        {
+            // a dimension variable may be declared without shape, like n in real[int n, 3] x
+            const TensorType & dimension_type = dimension.GetExpression()->GetType();
+            if(dimension_type.GetScalarType() != ScalarType::Integer || (dimension_type.HasShape() &&
+                    !(dimension_type.HasFixedShape() && dimension_type.GetFixedShape().GetRank() == 0)))
+                return {};
         }
+        return shape_vector.GetOperands();
+    }
+
+    std::optional<size_t> TryGetRank(const TensorType & i_type)
+    {
+        if(i_type.HasFixedShape())
+            return i_type.GetFixedShape().GetDimensions().size();
+        if(auto const dimensions = TryGetDimensions(i_type))
+            return dimensions->size();
+        return {};
+    }
 
-        ScalarType const scalar_type = DeduceScalarType(scalar_types);
-        if(shapes.size() == i_operand_types.size())
-            return { scalar_type, Broadcast(shapes) };
-        else
-            return { scalar_type };
+    TensorType::ShapeVector MakeShapeVector(Span<const Tensor> i_dimensions)
+    {
+        if(i_dimensions.empty())
+            return FixedShape::Scalar();
+        return TensorType(ScalarType::Any, Stack(i_dimensions)).GetShape();
+    }
+
+    TensorType::ShapeVector BroadcastShapes(Span<const TensorType> i_types,
+        std::vector<Tensor> * o_constraints)
+    {
+        std::vector<FixedShape> fixed_shapes;
+        for (const TensorType & type : i_types)
+            if(type.HasFixedShape())
+                fixed_shapes.push_back(type.GetFixedShape());
+        if(fixed_shapes.size() == i_types.size())
+            return Broadcast(fixed_shapes);
+
+        std::vector<std::vector<Tensor>> shapes;
+        for (const TensorType & type : i_types)
+        {
+            if(auto dimensions = TryGetDimensions(type))
+                shapes.push_back(std::move(*dimensions));
+            else
+                return {};
+        }
+
+        size_t rank = 0;
+        for (const std::vector<Tensor> & shape : shapes)
+            rank = std::max(rank, shape.size());
+
+        // like TryBroadcast, but a dimension 1 is recognized only if it's a constant
+        std::vector<Tensor> constraints;
+        std::vector<Tensor> dimensions(rank, MakeConstant<1>());
+        for (size_t dim_index = 0; dim_index < rank; dim_index++)
+        {
+            Tensor & this_dim = dimensions[dim_index];
+            for (const std::vector<Tensor> & shape : shapes)
+            {
+                size_t const rank_offset = rank - shape.size();
+                if(dim_index < rank_offset)
+                    continue;
+
+                const Tensor & source_dim = shape[dim_index - rank_offset];
+                if(AreIdentical(source_dim, MakeConstant<1>()) || AreIdentical(source_dim, this_dim))
+                    continue;
+
+                if(AreIdentical(this_dim, MakeConstant<1>()))
+                    this_dim = source_dim;
+                else if(IsConstant(this_dim) && IsConstant(source_dim))
+                    Panic("Broadcast failure");
+                else
+                {
+                    AddShapeConstraint(constraints, this_dim == source_dim ||
+                        this_dim == 1 || source_dim == 1);
+
+                    // a constant is the broadcast dimension, unless the other dimension is 1
+                    if(IsConstant(source_dim))
+                        this_dim = source_dim;
+                    else if(!IsConstant(this_dim))
+                        this_dim = If(this_dim == 1, source_dim, this_dim);
+                }
+            }
+        }
+
+        if(o_constraints != nullptr)
+            o_constraints->insert(o_constraints->end(), constraints.begin(), constraints.end());
+        return MakeShapeVector(dimensions);
+    }
+
+    void AddShapeConstraint(std::vector<Tensor> & io_constraints, const Tensor & i_condition)
+    {
+        if(IsUniformConstant(i_condition, false))
+            Panic("Incompatible shapes: ", i_condition, " is never true");
+        if(!IsUniformConstant(i_condition, true))
+            io_constraints.push_back(i_condition);
     }
 
     TensorType::TensorType(ScalarType i_scalar_type, const ShapeVector & i_shape)
@@ -113,7 +214,8 @@ namespace liquid
 
             bool operator () (const Tensor & i_shape) const
             {
-                return Always(m_this.GetVariableShape() == m_other.GetVariableShape());
+                return m_other.HasVariableShape() &&
+                    Always(m_this.GetVariableShape() == m_other.GetVariableShape());
             }
         };
 
@@ -127,6 +229,20 @@ namespace liquid
 
         if (HasFixedShape() && i_other.HasFixedShape())
             return GetFixedShape() == i_other.GetFixedShape();
+
+        // a symbolic shape matches a fixed shape with the same rank and constant dimensions
+        if (i_other.HasFixedShape())
+        {
+            if(auto const dimensions = TryGetDimensions(*this))
+            {
+                Span<const Integer> const other_dimensions = i_other.GetFixedShape().GetDimensions();
+                if(dimensions->size() != other_dimensions.size())
+                    return false;
+                for(size_t index = 0; index < other_dimensions.size(); index++)
+                    if(IsConstant((*dimensions)[index]) && !AlwaysEqual((*dimensions)[index], other_dimensions[index]))
+                        return false;
+            }
+        }
         return true;
     }
 
@@ -137,6 +253,8 @@ namespace liquid
 
         if(i_tensor_type.HasFixedShape())
             i_ostream << i_tensor_type.GetFixedShape();
+        else if(auto const dimensions = TryGetDimensions(i_tensor_type))
+            i_ostream << "[" << Span<const Tensor>(*dimensions) << "]";
 
         return i_ostream;
     }
@@ -7,6 +7,8 @@
 #pragma once
 
 #include <variant>
+#include <optional>
+#include <vector>
 #include "private_common.h"
 #include "liquid/tensor.h"
 #include "fixed_shape.h"
@@ -56,4 +58,26 @@ namespace liquid
     ScalarType DeduceScalarType(Span<const ScalarType> i_operand_types);
 
     TensorType DeduceType(Span<const TensorType> i_operand_types);
+
+    /* Symbolic shapes. A variable shape is a vector of integer scalars, like the shape of
+        real[int n, 3] x. The dimensions are constants if they are known at compile time,
+        otherwise expressions of dimension variables, like n. */
+
+    // returns the dimensions of a fixed shape, or of a variable shape made by a stack of scalars
+    std::optional<std::vector<Tensor>> TryGetDimensions(const TensorType & i_type);
+
+    std::optional<size_t> TryGetRank(const TensorType & i_type);
+
+    // the shape with the given dimensions, that is a fixed shape if they are all constant
+    TensorType::ShapeVector MakeShapeVector(Span<const Tensor> i_dimensions);
+
+    /* Broadcasts the shapes of some types, that may be symbolic. Dimensions that are not
+        identical, and that can't be compared at compile time, add to o_constraints a bool
+        scalar that must be true for the shapes to be compatible. If the dimensions of some
+        type are unknown the shape is undefined. */
+    TensorType::ShapeVector BroadcastShapes(Span<const TensorType> i_types,
+        std::vector<Tensor> * o_constraints = nullptr);
+
+    // adds a condition to io_constraints, unless it's always true
+    void AddShapeConstraint(std::vector<Tensor> & io_constraints, const Tensor & i_condition);
 }
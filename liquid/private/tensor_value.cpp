@@ -7,9 +7,20 @@
 #include "tensor_value.h"
 #include "indices.h"
 #include <algorithm>
+#include <mutex>
 
 namespace liquid
 {
+    /* The layout of a view. The dense copy used by GetAs is created by the first thread
+        that needs it, and shared by all the copies of the value. */
+    struct TensorValue::View
+    {
+        std::vector<Integer> m_strides;
+        Integer m_offset = 0;
+        std::once_flag m_dense_flag;
+        std::unique_ptr<TensorValue> m_dense;
+    };
+
     template <typename SCALAR_TYPE>
         size_t TensorValue::ConstantWrapping(const FixedShape & i_shape, Span<const SCALAR_TYPE> i_scalars)
     {
@@ -38,69 +49,155 @@ namespace liquid
 
     void TensorValue::DynamicConstantWrapping()
     {
-        switch (m_type.GetScalarType())
-        {
-            case ScalarType::Real:
-            {
-                auto const scalars = GetAs<Real>();
-                size_t const reduced_size = ConstantWrapping<Real>(m_type.GetFixedShape(), scalars);
-                if(reduced_size != scalars.size())
-                    m_scalars = Span<const Real>(scalars.data(), reduced_size);
-                break;
-            }
-
-            case ScalarType::Integer:
-            {
-                auto const scalars = GetAs<Integer>();
-                size_t const reduced_size = ConstantWrapping<Integer>(m_type.GetFixedShape(), scalars);
-                if (reduced_size != scalars.size())
-                    m_scalars = Span<const Integer>(scalars.data(), reduced_size);
-                break;
-            }
+        if(m_type.GetScalarType() == ScalarType::Any)
+            Panic("TensorValue - ScalarType::Any canot be used for a value");
 
-            case ScalarType::Bool:
+        std::visit([this](const auto & i_scalars) {
+            using ELEMENT = std::remove_const_t<typename std::decay_t<decltype(i_scalars)>::value_type>;
+            size_t const reduced_size = ConstantWrapping<ELEMENT>(m_type.GetFixedShape(), i_scalars);
+            if(reduced_size != i_scalars.size())
             {
-                auto const scalars = GetAs<Bool>();
-                size_t const reduced_size = ConstantWrapping<Bool>(m_type.GetFixedShape(), scalars);
-                if (reduced_size != scalars.size())
-                    m_scalars = Span<const Bool>(scalars.data(), reduced_size);
-                break;
+                SharedArray<const ELEMENT> reduced(Span<const ELEMENT>(i_scalars.data(), reduced_size));
+                m_scalars = std::move(reduced);
             }
+        }, m_scalars);
+    }
 
-            case ScalarType::Any: Panic("TensorValue - ScalarType::Any canot be used for a value");
-
-            default: Panic("Unrecognized scalar type ", static_cast<int>(m_type.GetScalarType()));
-        }
+    template <typename SCALAR_TYPE>
+        void TensorValue::SetWrappedScalars(SharedArray<const SCALAR_TYPE> && i_scalars)
+    {
+        size_t const reduced_size = ConstantWrapping<SCALAR_TYPE>(m_type.GetFixedShape(), i_scalars);
+        if(reduced_size == i_scalars.size())
+            m_scalars = std::move(i_scalars);
+        else
+            m_scalars = SharedArray<const SCALAR_TYPE>(Span<const SCALAR_TYPE>(i_scalars.data(), reduced_size));
     }
 
     TensorValue::TensorValue(SharedArray<const Real> && i_reals, const FixedShape& i_shape)
         : m_type(ScalarType::Real, i_shape)
     {
-        size_t const reduced_size = ConstantWrapping<Real>(m_type.GetFixedShape(), i_reals);
-        if(reduced_size == i_reals.size())
-            m_scalars = std::move(i_reals);
-        else
-            m_scalars = Span<const Real>(i_reals.data(), reduced_size);
+        SetWrappedScalars(std::move(i_reals));
     }
 
     TensorValue::TensorValue(SharedArray<const Integer> && i_integers, const FixedShape & i_shape)
         : m_type(ScalarType::Integer, i_shape)
     {
-        size_t const reduced_size = ConstantWrapping<Integer>(m_type.GetFixedShape(), i_integers);
-        if (reduced_size == i_integers.size())
-            m_scalars = std::move(i_integers);
-        else
-            m_scalars = Span<const Integer>(i_integers.data(), reduced_size);
+        SetWrappedScalars(std::move(i_integers));
     }
 
     TensorValue::TensorValue(SharedArray<const Bool> && i_bools, const FixedShape& i_shape)
         : m_type(ScalarType::Bool, i_shape)
     {
-        size_t const reduced_size = ConstantWrapping<Bool>(m_type.GetFixedShape(), i_bools);
-        if (reduced_size == i_bools.size())
-            m_scalars = std::move(i_bools);
-        else
-            m_scalars = Span<const Bool>(i_bools.data(), reduced_size);
+        SetWrappedScalars(std::move(i_bools));
+    }
+
+    TensorValue::TensorValue(SharedArray<const Real32> && i_reals, const FixedShape& i_shape)
+        : m_type(ScalarType::Real32, i_shape)
+    {
+        SetWrappedScalars(std::move(i_reals));
+    }
+
+    TensorValue::TensorValue(SharedArray<const Integer32> && i_integers, const FixedShape & i_shape)
+        : m_type(ScalarType::Integer32, i_shape)
+    {
+        SetWrappedScalars(std::move(i_integers));
+    }
+
+    TensorValue::TensorValue(SharedArray<const Integer8> && i_integers, const FixedShape & i_shape)
+        : m_type(ScalarType::Integer8, i_shape)
+    {
+        SetWrappedScalars(std::move(i_integers));
+    }
+
+    TensorValue::TensorValue(const TensorValue & i_source, const FixedShape & i_shape,
+            Span<const Integer> i_strides, Integer i_offset)
+        : m_type(i_source.GetScalarType(), i_shape), m_scalars(i_source.m_scalars)
+    {
+        Span<const Integer> const dimensions = i_shape.GetDimensions();
+        if(i_strides.size() != dimensions.size())
+            Panic("TensorValue - the view has rank ", dimensions.size(), " but ", i_strides.size(), " strides");
+
+        /* a row-major layout at the beginning of the storage is not a view, as long as the
+            wrapping of the storage is compatible with the shape */
+        bool row_major = i_offset == 0;
+        for(size_t dimension = 0; dimension < dimensions.size() && row_major; dimension++)
+            row_major = dimensions[dimension] == 1 || i_strides[dimension] == i_shape.GetStride(NumericCast<Integer>(dimension + 1));
+        size_t const storage_size = std::visit([](const auto & i_scalars){ return i_scalars.size(); }, m_scalars);
+        Span<const Integer> const shape_strides = i_shape.GetStrides();
+        if(row_major && std::find(shape_strides.begin(), shape_strides.end(), NumericCast<Integer>(storage_size)) != shape_strides.end())
+        {
+            DynamicConstantWrapping();
+            return;
+        }
+
+        m_view = std::make_shared<View>();
+        m_view->m_strides.assign(i_strides.begin(), i_strides.end());
+        m_view->m_offset = i_offset;
+    }
+
+    Span<const Integer> TensorValue::GetStorageStrides() const
+    {
+        if(IsView())
+            return m_view->m_strides;
+        return GetShape().GetStrides().subspan(1);
+    }
+
+    Integer TensorValue::GetStorageOffset() const
+    {
+        return IsView() ? m_view->m_offset : 0;
+    }
+
+    Integer TensorValue::GetPhysicalLinearIndex(Span<const Integer> i_indices) const
+    {
+        if(!IsView())
+            return GetShape().GetPhysicalLinearIndex(i_indices);
+
+        Span<const Integer> const dimensions = GetShape().GetDimensions();
+        if(i_indices.size() < dimensions.size())
+            Panic("LinearIndex - Too few indices");
+        i_indices = i_indices.subspan(i_indices.size() - dimensions.size());
+
+        Integer linear_index = m_view->m_offset;
+        for(size_t i = 0; i < dimensions.size(); i++)
+        {
+            if(i_indices[i] < dimensions[i])
+                linear_index += i_indices[i] * m_view->m_strides[i];
+            else if(dimensions[i] != 1)
+                Panic("LinearIndex - index out of bounds");
+        }
+        return linear_index;
+    }
+
+    const TensorValue & TensorValue::GetDense() const
+    {
+        std::call_once(m_view->m_dense_flag, [this]{
+            std::visit([this](const auto & i_scalars) {
+                using ELEMENT = std::remove_const_t<typename std::decay_t<decltype(i_scalars)>::value_type>;
+                const FixedShape & shape = GetShape();
+                Span<const Integer> const dimensions = shape.GetDimensions();
+                const std::vector<Integer> & strides = m_view->m_strides;
+                SharedArray<ELEMENT> dense(NumericCast<size_t>(shape.GetLinearSize()));
+
+                // the destination is written sequentially, the storage index follows the counters
+                std::vector<Integer> counters(dimensions.size());
+                Integer storage_index = m_view->m_offset;
+                for(ELEMENT & element : dense)
+                {
+                    element = i_scalars[static_cast<size_t>(storage_index) % i_scalars.size()];
+                    for(size_t dimension = dimensions.size(); dimension-- > 0; )
+                    {
+                        storage_index += strides[dimension];
+                        if(++counters[dimension] < dimensions[dimension])
+                            break;
+                        storage_index -= strides[dimension] * dimensions[dimension];
+                        counters[dimension] = 0;
+                    }
+                }
+                m_view->m_dense = std::make_unique<TensorValue>(
+                    SharedArray<const ELEMENT>(std::move(dense)), shape);
+            }, m_scalars);
+        });
+        return *m_view->m_dense;
     }
 
     void TensorValue::UnflattenLowerDim(const FixedShape & i_dest_shape)
@@ -241,26 +338,36 @@ namespace liquid
         if(!shape)
             return false;
 
-        std::pair const types = {i_first.GetScalarType(), i_second.GetScalarType()};
-        
-        if(types == std::pair{ScalarType::Bool, ScalarType::Bool})
-            return EqualsImpl<Bool, Bool, Bool>(*shape, i_first, i_second);
-
-        else if(types == std::pair{ScalarType::Real, ScalarType::Real})
-            return EqualsImpl<Real, Real, Real>(*shape, i_first, i_second);
-
-        else if(types == std::pair{ScalarType::Real, ScalarType::Integer})
-            return EqualsImpl<Real, Real, Integer>(*shape, i_first, i_second);
-
-        else if(types == std::pair{ScalarType::Integer, ScalarType::Real})
-            return EqualsImpl<Real, Integer, Real>(*shape, i_first, i_second);
+        // numeric scalars are compared after the promotion to a common type
+        return std::visit([&](const auto & i_first_scalars, const auto & i_second_scalars) {
+            using FIRST = std::remove_const_t<typename std::decay_t<decltype(i_first_scalars)>::value_type>;
+            using SECOND = std::remove_const_t<typename std::decay_t<decltype(i_second_scalars)>::value_type>;
+            return EqualsImpl<std::common_type_t<FIRST, SECOND>, FIRST, SECOND>(*shape, i_first, i_second);
+        }, i_first.m_scalars, i_second.m_scalars);
+    }
 
-        else if(types == std::pair{ScalarType::Integer, ScalarType::Integer})
-            return EqualsImpl<Integer, Integer, Integer>(*shape, i_first, i_second);
+    template <typename DEST_TYPE, typename SOURCE_TYPE>
+        TensorValue CastScalars(const TensorValue & i_source)
+    {
+        auto const source = i_source.GetAs<SOURCE_TYPE>();
+        SharedArray<DEST_TYPE> dest(source.size());
+        for(size_t i = 0; i < source.size(); i++)
+            dest[i] = NumericCast<DEST_TYPE>(source[i]);
+        return TensorValue(std::move(dest), i_source.GetShape());
+    }
 
-        else
-            Panic("TensorValue - operator == - Unexpected scalar types: ",
-                types.first, " and ", types.second);
+    template <typename DEST_TYPE>
+        TensorValue CastTo(const TensorValue & i_source)
+    {
+        switch(i_source.GetScalarType())
+        {
+            case ScalarType::Real: return CastScalars<DEST_TYPE, Real>(i_source);
+            case ScalarType::Integer: return CastScalars<DEST_TYPE, Integer>(i_source);
+            case ScalarType::Real32: return CastScalars<DEST_TYPE, Real32>(i_source);
+            case ScalarType::Integer32: return CastScalars<DEST_TYPE, Integer32>(i_source);
+            case ScalarType::Integer8: return CastScalars<DEST_TYPE, Integer8>(i_source);
+            default: Panic("TensorValue Cast - ", i_source.GetScalarType(), " is not a numeric type");
+        }
     }
 
     TensorValue Cast(ScalarType i_dest_type, const TensorValue & i_source)
@@ -274,29 +381,69 @@ namespace liquid
         if(!IsNumeric(i_source.GetScalarType()))
             Panic("TensorValue Cast - ", i_source.GetScalarType(), " is not a numeric type");
 
-        if(i_dest_type == ScalarType::Real)
+        // the conversion of every scalar must be exact
+        switch(i_dest_type)
         {
-            auto const integers = i_source.GetAs<Integer>();
-            SharedArray<Real> reals(integers.size());
-            for(size_t i = 0; i < integers.size(); i++)
-                reals[i] = NumericCast<Real>(integers[i]);
-            return TensorValue(std::move(reals), i_source.GetShape());
+            case ScalarType::Real: return CastTo<Real>(i_source);
+            case ScalarType::Integer: return CastTo<Integer>(i_source);
+            case ScalarType::Real32: return CastTo<Real32>(i_source);
+            case ScalarType::Integer32: return CastTo<Integer32>(i_source);
+            case ScalarType::Integer8: return CastTo<Integer8>(i_source);
+            default: Panic("TensorValue Cast - unrecognized scalar type: ", i_dest_type);
         }
-        else if(i_dest_type == ScalarType::Integer)
+    }
+
+    /* Hashes a view as its dense copy, without creating it: the dense copy would be wrapped
+        by ConstantWrapping, so the elements are visited in row-major order to find the wrapped
+        size, and then the wrapped elements are hashed. */
+    template <typename ELEMENT>
+        void HashView(Hash & i_dest, const FixedShape & i_shape, Span<const Integer> i_strides,
+            Integer i_offset, Span<const ELEMENT> i_scalars)
+    {
+        Span<const Integer> const dimensions = i_shape.GetDimensions();
+        auto const element_at = [&](Integer i_linear_index) {
+            Integer storage_index = i_offset;
+            for(size_t dimension = dimensions.size(); dimension-- > 0; )
+            {
+                storage_index += (i_linear_index % dimensions[dimension]) * i_strides[dimension];
+                i_linear_index /= dimensions[dimension];
+            }
+            return i_scalars[static_cast<size_t>(storage_index) % i_scalars.size()];
+        };
+
+        Integer const scalar_count = i_shape.GetLinearSize();
+        Integer wrapped_count = scalar_count;
+        for (Integer dim = i_shape.GetRank(); dim >= 0 && wrapped_count == scalar_count; dim--)
         {
-            auto const reals = i_source.GetAs<Real>();
-            SharedArray<Integer> integers(reals.size());
-            for(size_t i = 0; i < reals.size(); i++)
-                integers[i] = NumericCast<Integer>(reals[i]);
-            return TensorValue(std::move(integers), i_source.GetShape());
+            Integer const stride = i_shape.GetStride(dim);
+            if(scalar_count > stride && stride > 0)
+            {
+                bool equals = true;
+                for (Integer pos = stride; pos < scalar_count && equals; pos++)
+                    equals = element_at(pos) == element_at(pos % stride);
+
+                if(equals)
+                    wrapped_count = stride;
+            }
         }
-        else
-            Panic("TensorValue Cast - unrecognized scalar type: ", i_dest_type);
+
+        for(Integer index = 0; index < wrapped_count; index++)
+            i_dest << element_at(index);
     }
 
     Hash & operator << (Hash & i_dest, const TensorValue & i_source)
     {
         i_dest << i_source.m_type;
+        if(i_source.IsView())
+        {
+            std::visit([&](const auto & i_scalars) {
+                using ELEMENT = std::remove_const_t<typename std::decay_t<decltype(i_scalars)>::value_type>;
+                HashView<ELEMENT>(i_dest, i_source.GetShape(), i_source.m_view->m_strides,
+                    i_source.m_view->m_offset, i_scalars);
+            }, i_source.m_scalars);
+            return i_dest;
+        }
+
         std::visit([&i_dest](const auto & i_scalars){ i_dest << i_scalars; }, i_source.m_scalars);
         return i_dest;
     }
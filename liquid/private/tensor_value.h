@@ -7,6 +7,7 @@
 #pragma once
 
 #include <variant>
+#include <memory>
 #include "private_common.h"
 #include "liquid/span.h"
 #include "tensor_initializer.h"
@@ -15,9 +16,30 @@
 
 namespace liquid
 {
+    /* Numeric types are ordered as in the usual arithmetic conversions of C++, so the numeric
+        promotion of two types is the one with the higher rank. Non-numeric types have -1. */
+    constexpr int GetNumericRank(ScalarType i_scalar_type)
+    {
+        switch(i_scalar_type)
+        {
+            case ScalarType::Integer8: return 0;
+            case ScalarType::Integer32: return 1;
+            case ScalarType::Integer: return 2;
+            case ScalarType::Real32: return 3;
+            case ScalarType::Real: return 4;
+            default: return -1;
+        }
+    }
+
     constexpr bool IsNumeric(ScalarType i_scalar_type)
     {
-        return i_scalar_type == ScalarType::Integer || i_scalar_type == ScalarType::Real;
+        return GetNumericRank(i_scalar_type) >= 0;
+    }
+
+    constexpr bool IsIntegral(ScalarType i_scalar_type)
+    {
+        return i_scalar_type == ScalarType::Integer8 || i_scalar_type == ScalarType::Integer32 ||
+            i_scalar_type == ScalarType::Integer;
     }
 
     // tensor value are immutable
@@ -39,10 +61,22 @@ namespace liquid
 
         TensorValue(SharedArray<const Bool> && i_bools, const FixedShape & i_shape);
 
+        TensorValue(SharedArray<const Real32> && i_reals, const FixedShape & i_shape);
+
+        TensorValue(SharedArray<const Integer32> && i_integers, const FixedShape & i_shape);
+
+        TensorValue(SharedArray<const Integer8> && i_integers, const FixedShape & i_shape);
+
         TensorValue(const TensorInitializer & i_scalars);
 
         TensorValue(const TensorInitializer & i_scalars, const FixedShape & i_shape);
 
+        /* Creates a view sharing the storage of i_source. Every dimension of i_shape has
+            a stride in i_strides, and i_offset is the position of the first element. Strides
+            and offset address the storage of i_source, that is constant wrapped as usual. */
+        TensorValue(const TensorValue & i_source, const FixedShape & i_shape,
+            Span<const Integer> i_strides, Integer i_offset);
+
         const TensorType & GetType() const { return m_type; }
 
         const FixedShape & GetShape() const { return m_type.GetFixedShape(); }
@@ -54,8 +88,18 @@ namespace liquid
             return std::holds_alternative<SharedArray<const SCALAR_TYPE>>(m_scalars);
         }
 
+        // the constant wrapped storage in row-major order, for a view it's a copy computed once
         template <typename SCALAR_TYPE>
             SharedArray<const SCALAR_TYPE> const & GetAs() const
+        {
+            if(IsView())
+                return GetDense().GetAs<SCALAR_TYPE>();
+            return GetStorageAs<SCALAR_TYPE>();
+        }
+
+        // the storage, that is addressed by GetStorageStrides and GetStorageOffset
+        template <typename SCALAR_TYPE>
+            SharedArray<const SCALAR_TYPE> const & GetStorageAs() const
         {
             if(!Is<SCALAR_TYPE>())
                 Panic("TensorValue - Mismatching scalar type: requested ", liquid::GetScalarType<SCALAR_TYPE>(),
@@ -63,6 +107,17 @@ namespace liquid
             return std::get<SharedArray<const SCALAR_TYPE>>(m_scalars);
         }
 
+        bool IsView() const { return m_view != nullptr; }
+
+        // the stride of every dimension in the storage, row-major strides if this is not a view
+        Span<const Integer> GetStorageStrides() const;
+
+        Integer GetStorageOffset() const;
+
+        /* Index in the storage of the element at the given indices, before the wrapping. Like
+            FixedShape::GetPhysicalLinearIndex, broadcasting is applied to the indices. */
+        Integer GetPhysicalLinearIndex(Span<const Integer> i_indices) const;
+
         template <typename SCALAR_TYPE>
             SharedArray<const SCALAR_TYPE> const & TryGetAs() const
         {
@@ -85,6 +140,9 @@ namespace liquid
 
         void SetFromInitializer(const TensorInitializer & i_scalars);
 
+        template <typename SCALAR_TYPE>
+            void SetWrappedScalars(SharedArray<const SCALAR_TYPE> && i_scalars);
+
         template <typename SCALAR_TYPE>
             static size_t ConstantWrapping(const FixedShape & i_shape, Span<const SCALAR_TYPE> i_scalars);
 
@@ -94,13 +152,20 @@ namespace liquid
 
         void StripSuperfluousUpperDims(const FixedShape & i_dest_shape);
 
+        const TensorValue & GetDense() const;
+
     private:
+        struct View;
         TensorType m_type;
         std::variant<
             SharedArray<const Real>,
             SharedArray<const Integer>,
-            SharedArray<const Bool>
+            SharedArray<const Bool>,
+            SharedArray<const Real32>,
+            SharedArray<const Integer32>,
+            SharedArray<const Integer8>
         > m_scalars;
+        std::shared_ptr<View> m_view;
     };
 
     // floating point template arguments are not permitted
@@ -6,6 +6,8 @@
 
 #include "private_common.h"
 #include "indices.h"
+#include "expression.h"
+#include "factorize_polynomial.h"
 #include <iostream>
 
 namespace liquid
@@ -23,6 +25,21 @@ namespace liquid
 
         Expects(topic, "real a + a == 2*a");
 
+        // common powers are factored out, leading to the Horner form
+        Expects(topic, "real a * real b + a * real c == a * (b + c)");
+        Expects(topic, "real a^2 + a^3 == a^2 * (1 + a)");
+        Expects(topic, "2 + 3 * real a + 4 * a^2 + 5 * a^3 == 2 + a * (3 + a * (4 + a * 5))");
+
+        {
+            // a failed merge does not promote the exponent
+            Tensor const a("real a"), b("real b"), c("real c"), d("real d");
+            auto const factorized = Factorize(std::vector<Tensor>{ Pow(a, 2) * b, Pow(a, -1.5) * c, Pow(a, 2) * d });
+            LIQUID_EXPECTS(factorized.has_value());
+            const Tensor & factor = factorized->GetExpression()->GetOperand(1).GetExpression()->GetOperand(0);
+            LIQUID_EXPECTS(AreIdentical(factor.GetExpression()->GetOperand(0), a));
+            LIQUID_EXPECTS(factor.GetExpression()->GetOperand(1).GetScalarType() == ScalarType::Integer);
+        }
+
         Expects(topic, "2 + 3 == 5");
         Expects(topic, "2 + 3 + 2 == 7");
         Expects(topic, "add(5 6 5) == 16");
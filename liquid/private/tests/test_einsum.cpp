@@ -0,0 +1,83 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "expression.h"
+#include "book.h"
+#include <iostream>
+
+namespace liquid
+{
+    void TestEinsum()
+    {
+        std::cout << "Test Einsum...";
+
+        Tensor const a({{1., 2., 3.}, {4., 5., 6.}});
+        Tensor const b({{7., 8.}, {9., 10.}, {11., 12.}});
+        Tensor const v({1., 2., 3.});
+        Tensor const square({{1, 2}, {3, 4}});
+
+        {
+            LIQUID_EXPECTS(( Einsum("ij,jk->ik", {a, b}) == MatMul(a, b) ));
+            LIQUID_EXPECTS(( Einsum("ij,jk", {a, b}) == MatMul(a, b) ));
+            LIQUID_EXPECTS(( Einsum("ij->ji", {a}) == Tensor({{1, 4}, {2, 5}, {3, 6}}) ));
+            LIQUID_EXPECTS(( Einsum("ii->", {square}) == 5 ));
+            LIQUID_EXPECTS(( Einsum("ii->i", {square}) == Tensor({1, 4}) ));
+            LIQUID_EXPECTS(( Einsum("ij->", {a}) == 21 ));
+            LIQUID_EXPECTS(( Einsum("ij->i", {a}) == Tensor({6, 15}) ));
+            LIQUID_EXPECTS(( Einsum("i,i", {v, v}) == 14 ));
+            LIQUID_EXPECTS(( Einsum("i,j->ij", {Tensor({1, 2}), v}) == Tensor({{1, 2, 3}, {2, 4, 6}}) ));
+            LIQUID_EXPECTS(( Einsum("ij,ij->i", {a, a}) == Tensor({14, 77}) ));
+
+            // three operands, and a batch label
+            LIQUID_EXPECTS(( Einsum("ij,jk,k->i", {a, b, Tensor({1., -1.})}) == Tensor({-6, -15}) ));
+            LIQUID_EXPECTS(( Einsum("bij,bjk->bik", {Stack({a, a}), Stack({b, b * 2})}) ==
+                Stack({MatMul(a, b), MatMul(a, b * 2)}) ));
+
+            // wrapped storage and integer operands
+            LIQUID_EXPECTS(( Einsum("ij,jk->ik", {Tensor(1, {2, 3}), Tensor(2, {3, 2})}) == Tensor(6, {2, 2}) ));
+            LIQUID_EXPECTS(Einsum("ii", {square}).GetScalarType() == ScalarType::Integer);
+
+            // empty operands
+            Tensor const empty = Tensor(1., {2, 0});
+            LIQUID_EXPECTS(( Einsum("ij,jk->ik", {empty, Tensor(2., {0, 3})}) == Tensor(0., {2, 3}) ));
+            LIQUID_EXPECTS(( Einsum("ij,jk->ik", {Tensor(1., {0, 3}), b}).GetExpression()->GetType() ==
+                TensorType(ScalarType::Real, FixedShape{0, 2}) ));
+            LIQUID_EXPECTS(( Einsum("ij->i", {empty}) == Tensor({0., 0.}) ));
+            LIQUID_EXPECTS(( Einsum("ij->ji", {empty}).GetExpression()->GetType() ==
+                TensorType(ScalarType::Real, FixedShape{0, 2}) ));
+            LIQUID_EXPECTS(( Einsum("ij,jk->k", {Einsum("ij->ji", {empty}), Tensor(1., {2, 3})}) == Tensor(0., {3}) ));
+
+            LIQUID_EXPECTS(AreIdentical(Einsum(" ij , jk ", {a, Tensor("real[3, 4] x")}),
+                Einsum("ij,jk->ik", {a, Tensor("real[3, 4] x")})));
+
+            LIQUID_EXPECTS_PANIC(Einsum("ij,jk->ik", {a, a}), "einsum: the label 'j' has the dimensions 3 and 2");
+            LIQUID_EXPECTS_PANIC(Einsum("ij->k", {a}), "einsum: the label 'k' of the result is not used");
+            LIQUID_EXPECTS_PANIC(Einsum("ij,jk->ik", {a}), "einsum: the specification has 2 terms, but 1 operands");
+            LIQUID_EXPECTS_PANIC(Einsum("i+j", {a}), "einsum: unexpected '+'");
+        }
+
+        {
+            // y z is the cheapest pair, then x is contracted with the result, then the result is copied
+            Tensor const x("real[2, 100] x"), y("real[100, 100] y"), z("real[100] z");
+            LIQUID_EXPECTS(GetGraphStatistics({ Einsum("ij,jk,k->i", {x, y, z}) }).m_flops == 2 * 100 * 100 + 2 * 2 * 100 + 2);
+        }
+
+        {
+            const Operator & einsum = Book::Get().GetOperator("einsum");
+            Tensor const x("real[2, 3] x"), u("real[3] u");
+            Tensor const identity({{1., 0.}, {0., 1.}});
+
+            LIQUID_EXPECTS(( einsum.GetGradientOfOperand(Einsum("ij,jk->ik", {x, b}), identity, 0) ==
+                Tensor({{7, 9, 11}, {8, 10, 12}}) ));
+            LIQUID_EXPECTS(( einsum.GetGradientOfOperand(Einsum("ij,j->i", {a, u}), Tensor({1., 2.}), 1) ==
+                Tensor({9, 12, 15}) ));
+            LIQUID_EXPECTS_PANIC(einsum.GetGradientOfOperand(Einsum("ij->", {x}), 1., 0),
+                "einsum: the gradient of the operand 'ij' is not supported");
+        }
+
+        std::cout << "done" << std::endl;
+    }
+}
@@ -0,0 +1,48 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "expression.h"
+#include <iostream>
+
+namespace liquid
+{
+    void TestGraphStatistics()
+    {
+        std::cout << "Test GraphStatistics...";
+
+        Tensor const x("real[4] x");
+
+        GraphStatistics const leaf = GetGraphStatistics({ x });
+        LIQUID_EXPECTS(leaf.m_unique_nodes == 1);
+        LIQUID_EXPECTS(leaf.m_depth == 1);
+        LIQUID_EXPECTS(leaf.m_flops == 0);
+        LIQUID_EXPECTS(leaf.m_peak_intermediate_bytes == 0);
+
+        // sin(x) is shared by exp and cos
+        Tensor const shared = Sin(x);
+        Tensor const product = Exp(shared) * Cos(shared);
+
+        GraphStatistics const statistics = GetGraphStatistics({ product });
+        LIQUID_EXPECTS(statistics.m_unique_nodes == 5);
+        LIQUID_EXPECTS(statistics.m_depth == 4);
+
+        // sin, exp and cos have 8 flops per element, mul with 2 operands has 1
+        LIQUID_EXPECTS(statistics.m_flops == 3 * 4 * 8 + 4);
+        LIQUID_EXPECTS(product.GetExpression()->GetComputationalCostExtimate() == statistics.m_flops);
+        LIQUID_EXPECTS(product.GetExpression()->GetComputationalCostExtimate() == statistics.m_flops); // cached
+
+        // sin(x) is released after cos is computed: exp, cos and the product are the peak
+        LIQUID_EXPECTS(statistics.m_peak_intermediate_bytes ==
+            3 * 4 * static_cast<int64_t>(sizeof(Real)));
+
+        // nodes reachable from many roots are counted once
+        GraphStatistics const many_roots = GetGraphStatistics({ product, shared, x });
+        LIQUID_EXPECTS(many_roots.m_unique_nodes == 5);
+        LIQUID_EXPECTS(many_roots.m_flops == statistics.m_flops);
+
+        std::cout << "done" << std::endl;
+    }
+}
@@ -5,6 +5,7 @@
 //          http://www.boost.org/LICENSE_1_0.txt)
 
 #include "private_common.h"
+#include "expression.h"
 #include "indices.h"
 #include <numeric>
 #include <iostream>
@@ -87,6 +88,39 @@ namespace liquid
             LIQUID_EXPECTS_DOC(topic, Lerp( 0.5, 0, {8, 2} ) == Tensor({4, 1}));
         }
 
+        {
+            Tensor const x("real x"), y("real y");
+            Tensor const c = x > 0, d = y > 0;
+
+            // branches that can't be taken are dropped
+            LIQUID_EXPECTS(AreIdentical(If(c, 1, false, 2, 3), If(c, 1, 3)));
+            LIQUID_EXPECTS(AreIdentical(If(c, 1, true, x, 3), If(c, 1, x)));
+            LIQUID_EXPECTS(AreIdentical(If(true, x, c, 2, 3), x));
+            LIQUID_EXPECTS(AreIdentical(If(c, x, d, y, c, 2, 3), If(c, x, d, y, 3)));
+
+            // branches selecting the same value are merged
+            LIQUID_EXPECTS(AreIdentical(If(c, x, d, x, 3), If(c || d, x, 3)));
+            LIQUID_EXPECTS(AreIdentical(If(c, y, d, x, x), If(c, y, x)));
+            LIQUID_EXPECTS(AreIdentical(If(c, x, x), x));
+
+            // a partially constant if is evaluated once the other branches are dropped
+            LIQUID_EXPECTS(IsConstant(If(Tensor({true, false}), 1, false, x, 2)));
+            LIQUID_EXPECTS(If(Tensor({true, false}), 1, false, x, 2) == Tensor({1, 2}));
+
+            // dropped conditions still broadcast the result
+            Tensor const v("bool[3] v"), w("real[3] w");
+            LIQUID_EXPECTS(If(false, 1., v, w, 2.).GetExpression()->GetType() == TensorType(ScalarType::Real, FixedShape{3}));
+            LIQUID_EXPECTS(If(true, 1., v, w, 2.).GetExpression()->GetType() == TensorType(ScalarType::Real, FixedShape{3}));
+            LIQUID_EXPECTS(If(true, 1., v, w, 2.) == Tensor({1., 1., 1.}));
+
+            /* Substitute visits only the values that may be selected, so the first
+                value (that would fail to broadcast) is never rebuilt */
+            Tensor const lazy = If(c, y + Tensor({1., 2., 3.}), d, y, 0.);
+            Tensor const bound = Substitute(lazy, { Rule{x, -1.}, Rule{y, Tensor({1., 2.})} });
+            LIQUID_EXPECTS(IsConstant(bound));
+            LIQUID_EXPECTS(bound == Tensor({1., 2.}));
+        }
+
         std::cout << "done" << std::endl;
     }
 }
@@ -0,0 +1,82 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "expression.h"
+#include "incremental_evaluator.h"
+#include <iostream>
+
+namespace liquid
+{
+    void TestIncrementalEvaluator()
+    {
+        std::cout << "Test IncrementalEvaluator...";
+
+        Tensor const a("real a"), b("real b"), c("real[3] c");
+
+        // sin(a) * b depends on a and b, exp(c) only on c. The root is add(mul, exp, 1)
+        Tensor const first = Sin(a) * b;
+        Tensor const sum = first + Exp(c) + 1;
+
+        IncrementalEvaluator evaluator({ sum, first });
+        evaluator.SetValue(a, 2.);
+        evaluator.SetValue(b, 3.);
+        evaluator.SetValue(c, TensorValue(TensorInitializer{ 1., 2., 3. }));
+
+        auto const expected = [&](Real i_a, Real i_b, const Tensor & i_c) {
+            return GetConstantValue(Substitute(sum, { Rule{a, i_a}, Rule{b, i_b}, Rule{c, i_c} }));
+        };
+
+        // the first update evaluates sin, mul, exp and add
+        LIQUID_EXPECTS(evaluator.Update() == 4);
+        LIQUID_EXPECTS(evaluator.GetValue(0) == expected(2., 3., Tensor({ 1., 2., 3. })));
+        LIQUID_EXPECTS(evaluator.GetValue(1) == GetConstantValue(Sin(2.) * 3.));
+
+        // nothing changed
+        LIQUID_EXPECTS(evaluator.Update() == 0);
+
+        // only b changed: mul and the root add
+        evaluator.SetValue(b, 4.);
+        LIQUID_EXPECTS(evaluator.Update() == 2);
+        LIQUID_EXPECTS(evaluator.GetValue(0) == expected(2., 4., Tensor({ 1., 2., 3. })));
+
+        // only c changed: exp and the root add
+        evaluator.SetValue(Tensor("real[3] c"), TensorValue(TensorInitializer{ 0., 0., 0. }));
+        LIQUID_EXPECTS(evaluator.Update() == 2);
+        LIQUID_EXPECTS(evaluator.GetValue(0) == expected(2., 4., Tensor({ 0., 0., 0. })));
+
+        LIQUID_EXPECTS_PANIC(evaluator.SetValue(a, 1), "can't have a value of type");
+        LIQUID_EXPECTS_PANIC(IncrementalEvaluator({ a + b }).Update(), "has no value");
+
+        // the nodes not evaluated by an update that has panicked are evaluated by the next one
+        {
+            IncrementalEvaluator partial({ sum, first });
+            partial.SetValue(c, TensorValue(TensorInitializer{ 1., 2., 3. }));
+            LIQUID_EXPECTS_PANIC(partial.Update(), "has no value");
+            LIQUID_EXPECTS_PANIC(partial.GetValue(0), "the value is outdated");
+
+            partial.SetValue(a, 2.);
+            partial.SetValue(b, 3.);
+            LIQUID_EXPECTS(partial.Update() == 4);
+            LIQUID_EXPECTS(partial.GetValue(0) == expected(2., 3., Tensor({ 1., 2., 3. })));
+            LIQUID_EXPECTS(partial.GetValue(1) == GetConstantValue(Sin(2.) * 3.));
+
+            Tensor const i("int[1] i"), gathered = Gather(c, i) * a;
+            IncrementalEvaluator indexed({ gathered });
+            indexed.SetValue(c, TensorValue(TensorInitializer{ 1., 2., 3. }));
+            indexed.SetValue(i, TensorValue(TensorInitializer{ 1 }));
+            indexed.SetValue(a, 2.);
+            LIQUID_EXPECTS(indexed.Update() == 2);
+            indexed.SetValue(i, TensorValue(TensorInitializer{ 5 }));
+            LIQUID_EXPECTS_PANIC(indexed.Update(), "out of range");
+            LIQUID_EXPECTS_PANIC(indexed.GetValue(0), "the value is outdated");
+            indexed.SetValue(i, TensorValue(TensorInitializer{ 2 }));
+            LIQUID_EXPECTS(indexed.Update() == 2);
+            LIQUID_EXPECTS(indexed.GetValue(0) == GetConstantValue(Tensor({ 6. })));
+        }
+
+        std::cout << "done" << std::endl;
+    }
+}
@@ -0,0 +1,86 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "expression.h"
+#include "tensor_value.h"
+#include "book.h"
+#include <iostream>
+
+namespace liquid
+{
+    void TestIndexing()
+    {
+        std::cout << "Test Indexing...";
+
+        Tensor const a({{1., 2., 3.}, {4., 5., 6.}});
+        Tensor const v({10, 11, 12, 13, 14, 15});
+
+        {
+            LIQUID_EXPECTS(( Slice(v, 0, 1, 4) == Tensor({11, 12, 13}) ));
+            LIQUID_EXPECTS(( Slice(v, 0, 0, 6, 2) == Tensor({10, 12, 14}) ));
+            LIQUID_EXPECTS(( Slice(v, 0, -2, 100) == Tensor({14, 15}) ));
+            LIQUID_EXPECTS(( Slice(v, 0, 4, 0, -2) == Tensor({14, 12}) ));
+            LIQUID_EXPECTS(( Slice(v, 0, -1, -100, -1) == Tensor({15, 14, 13, 12, 11, 10}) ));
+            LIQUID_EXPECTS(( Shape(Slice(v, 0, 3, 3)) == Tensor({0}) ));
+            LIQUID_EXPECTS(( Slice(a, 1, 1, 3) == Tensor({{2, 3}, {5, 6}}) ));
+            LIQUID_EXPECTS(( Slice(Slice(a, 1, 2, -4, -1), 0, 1, 2) == Tensor({{6, 5, 4}}) ));
+            LIQUID_EXPECTS(GetConstantValue(Tensor(Slice(v, 0, 1, 4))).IsView());
+
+            LIQUID_EXPECTS_PANIC(Slice(a, 2, 0, 1), "slice: the axis 2 is out of range for the rank 2");
+            LIQUID_EXPECTS_PANIC(Slice(a, 0, 0, 1, 0), "slice: the step can't be zero");
+        }
+
+        {
+            LIQUID_EXPECTS(( Gather(v, Tensor({5, 0, 0})) == Tensor({15, 10, 10}) ));
+            LIQUID_EXPECTS(( Gather(a, Tensor({1, 0}), 0) == Tensor({{4, 5, 6}, {1, 2, 3}}) ));
+            LIQUID_EXPECTS(( Gather(a, Tensor({2, 0}), 1) == Tensor({{3, 1}, {6, 4}}) ));
+
+            // embedding lookup: the indices add their own dimensions
+            LIQUID_EXPECTS(( Gather(a, Tensor({{0, 1}, {1, 1}})) ==
+                Tensor({{{1, 2, 3}, {4, 5, 6}}, {{4, 5, 6}, {4, 5, 6}}}) ));
+
+            // contiguous indices produce a view
+            Tensor const run = Gather(v, Tensor({2, 3, 4}));
+            LIQUID_EXPECTS(( run == Tensor({12, 13, 14}) ));
+            LIQUID_EXPECTS(GetConstantValue(run).IsView());
+            LIQUID_EXPECTS(( Gather(Transpose(a), Tensor({1, 2})) == Tensor({{2, 5}, {3, 6}}) ));
+            LIQUID_EXPECTS(( Gather(Tensor(7, {4, 3}), Tensor({3, 1}), 0) == Tensor(7, {2, 3}) ));
+
+            LIQUID_EXPECTS_PANIC(Gather(v, Tensor({1, 6})), "gather: the index 6 is out of range for the dimension 6");
+            LIQUID_EXPECTS_PANIC(Gather(v, Tensor({3, -1, 4})), "gather: the index -1 is out of range for the dimension 6");
+            LIQUID_EXPECTS_PANIC(Gather(v, Tensor({0}), 1), "gather: the axis 1 is out of range for the rank 1");
+        }
+
+        {
+            LIQUID_EXPECTS(( ScatterAdd(Tensor(0, {4}), Tensor({1, 3, 1}), Tensor({1, 2, 3})) == Tensor({0, 4, 0, 2}) ));
+            LIQUID_EXPECTS(( ScatterAdd(Tensor(0., {2, 3}), Tensor({1, 2}), Tensor({{1., 2.}, {3., 4.}}), 1) ==
+                Tensor({{0, 1, 2}, {0, 3, 4}}) ));
+            LIQUID_EXPECTS(( ScatterAdd(a, Tensor({0, 1}), Tensor({{1., 1., 1.}, {2., 2., 2.}})) ==
+                Tensor({{2, 3, 4}, {6, 7, 8}}) ));
+
+            LIQUID_EXPECTS_PANIC(ScatterAdd(a, Tensor({0, 1}), Tensor({1., 2.})),
+                "scatter_add: the updates have the shape [2], the expected shape is [2, 3]");
+            LIQUID_EXPECTS_PANIC(ScatterAdd(a, Tensor({2}), Tensor({{1., 2., 3.}})),
+                "scatter_add: the index 2 is out of range for the dimension 2");
+        }
+
+        {
+            Tensor const x("real[2, 3] x"), w("real[3] w"), u("real[2] u");
+            Tensor const gradient({{1., 2.}, {3., 4.}});
+
+            LIQUID_EXPECTS(( Book::Get().GetOperator("slice").GetGradientOfOperand(Slice(x, 1, 0, 3, 2), gradient, 0) ==
+                Tensor({{1, 0, 2}, {3, 0, 4}}) ));
+            LIQUID_EXPECTS(( Book::Get().GetOperator("gather").GetGradientOfOperand(Gather(x, Tensor({2, 2}), 1), gradient, 0) ==
+                Tensor({{0, 0, 3}, {0, 0, 7}}) ));
+            LIQUID_EXPECTS(( Book::Get().GetOperator("scatter_add").GetGradientOfOperand(
+                ScatterAdd(w, Tensor({1, 0}), u), Tensor({10., 20., 30.}), 2) == Tensor({20, 10}) ));
+            LIQUID_EXPECTS_PANIC(Book::Get().GetOperator("gather").GetGradientOfOperand(Gather(x, Tensor({0})), a, 1),
+                "gather: the indices are not differentiable");
+        }
+
+        std::cout << "done" << std::endl;
+    }
+}
@@ -0,0 +1,53 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "instrumentation.h"
+#include "expression.h"
+#include "book.h"
+#include <sstream>
+#include <iostream>
+
+namespace liquid
+{
+    void TestInstrumentation()
+    {
+        std::cout << "Test Instrumentation...";
+
+        ResetOperatorStatistics();
+
+        // constant propagation
+        Tensor const value = Sin(Tensor({ 1., 2., 3. }));
+        LIQUID_EXPECTS(IsConstant(value));
+
+        // canonicalization: add(x, 0) -> x
+        Tensor const x("real x");
+        LIQUID_EXPECTS(Always(x + 0 == x));
+
+        std::ostringstream dump;
+        DumpOperatorStatistics(dump);
+
+        #if LIQUID_INSTRUMENTATION
+            const OperatorStatistics & sin = Book::Get().GetOperator("sin").GetStatistics();
+            LIQUID_EXPECTS(sin.m_invocations.Get() == 1);
+            LIQUID_EXPECTS(sin.m_constant_propagations.Get() == 1);
+            LIQUID_EXPECTS(sin.m_kernel_bytes.Get() == 3 * sizeof(Real));
+
+            const OperatorStatistics & add = Book::Get().GetOperator("add").GetStatistics();
+            LIQUID_EXPECTS(add.m_invocations.Get() >= 1);
+
+            LIQUID_EXPECTS(dump.str().find("sin: invocations 1, constant propagations 1") != std::string::npos);
+            LIQUID_EXPECTS(dump.str().find("cos:") == std::string::npos);
+
+            ResetOperatorStatistics();
+            LIQUID_EXPECTS(sin.m_invocations.Get() == 0);
+            LIQUID_EXPECTS(sin.m_kernel_bytes.Get() == 0);
+        #else
+            LIQUID_EXPECTS(dump.str().empty());
+        #endif
+
+        std::cout << "done" << std::endl;
+    }
+}
@@ -0,0 +1,102 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "expression.h"
+#include "tensor_value.h"
+#include "book.h"
+#include <iostream>
+
+namespace liquid
+{
+    namespace
+    {
+        Tensor MakeIntegerMatrix(Integer i_rows, Integer i_columns, Integer i_seed)
+        {
+            SharedArray<Integer> elements(NumericCast<size_t>(i_rows * i_columns));
+            for(size_t index = 0; index < elements.size(); index++)
+                elements[index] = (NumericCast<Integer>(index) * i_seed) % 7 - 3;
+            return MakeConstant(TensorValue(std::move(elements), FixedShape({ i_rows, i_columns })));
+        }
+
+        // the reference triple loop
+        Tensor NaiveMatMul(const Tensor & i_first, const Tensor & i_second)
+        {
+            Span<const Integer> const first = GetConstantStorage<Integer>(i_first);
+            Span<const Integer> const second = GetConstantStorage<Integer>(i_second);
+            Integer const rows = GetConstantValue(i_first).GetShape().GetDimension(0);
+            Integer const inner = GetConstantValue(i_first).GetShape().GetDimension(1);
+            Integer const columns = GetConstantValue(i_second).GetShape().GetDimension(1);
+
+            SharedArray<Integer> result(NumericCast<size_t>(rows * columns));
+            for(Integer row = 0; row < rows; row++)
+                for(Integer column = 0; column < columns; column++)
+                    for(Integer index = 0; index < inner; index++)
+                        result[NumericCast<size_t>(row * columns + column)] +=
+                            first[NumericCast<size_t>(row * inner + index)] *
+                            second[NumericCast<size_t>(index * columns + column)];
+            return MakeConstant(TensorValue(std::move(result), FixedShape({ rows, columns })));
+        }
+    }
+
+    void TestMatMul()
+    {
+        std::cout << "Test MatMul...";
+
+        Tensor const a({{1., 2., 3.}, {4., 5., 6.}});
+        Tensor const b({{7., 8.}, {9., 10.}, {11., 12.}});
+        Tensor const v({1., 2., 3.});
+
+        {
+            LIQUID_EXPECTS(( MatMul(a, b) == Tensor({{58, 64}, {139, 154}}) ));
+            LIQUID_EXPECTS(( MatMul(v, b) == Tensor({58, 64}) ));
+            LIQUID_EXPECTS(( MatMul(a, v) == Tensor({14, 32}) ));
+            LIQUID_EXPECTS(( MatMul(v, v) == 14 ));
+            LIQUID_EXPECTS(( MatMul(Tensor({{1, 2}, {3, 4}}), Tensor({{1, 0}, {0, 1}})) == Tensor({{1, 2}, {3, 4}}) ));
+            LIQUID_EXPECTS(MatMul(Tensor({{1, 2}}), Tensor({{3}, {4}})).GetScalarType() == ScalarType::Integer);
+
+            // wrapped storage
+            LIQUID_EXPECTS(( MatMul(Tensor(2., {2, 3}), b) == Tensor({{54, 60}, {54, 60}}) ));
+
+            LIQUID_EXPECTS_PANIC(MatMul(a, a), "matmul: the inner dimensions do not match");
+            LIQUID_EXPECTS_PANIC(MatMul(a, 1), "matmul: the operands must be vectors or matrices");
+
+            Tensor const x("real[4, 2] x");
+            LIQUID_EXPECTS(( Shape(MatMul(x, a)) == Tensor({4, 3}) ));
+            LIQUID_EXPECTS(GetGraphStatistics({ MatMul(x, a) }).m_flops == 2 * 4 * 3 * 2);
+        }
+
+        {
+            // blocked kernel with row, column and inner remainders
+            Tensor const first = MakeIntegerMatrix(37, 300, 5);
+            Tensor const second = MakeIntegerMatrix(300, 263, 3);
+            LIQUID_EXPECTS(AreIdentical(MatMul(first, second), NaiveMatMul(first, second)));
+        }
+
+        {
+            const Operator & matmul = Book::Get().GetOperator("matmul");
+            Tensor const x("real[2, 3] x"), y("real[3, 2] y"), u("real[3] u");
+            Tensor const identity({{1., 0.}, {0., 1.}});
+
+            // matrix by matrix
+            Tensor const gradient_of_x = matmul.GetGradientOfOperand(MatMul(x, b), identity, 0);
+            LIQUID_EXPECTS(( gradient_of_x == Tensor({{7, 9, 11}, {8, 10, 12}}) ));
+            LIQUID_EXPECTS(( matmul.GetGradientOfOperand(MatMul(a, y), identity, 1) == Tensor({{1, 4}, {2, 5}, {3, 6}}) ));
+
+            // gradients of transposed products
+            Tensor const transposed = matmul.GetGradientOfOperand(MatMul(x, y), identity, 0);
+            LIQUID_EXPECTS(( Substitute(transposed, y, b) == Tensor({{7, 9, 11}, {8, 10, 12}}) ));
+            LIQUID_EXPECTS(( matmul.GetGradientOfOperand(transposed, a, 1) == Tensor({{1, 4}, {2, 5}, {3, 6}}) ));
+
+            // vectors
+            LIQUID_EXPECTS(( matmul.GetGradientOfOperand(MatMul(u, b), Tensor({1., 2.}), 0) == Tensor({23, 29, 35}) ));
+            LIQUID_EXPECTS(( matmul.GetGradientOfOperand(MatMul(v, y), Tensor({1., 2.}), 1) ==
+                Tensor({{1, 2}, {2, 4}, {3, 6}}) ));
+            LIQUID_EXPECTS(( matmul.GetGradientOfOperand(MatMul(u, v), 2., 0) == Tensor({2, 4, 6}) ));
+        }
+
+        std::cout << "done" << std::endl;
+    }
+}
@@ -6,6 +6,8 @@
 
 #include "private_common.h"
 #include "miu6/lexer.h"
+#include "miu6/parser.h"
+#include "expression.h"
 #include "indices.h"
 #include <numeric>
 #include <iostream>
@@ -59,6 +61,25 @@ namespace liquid
         Expects(u8"[[ cos real[] θ     -sin θ ] "
                 u8" [ sin θ            cos θ  ]] is real[2 2]");
 
+        {
+            // independent top-level expressions, each with its own scope
+            std::string source;
+            for(int i = 0; i < 100; i++)
+                source += "real[2] x + " + std::to_string(i) + " * [1 2],\n";
+
+            auto const sequential = miu6::ParseExpressions(source, Scope::Root(), false);
+            auto const parallel = miu6::ParseExpressions(source, Scope::Root(), true);
+            LIQUID_EXPECTS(sequential.size() == 100 && parallel.size() == 100);
+            for(size_t i = 0; i < parallel.size(); i++)
+            {
+                LIQUID_EXPECTS(parallel[i].GetExpression()->GetType() == TensorType(ScalarType::Real, FixedShape{2}));
+                LIQUID_EXPECTS(AreIdentical(parallel[i], sequential[i]));
+            }
+
+            LIQUID_EXPECTS(miu6::ParseExpressions("[1, 2], [3, 4] * (5)").size() == 2);
+            LIQUID_EXPECTS_PANIC(miu6::ParseExpressions("1,\n2,\n3 +,\n4"), "(3): 3 +,");
+        }
+
         // to do: implement softmax
         // https://timvieira.github.io/blog/post/2014/02/11/exp-normalize-trick/
 
@@ -6,6 +6,7 @@
 
 #include "private_common.h"
 #include "indices.h"
+#include "expression.h"
 #include <iostream>
 
 namespace liquid
@@ -24,8 +25,10 @@ namespace liquid
         Expects(topic, "real a / real b == a * b^-1");
         Expects(topic, "(real a ^ real b) * (a ^ real c) == a^(b + c)");
         Expects(topic, "(real a ^ real b) ^ real c == a^(b * c)");
-        // Expects(topic, "real a / a == 1");
-        // Expects(topic, "real a + a == 2 * a");
+        Expects(topic, "real a / a == 1");
+        Expects(topic, "real a + a == 2 * a");
+        Expects(topic, "real a * real b * a * b^2 == a^2 * b^3");
+        Expects(topic, "real a * a^real b * real c * a^-1 == a^b * c");
 
         Expects(topic, "2 * 3 == 6");
         Expects(topic, "2 * 3 * 2 == 12");
@@ -33,6 +36,16 @@ namespace liquid
         Expects(topic, "mul([5 6 5]) == [5 6 5]");
         Expects(topic, "add([5 6 5], 1) == [6 7 6]");
 
+        {
+            // integer bases are not merged into pow, that would promote them to real
+            Tensor const a("int a");
+            LIQUID_EXPECTS((a * a).GetScalarType() == ScalarType::Integer);
+            Tensor const product = a * 3 * a;
+            LIQUID_EXPECTS(product.GetScalarType() == ScalarType::Integer);
+            for(const Tensor & factor : product.GetExpression()->GetOperands())
+                LIQUID_EXPECTS(factor.GetScalarType() == ScalarType::Integer);
+        }
+
         std::cout << "done" << std::endl;
     }
 }
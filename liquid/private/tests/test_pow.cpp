@@ -6,8 +6,12 @@
 
 #include "private_common.h"
 #include "indices.h"
+#include "expression.h"
+#include "tensor_value.h"
 #include <numeric>
 #include <iostream>
+#include <cmath>
+#include <limits>
 
 namespace liquid
 {
@@ -27,6 +31,32 @@ namespace liquid
         Expects(topic, "add([5 6 5]) == [5 6 5]");
         Expects(topic, "add([5 6 5], 1) == [6 7 6]");
 
+        {
+            // with a uniform exponent std::pow is replaced by products, reciprocals and square roots
+            Real const infinity = std::numeric_limits<Real>::infinity();
+            Tensor const x({ 1.5, -2., 0., infinity, -infinity });
+            LIQUID_EXPECTS(( Pow(x, 2) == Tensor({ 2.25, 4., 0., infinity, infinity }) ));
+            LIQUID_EXPECTS(( Pow(x, 2.) == Pow(x, 2) ));
+            LIQUID_EXPECTS(( Pow(x, -1) == Tensor({ 1. / 1.5, -0.5, infinity, 0., 0. }) ));
+            LIQUID_EXPECTS(( Pow(x, 0) == Tensor(1., { 5 }) ));
+            LIQUID_EXPECTS(( Pow(x, Tensor(3, { 5 })) == Tensor({ 3.375, -8., 0., infinity, -infinity }) ));
+            LIQUID_EXPECTS(( Pow(Tensor({ 2.25, 0., infinity, -infinity }), 0.5) == Tensor({ 1.5, 0., infinity, infinity }) ));
+            LIQUID_EXPECTS(std::isnan(GetConstantValue(Pow(-2., 0.5)).GetAs<Real>()[0]));
+            LIQUID_EXPECTS(!std::signbit(GetConstantValue(Pow(-0., 0.5)).GetAs<Real>()[0]));
+            LIQUID_EXPECTS(std::signbit(GetConstantValue(Pow(-0., -1)).GetAs<Real>()[0]));
+
+            // broadcasting of the base, and an exponent that is not uniform
+            LIQUID_EXPECTS(( Pow(Tensor({ 1., 2. }), Tensor(2, { 3, 2 })) == Tensor({ { 1, 4 }, { 1, 4 }, { 1, 4 } }) ));
+            LIQUID_EXPECTS(( Pow(Tensor({ 2., 3. }), Tensor({ 3, -2 })) == Tensor({ 8., 1. / 9. }) ));
+
+            // in Fast precision exponentiation by squaring is used up to 64
+            PrecisionContext fast(Precision::Fast);
+            LIQUID_EXPECTS(( Pow(x, 5) == Tensor({ 7.59375, -32., 0., infinity, -infinity }) ));
+            LIQUID_EXPECTS(( Pow(Tensor({ 2., -0.5 }), -3) == Tensor({ 0.125, -8. }) ));
+            LIQUID_EXPECTS(( Pow(2., 64) == std::ldexp(1., 64) ));
+            LIQUID_EXPECTS(( Pow(2., 65) == std::ldexp(1., 65) ));
+        }
+
         std::cout << "done" << std::endl;
     }
 }
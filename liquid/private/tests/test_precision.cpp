@@ -0,0 +1,139 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "expression.h"
+#include "tensor_value.h"
+#include "incremental_evaluator.h"
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace liquid
+{
+    namespace
+    {
+        // distance in units in the last place of the exact value
+        Real GetUlpError(Real i_value, Real i_exact)
+        {
+            if(i_value == i_exact || (std::isnan(i_value) && std::isnan(i_exact)))
+                return 0;
+            Real const exact = std::abs(i_exact);
+            return std::abs(i_value - i_exact) / (std::nextafter(exact, std::numeric_limits<Real>::infinity()) - exact);
+        }
+
+        Tensor MakeUniform(Real i_min, Real i_max, uint32_t i_seed)
+        {
+            std::mt19937 generator(i_seed);
+            std::uniform_real_distribution<Real> distribution(i_min, i_max);
+            SharedArray<Real> scalars(4096);
+            for(Real & scalar : scalars)
+                scalar = distribution(generator);
+            return MakeConstant(TensorValue(std::move(scalars), FixedShape({ 4096 })));
+        }
+
+        template <typename FUNCTION, typename EXACT>
+            Real GetMaxUlpError(const Tensor & i_source, const FUNCTION & i_function, const EXACT & i_exact)
+        {
+            PrecisionContext precision(Precision::Fast);
+            Tensor const result = i_function(i_source);
+            Span<const Real> const source = GetConstantValue(i_source).GetAs<Real>();
+            Span<const Real> const values = GetConstantValue(result).GetAs<Real>();
+            Real max_error = 0;
+            for(size_t index = 0; index < source.size(); index++)
+                max_error = std::max(max_error, GetUlpError(values[index], i_exact(source[index])));
+            return max_error;
+        }
+    }
+
+    void TestPrecision()
+    {
+        std::cout << "Test Precision...";
+
+        {
+            LIQUID_EXPECTS(GetPrecision() == Precision::Exact);
+            {
+                PrecisionContext fast(Precision::Fast);
+                LIQUID_EXPECTS(GetPrecision() == Precision::Fast);
+                {
+                    PrecisionContext exact(Precision::Exact);
+                    LIQUID_EXPECTS(GetPrecision() == Precision::Exact);
+                }
+                LIQUID_EXPECTS(GetPrecision() == Precision::Fast);
+            }
+            LIQUID_EXPECTS(GetPrecision() == Precision::Exact);
+
+            // a context overrides the default
+            SetDefaultPrecision(Precision::Fast);
+            LIQUID_EXPECTS(GetPrecision() == Precision::Fast);
+            {
+                PrecisionContext exact(Precision::Exact);
+                LIQUID_EXPECTS(GetPrecision() == Precision::Exact);
+            }
+            SetDefaultPrecision(Precision::Exact);
+            LIQUID_EXPECTS(GetPrecision() == Precision::Exact);
+        }
+
+        {
+            auto const exp = [](Real i_x) { return std::exp(i_x); };
+            auto const log = [](Real i_x) { return std::log(i_x); };
+            auto const sin = [](Real i_x) { return std::sin(i_x); };
+            auto const cos = [](Real i_x) { return std::cos(i_x); };
+
+            LIQUID_EXPECTS(GetMaxUlpError(MakeUniform(-745., 710., 1), Exp, exp) <= 2);
+            LIQUID_EXPECTS(GetMaxUlpError(MakeUniform(-2., 2., 2), Exp, exp) <= 2);
+            LIQUID_EXPECTS(GetMaxUlpError(MakeUniform(0., 1e300, 3), Log, log) <= 1);
+            LIQUID_EXPECTS(GetMaxUlpError(MakeUniform(0.5, 2., 4), Log, log) <= 1);
+            LIQUID_EXPECTS(GetMaxUlpError(MakeUniform(-10., 10., 5), Sin, sin) <= 2);
+            LIQUID_EXPECTS(GetMaxUlpError(MakeUniform(-2e6, 2e6, 6), Sin, sin) <= 2);
+            LIQUID_EXPECTS(GetMaxUlpError(MakeUniform(-10., 10., 7), Cos, cos) <= 2);
+            LIQUID_EXPECTS(GetMaxUlpError(MakeUniform(-2e6, 2e6, 8), Cos, cos) <= 2);
+
+            // the error of pow grows with |y * log(x)|, here at most 20
+            Tensor const bases = MakeUniform(0.1, 10., 9);
+            Span<const Real> const base_values = GetConstantValue(bases).GetAs<Real>();
+            size_t index = 0;
+            LIQUID_EXPECTS(GetMaxUlpError(MakeUniform(-8.5, 8.5, 10), [&](const Tensor & i_exponents) {
+                return Pow(bases, i_exponents); }, [&](Real i_exponent) {
+                return std::pow(base_values[index++], i_exponent); }) <= 4 + 2.5 * 20);
+        }
+
+        {
+            // special values are computed by the C library
+            Real const infinity = std::numeric_limits<Real>::infinity();
+            Real const nan = std::numeric_limits<Real>::quiet_NaN();
+            PrecisionContext fast(Precision::Fast);
+            LIQUID_EXPECTS(( Exp(Tensor({ -infinity, 0., 710., -746. })) == Tensor({ 0., 1., infinity, 0. }) ));
+            LIQUID_EXPECTS(( Log(Tensor({ 0., 1., infinity })) == Tensor({ -infinity, 0., infinity }) ));
+            LIQUID_EXPECTS(std::isnan(GetConstantValue(Sin(infinity)).GetAs<Real>()[0]));
+            LIQUID_EXPECTS(std::signbit(GetConstantValue(Sin(-0.)).GetAs<Real>()[0]));
+            LIQUID_EXPECTS(std::isnan(GetConstantValue(Log(-1.)).GetAs<Real>()[0]));
+            LIQUID_EXPECTS(std::isnan(GetConstantValue(Exp(nan)).GetAs<Real>()[0]));
+            LIQUID_EXPECTS(( Pow(Tensor({ 0., -2., 2., infinity }), Tensor({ 2., 3., 2000., 0.5 })) ==
+                Tensor({ 0., -8., infinity, infinity }) ));
+        }
+
+        {
+            // an evaluator can use a precision different from the one of the thread
+            Tensor const x("real[4096] x");
+            Tensor const source = MakeUniform(-10., 10., 11);
+            IncrementalEvaluator fast_evaluator({ Exp(x) }, Precision::Fast);
+            IncrementalEvaluator exact_evaluator({ Exp(x) });
+            fast_evaluator.SetValue(x, GetConstantValue(source));
+            exact_evaluator.SetValue(x, GetConstantValue(source));
+            fast_evaluator.Update();
+            exact_evaluator.Update();
+
+            LIQUID_EXPECTS(GetPrecision() == Precision::Exact);
+            LIQUID_EXPECTS(exact_evaluator.GetValue(0) == GetConstantValue(Exp(source)));
+            LIQUID_EXPECTS(!(fast_evaluator.GetValue(0) == exact_evaluator.GetValue(0)));
+            PrecisionContext fast(Precision::Fast);
+            LIQUID_EXPECTS(fast_evaluator.GetValue(0) == GetConstantValue(Exp(source)));
+        }
+
+        std::cout << "done" << std::endl;
+    }
+}
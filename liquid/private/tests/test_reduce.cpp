@@ -0,0 +1,119 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "expression.h"
+#include "tensor_value.h"
+#include "book.h"
+#include <iostream>
+#include <limits>
+
+namespace liquid
+{
+    void TestReduce()
+    {
+        std::cout << "Test Reduce...";
+
+        Tensor const a({{1., 2., 3.}, {4., 5., 6.}});
+        Tensor const cube({{{1, 2}, {3, 4}}, {{5, 6}, {7, 8}}});
+
+        {
+            LIQUID_EXPECTS(Sum(a) == 21);
+            LIQUID_EXPECTS(( Sum(a, {0}) == Tensor({5, 7, 9}) ));
+            LIQUID_EXPECTS(( Sum(a, {1}) == Tensor({6, 15}) ));
+            LIQUID_EXPECTS(( Sum(cube, {0, 2}) == Tensor({14, 22}) ));
+            LIQUID_EXPECTS(( Sum(cube, {1}) == Tensor({{4, 6}, {12, 14}}) ));
+            LIQUID_EXPECTS(Sum(cube).GetScalarType() == ScalarType::Integer);
+
+            LIQUID_EXPECTS(Product(a) == 720);
+            LIQUID_EXPECTS(( Product(cube, {2}) == Tensor({{2, 12}, {30, 56}}) ));
+            LIQUID_EXPECTS(( Min(a, {0}) == Tensor({1, 2, 3}) ));
+            LIQUID_EXPECTS(( Max(a, {1}) == Tensor({3, 6}) ));
+            LIQUID_EXPECTS(Min(cube) == 1);
+            LIQUID_EXPECTS(Max(-cube) == -1);
+
+            Tensor const flags({{true, false}, {true, true}});
+            LIQUID_EXPECTS(( All(flags, {1}) == Tensor({false, true}) ));
+            LIQUID_EXPECTS(( Any(flags, {0}) == Tensor({true, true}) ));
+            LIQUID_EXPECTS(All(flags) == false);
+            LIQUID_EXPECTS(Any(flags) == true);
+
+            // infinities, and empty axes
+            Real const infinity = std::numeric_limits<Real>::infinity();
+            LIQUID_EXPECTS(( Min(Tensor({infinity, infinity})) == infinity ));
+            LIQUID_EXPECTS(( Max(Tensor({-infinity, -infinity})) == -infinity ));
+            LIQUID_EXPECTS(( Min(Tensor(1., {2, 0}), {1}) == Tensor({infinity, infinity}) ));
+            LIQUID_EXPECTS(( Max(Cast<Real32>(Tensor(1., {2, 0})), {1}) == Cast<Real32>(Tensor({-infinity, -infinity})) ));
+            LIQUID_EXPECTS(( Max(Tensor(1, {2, 0}), {1}) == Tensor(std::numeric_limits<Integer>::lowest(), {2}) ));
+
+            // wrapped storage
+            LIQUID_EXPECTS(( Sum(Tensor(2, {3, 4}), {1}) == Tensor({8, 8, 8}) ));
+
+            LIQUID_EXPECTS_PANIC(Sum(a, {2}), "sum: the axis 2 is out of range for the rank 2");
+            LIQUID_EXPECTS_PANIC(Sum(Tensor({true})), "sum: could not find an overload matching the argument types: bool[1]");
+        }
+
+        {
+            // long rows are reduced in chunks, and in parallel
+            size_t const size = size_t(1) << 21;
+            SharedArray<Integer> elements(size);
+            Integer first_row = 0, second_row = 0;
+            for(size_t index = 0; index < size; index++)
+            {
+                elements[index] = static_cast<Integer>(index % 1000);
+                (index < size / 2 ? first_row : second_row) += elements[index];
+            }
+            Tensor const large = MakeConstant(TensorValue(std::move(elements), FixedShape({ 2, Integer(size / 2) })));
+            LIQUID_EXPECTS(Sum(large) == first_row + second_row);
+            LIQUID_EXPECTS(( Sum(large, {1}) == Tensor({first_row, second_row}) ));
+            LIQUID_EXPECTS(( Sum(large, {0}) == Sum(Stack({large}, 2), {0, 2}) ));
+        }
+
+        {
+            // reductions with all the axes are identical to the reductions without axes
+            Tensor const x("real[2, 3] x"), y("real[2, 3] y");
+            LIQUID_EXPECTS(AreIdentical(Sum(x, {0, 1}), Sum(x)));
+            LIQUID_EXPECTS(AreIdentical(Sum(x, Span<const Integer>()), x));
+
+            // reductions are distributed over the elementwise operation
+            LIQUID_EXPECTS(AreIdentical(Sum(x + y, {1}), Sum(x, {1}) + Sum(y, {1})));
+            LIQUID_EXPECTS(AreIdentical(Sum(x + 2., {1}), Sum(x, {1}) + 6.));
+            LIQUID_EXPECTS(AreIdentical(Product(x * y), Product(x) * Product(y)));
+            LIQUID_EXPECTS(!AreIdentical(Sum(x + Tensor({1., 2., 3.})), Sum(x) + Sum(Tensor({1., 2., 3.}))));
+
+            Tensor const p("bool[2] p"), q("bool[2] q");
+            LIQUID_EXPECTS(AreIdentical(All(p && q), All(p) && All(q)));
+            LIQUID_EXPECTS(AreIdentical(Any(p || q), Any(p) || Any(q)));
+
+            // uniform operands are not distributed over empty axes
+            Tensor const e("bool[2, 0] e"), s("bool[] s");
+            std::vector<Rule> const values = { Rule{ e, Tensor(true, {2, 0}) }, Rule{ s, false } };
+            LIQUID_EXPECTS(( Substitute(All(e && s, {1}), values) == Tensor({true, true}) ));
+            LIQUID_EXPECTS(( Substitute(Any(e || !s, {1}), values) == Tensor({false, false}) ));
+            LIQUID_EXPECTS(AreIdentical(All(p && s), All(p) && s));
+        }
+
+        {
+            Tensor const x("real[2, 3] x");
+            Tensor const gradient({10., 20.});
+            auto const gradient_at_a = [&](const char * i_operator, const Tensor & i_reduction, const Tensor & i_gradient) {
+                return Substitute(Book::Get().GetOperator(i_operator).GetGradientOfOperand(i_reduction, i_gradient, 0), x, a); };
+
+            LIQUID_EXPECTS(( gradient_at_a("sum", Sum(x, {1}), gradient) == Tensor({{10, 10, 10}, {20, 20, 20}}) ));
+            LIQUID_EXPECTS(( gradient_at_a("sum", Sum(x), 2.) == Tensor(2., {2, 3}) ));
+            LIQUID_EXPECTS(( gradient_at_a("product", Product(x, {1}), gradient) ==
+                Tensor({{60, 30, 20}, {600, 480, 400}}) ));
+            // with zeros the derivatives are the products of the other elements
+            LIQUID_EXPECTS(( Substitute(Book::Get().GetOperator("product").GetGradientOfOperand(Product(x, {1}), gradient, 0),
+                x, Tensor({{1., 0., 3.}, {0., 5., 0.}})) == Tensor({{0, 30, 0}, {0, 0, 0}}) ));
+            LIQUID_EXPECTS(( gradient_at_a("max", Max(x, {0}), Tensor({1., 2., 3.})) == Tensor({{0, 0, 0}, {1, 2, 3}}) ));
+            LIQUID_EXPECTS(( gradient_at_a("min", Min(x, {1}), gradient) == Tensor({{10, 0, 0}, {20, 0, 0}}) ));
+            LIQUID_EXPECTS_PANIC(Book::Get().GetOperator("all").GetGradientOfOperand(All(x > 0.), true, 0),
+                "all: the gradient is not defined");
+        }
+
+        std::cout << "done" << std::endl;
+    }
+}
@@ -5,7 +5,11 @@
 //          http://www.boost.org/LICENSE_1_0.txt)
 
 #include "private_common.h"
+#include "expression.h"
+#include "tensor_value.h"
+#include "book.h"
 #include <iostream>
+#include <sstream>
 
 namespace liquid
 {
@@ -18,10 +22,100 @@ namespace liquid
         LIQUID_EXPECTS_DOC(topic, GetScalarType<Real>() == ScalarType::Real);
         LIQUID_EXPECTS_DOC(topic, GetScalarType<Integer>() == ScalarType::Integer);
         LIQUID_EXPECTS_DOC(topic, GetScalarType<Bool>() == ScalarType::Bool);
+        LIQUID_EXPECTS_DOC(topic, GetScalarType<Real32>() == ScalarType::Real32);
+        LIQUID_EXPECTS_DOC(topic, GetScalarType<Integer32>() == ScalarType::Integer32);
+        LIQUID_EXPECTS_DOC(topic, GetScalarType<Integer8>() == ScalarType::Integer8);
 
         static_assert(std::is_same_v<FromScalarType<ScalarType::Real>, Real>);
         static_assert(std::is_same_v<FromScalarType<ScalarType::Integer>, Integer>);
         static_assert(std::is_same_v<FromScalarType<ScalarType::Bool>, Bool>);
+        static_assert(std::is_same_v<FromScalarType<ScalarType::Real32>, Real32>);
+        static_assert(std::is_same_v<FromScalarType<ScalarType::Integer32>, Integer32>);
+        static_assert(std::is_same_v<FromScalarType<ScalarType::Integer8>, Integer8>);
+
+        {
+            Tensor const real32 = Cast<Real32>(Tensor({0.5, 1.5}));
+            Tensor const int32 = Cast<Integer32>(Tensor({1, 2}));
+            Tensor const int8 = Cast<Integer8>(Tensor({3, 4}));
+
+            // the kernels keep the narrow types
+            LIQUID_EXPECTS(real32.GetScalarType() == ScalarType::Real32);
+            LIQUID_EXPECTS((real32 + real32).GetScalarType() == ScalarType::Real32);
+            LIQUID_EXPECTS((real32 / real32).GetScalarType() == ScalarType::Real32);
+            LIQUID_EXPECTS(Exp(real32).GetScalarType() == ScalarType::Real32);
+            LIQUID_EXPECTS((int8 * int8).GetScalarType() == ScalarType::Integer8);
+            LIQUID_EXPECTS(Sum(int32).GetScalarType() == ScalarType::Integer32);
+            LIQUID_EXPECTS(( Exp(real32) == Cast<Real32>(Exp(Cast<Real>(real32))) ));
+            LIQUID_EXPECTS(( MatMul(Reshape(int8, {1, 2}), Reshape(int8, {2, 1})) == Tensor({{25}}) ));
+
+            // numeric promotion to the operand with the higher rank
+            LIQUID_EXPECTS((int8 + int32).GetScalarType() == ScalarType::Integer32);
+            LIQUID_EXPECTS((int32 + 1).GetScalarType() == ScalarType::Integer);
+            LIQUID_EXPECTS((real32 + 1).GetScalarType() == ScalarType::Real32);
+            LIQUID_EXPECTS((real32 + 1.).GetScalarType() == ScalarType::Real);
+            LIQUID_EXPECTS(( int8 + int32 == Tensor({4, 6}) ));
+            LIQUID_EXPECTS(( real32 * 2 == Tensor({1., 3.}) ));
+
+            // integers become Real, unless the operation involves a Real32
+            LIQUID_EXPECTS((Tensor(1) / Tensor(2)).GetScalarType() == ScalarType::Real);
+            LIQUID_EXPECTS((int8 / int8).GetScalarType() == ScalarType::Real);
+            LIQUID_EXPECTS(Pow(int8, real32).GetScalarType() == ScalarType::Real32);
+
+            LIQUID_EXPECTS(( Cast<Integer>(Cast<Integer8>(Tensor({-128, 127}))) == Tensor({-128, 127}) ));
+            LIQUID_EXPECTS(( Cast<Real>(Cast<Real32>(Tensor(0.1))) == Tensor(static_cast<Real>(0.1f)) ));
+
+            // 8-bit integers are printed as numbers
+            std::ostringstream stream;
+            stream << int8;
+            LIQUID_EXPECTS(stream.str() == "3, 4");
+        }
+
+        {
+            // canonicalizations don't promote the narrow types
+            Tensor const a("int8[3] a"), b("int8[3] b"), i("int32[3] i"), f("real32[3] f"), g("real32[3] g");
+            auto const type_of = [](const Tensor & i_tensor) { return i_tensor.GetExpression()->GetType(); };
+            TensorType const int8_vector(ScalarType::Integer8, FixedShape{3});
+            TensorType const real32_vector(ScalarType::Real32, FixedShape{3});
+
+            LIQUID_EXPECTS(type_of(a + a) == int8_vector);
+            LIQUID_EXPECTS(type_of(a * a) == int8_vector);
+            LIQUID_EXPECTS(type_of(-a) == int8_vector);
+            LIQUID_EXPECTS(type_of(a - b) == int8_vector);
+            LIQUID_EXPECTS(type_of(a * b * a) == int8_vector);
+            Tensor const product = a * b * a;
+            for(const Tensor & factor : product.GetExpression()->GetOperands())
+                LIQUID_EXPECTS(type_of(factor) == int8_vector);
+            LIQUID_EXPECTS(type_of(a * a + a * b) == int8_vector);
+            LIQUID_EXPECTS(type_of(i * i * i) == TensorType(ScalarType::Integer32, FixedShape{3}));
+            LIQUID_EXPECTS(type_of(Sum(a + Cast<Integer8>(Tensor(1)))) == type_of(Sum(a)));
+
+            LIQUID_EXPECTS(type_of(f + f) == real32_vector);
+            LIQUID_EXPECTS(type_of(f * f) == real32_vector);
+            LIQUID_EXPECTS(type_of(f - g) == real32_vector);
+            LIQUID_EXPECTS(type_of(f * 0).GetScalarType() == ScalarType::Real32);
+            LIQUID_EXPECTS(type_of(f / f).GetScalarType() == ScalarType::Real32);
+            LIQUID_EXPECTS(type_of(Pow(f, 0)).GetScalarType() == ScalarType::Real32);
+            LIQUID_EXPECTS(type_of(Sum(f + Cast<Real32>(Tensor(1.)))) == type_of(Sum(f)));
+
+            // the gradients of slice and gather keep the scalar type of the source
+            Tensor const gradient = Cast<Real32>(Tensor({1., 2.}));
+            LIQUID_EXPECTS(type_of(Book::Get().GetOperator("slice").GetGradientOfOperand(
+                Slice(f, 0, 0, 2), gradient, 0)) == real32_vector);
+            LIQUID_EXPECTS(type_of(Book::Get().GetOperator("gather").GetGradientOfOperand(
+                Gather(f, Tensor({0, 2})), gradient, 0)) == real32_vector);
+
+            // a pow with a real32 exponent is factored as a whole
+            Tensor const e = Cast<Real32>(Tensor(2.5));
+            LIQUID_EXPECTS(type_of(Pow(f, e) * g + Pow(f, e) * f) == real32_vector);
+        }
+
+        {
+            LIQUID_EXPECTS(( Tensor("real32[2] x").GetExpression()->GetType() == TensorType(ScalarType::Real32, FixedShape{2}) ));
+            LIQUID_EXPECTS(Tensor("int32 n").GetScalarType() == ScalarType::Integer32);
+            LIQUID_EXPECTS(Tensor("int8[3] v").GetScalarType() == ScalarType::Integer8);
+            LIQUID_EXPECTS(Tensor("real x").GetScalarType() == ScalarType::Real);
+            LIQUID_EXPECTS(Tensor("int n").GetScalarType() == ScalarType::Integer);
+        }
 
         std::cout << "done" << std::endl;
     }
@@ -0,0 +1,46 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "expression.h"
+#include <sstream>
+#include <iostream>
+
+namespace liquid
+{
+    void TestSerialize()
+    {
+        std::cout << "Test Serialize...";
+
+        {
+            Tensor const x("real x");
+            Tensor const angle = Sin(x * 2);
+            Tensor const cosine = Cos(angle);
+            Tensor const rotation = Stack({ cosine, -angle, angle, cosine });
+            Tensor const roots[] = { rotation, Tensor("[[1 2][3 4]] * real[2 2] y"),
+                Tensor("int[] n is int[2]"), Shape(x), Tensor("real32[2] z") * Cast<Real32>(Tensor({0.5, 2.})),
+                Cast<Integer8>(Tensor({-3, 7})) };
+
+            std::stringstream stream;
+            WriteBinary(stream, roots);
+            std::vector<Tensor> const read = ReadBinary(stream);
+
+            LIQUID_EXPECTS(read.size() == std::size(roots));
+            for(size_t i = 0; i < read.size(); i++)
+                LIQUID_EXPECTS(AreIdentical(read[i], roots[i]));
+
+            // shared subexpressions are still shared
+            auto const & read_rotation = read[0].GetExpression()->GetOperands();
+            LIQUID_EXPECTS(read_rotation.at(0).GetExpression() == read_rotation.at(3).GetExpression());
+        }
+
+        {
+            std::stringstream stream("not a graph");
+            LIQUID_EXPECTS_PANIC(ReadBinary(stream), "BinaryReader - not a liquid binary stream");
+        }
+
+        std::cout << "done" << std::endl;
+    }
+}
@@ -0,0 +1,86 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "expression.h"
+#include "tensor_value.h"
+#include "book.h"
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace liquid
+{
+    void TestSoftmax()
+    {
+        std::cout << "Test Softmax...";
+
+        Tensor const a({{1., 2., 3.}, {4., 5., 7.}});
+        auto const close = [](const Tensor & i_first, const Tensor & i_second) {
+            Tensor const difference = i_first - i_second;
+            return All(difference * difference < 1e-24); };
+
+        // naive versions, fine for small elements
+        auto const naive_softmax = [](const Tensor & i_source, Integer i_axis, std::vector<Integer> i_kept) {
+            return Exp(i_source) / Reshape(Sum(Exp(i_source), { i_axis }), i_kept); };
+        auto const naive_log_sum_exp = [](const Tensor & i_source, Integer i_axis) {
+            return Log(Sum(Exp(i_source), { i_axis })); };
+
+        {
+            LIQUID_EXPECTS(close(LogSumExp(a), naive_log_sum_exp(a, 1)));
+            LIQUID_EXPECTS(close(LogSumExp(a, 0), naive_log_sum_exp(a, 0)));
+            LIQUID_EXPECTS(close(Softmax(a), naive_softmax(a, 1, { 2, 1 })));
+            LIQUID_EXPECTS(close(Softmax(a, 0), naive_softmax(a, 0, { 1, 3 })));
+            LIQUID_EXPECTS(close(Sum(Softmax(a, 0), {0}), Tensor({1., 1., 1.})));
+            LIQUID_EXPECTS(AreIdentical(Softmax(a, 1), Softmax(a)));
+
+            // long rows are split in lanes, with a tail
+            Tensor const row = Stack(std::vector<Tensor>{ Tensor(0.5), Tensor(-1.), Tensor(2.), Tensor(0.),
+                Tensor(1.5), Tensor(-3.), Tensor(2.5), Tensor(1.), Tensor(0.25), Tensor(-0.5), Tensor(3.) });
+            LIQUID_EXPECTS(close(LogSumExp(row), naive_log_sum_exp(row, 0)));
+            LIQUID_EXPECTS(close(Softmax(Transpose(a)), naive_softmax(Transpose(a), 1, { 3, 1 })));
+            LIQUID_EXPECTS(close(LogSumExp(Tensor({1, 2, 3})), naive_log_sum_exp(Tensor({1., 2., 3.}), 0)));
+        }
+
+        {
+            // the naive versions would overflow
+            LIQUID_EXPECTS(close(Softmax(Tensor({1000., 1000.})), Tensor({0.5, 0.5})));
+            LIQUID_EXPECTS(close(LogSumExp(Tensor({1000., 1000.})) - 1000., Log(2.)));
+            LIQUID_EXPECTS(close(LogSumExp(Tensor({-1000., -1000.})) + 1000., Log(2.)));
+            LIQUID_EXPECTS(close(Softmax(Tensor({1000., 0.})), Tensor({1., 0.})));
+
+            Real const infinity = std::numeric_limits<Real>::infinity();
+            LIQUID_EXPECTS(( LogSumExp(Tensor({-infinity, -infinity})) == -infinity ));
+            LIQUID_EXPECTS(( LogSumExp(Tensor({1., infinity})) == infinity ));
+            LIQUID_EXPECTS(( Softmax(Tensor({-infinity, 0.})) == Tensor({0., 1.}) ));
+        }
+
+        {
+            LIQUID_EXPECTS_PANIC(Softmax(a, 2), "softmax: the axis 2 is out of range for the rank 2");
+            LIQUID_EXPECTS_PANIC(LogSumExp(a, -1), "log_sum_exp: the axis -1 is out of range for the rank 2");
+            LIQUID_EXPECTS_PANIC(Softmax(1.), "softmax: the axis -1 is out of range for the rank 0");
+        }
+
+        {
+            Tensor const x("real[2, 3] x");
+            auto const gradient_at_a = [&](const char * i_operator, const Tensor & i_self, const Tensor & i_gradient) {
+                return Substitute(Book::Get().GetOperator(i_operator).GetGradientOfOperand(i_self, i_gradient, 0), x, a); };
+
+            Tensor const reduced_gradient({10., 20.});
+            LIQUID_EXPECTS(close(gradient_at_a("log_sum_exp", LogSumExp(x), reduced_gradient),
+                naive_softmax(a, 1, { 2, 1 }) * Reshape(reduced_gradient, { 2, 1 })));
+
+            Tensor const gradient({{1., 0., 2.}, {0., 3., 1.}});
+            Tensor const y = naive_softmax(a, 0, { 1, 3 });
+            LIQUID_EXPECTS(close(gradient_at_a("softmax", Softmax(x, 0), gradient),
+                y * (gradient - Reshape(Sum(gradient * y, {0}), { 1, 3 }))));
+
+            // the softmax doesn't change if the same value is added along the axis
+            LIQUID_EXPECTS(close(gradient_at_a("softmax", Softmax(x), Tensor(5., {2, 3})), Tensor(0., {2, 3})));
+        }
+
+        std::cout << "done" << std::endl;
+    }
+}
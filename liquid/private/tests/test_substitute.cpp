@@ -28,6 +28,28 @@ namespace liquid
             LIQUID_EXPECTS(tensor == 6);
         }
 
+        {
+            Tensor const x("real x"), y("real y");
+
+            Tensor const bound = Substitute(x * y + Sin(x), { Rule{x, 2}, Rule{y, 3} });
+            LIQUID_EXPECTS(IsConstant(bound));
+            LIQUID_EXPECTS(Always(bound == 6 + Sin(2)));
+
+            LIQUID_EXPECTS(Always(Substitute(x + y, x, y) == 2 * y));
+            LIQUID_EXPECTS(AreIdentical(Substitute(x + 1, x, 4, false), x + 1));
+            LIQUID_EXPECTS(AreIdentical(Substitute(x, x, 1, y > 0), If(y > 0, 1, x)));
+
+            // replacements are not substituted again
+            LIQUID_EXPECTS(AreIdentical(Substitute(x + y, { Rule{x, y}, Rule{y, x} }), x + y));
+
+            // shared nodes are substituted once
+            Tensor deep = x;
+            for(int i = 0; i < 256; i++)
+                deep = Sin(deep) + Exp(deep);
+            LIQUID_EXPECTS(IsConstant(Substitute(deep, x, 0.)));
+            LIQUID_EXPECTS(AreIdentical(Substitute(deep, y, 0.), deep));
+        }
+
 
         std::cout << "done" << std::endl;
     }
@@ -0,0 +1,99 @@
+
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "expression.h"
+#include "tensor_type.h"
+#include "operator.h"
+#include "incremental_evaluator.h"
+#include <iostream>
+#include <sstream>
+
+namespace liquid
+{
+    extern const Operator & GetOperatorAdd();
+
+    void TestSymbolicShapes()
+    {
+        std::cout << "Test SymbolicShapes...";
+
+        auto const type_of = [](const Tensor & i_tensor) {
+            std::ostringstream stream;
+            stream << i_tensor.GetExpression()->GetType();
+            return stream.str();
+        };
+
+        Tensor const n("int n"), x("real[int n, 3] x");
+
+        // deduction
+        {
+            LIQUID_EXPECTS(type_of(x) == "real[n, 3]");
+            LIQUID_EXPECTS(type_of(Sin(x) + x) == "real[n, 3]");
+            LIQUID_EXPECTS(type_of(x * Tensor({1., 2., 3.})) == "real[n, 3]");
+            LIQUID_EXPECTS(type_of(x < 0.) == "bool[n, 3]");
+            LIQUID_EXPECTS(type_of(Stack({x, x})) == "real[2, n, 3]");
+            LIQUID_EXPECTS(type_of(Softmax(x)) == "real[n, 3]");
+            LIQUID_EXPECTS(type_of(LogSumExp(x)) == "real[n]");
+            LIQUID_EXPECTS(type_of(Sum(x, {1})) == "real[n]");
+            LIQUID_EXPECTS(type_of(Sum(x, {0})) == "real[3]");
+            LIQUID_EXPECTS(type_of(Transpose(x)) == "real[3, n]");
+            LIQUID_EXPECTS(type_of(MatMul(x, Tensor("real[3, int k] m"))) == "real[n, k]");
+
+            LIQUID_EXPECTS(AreIdentical(Shape(x), Stack({n, 3})));
+            LIQUID_EXPECTS(AreIdentical(Rank(x), 2));
+        }
+
+        // broadcasting a dimension that may be 1 adds a constraint
+        {
+            Tensor const w("real[int k, 1] w");
+            LIQUID_EXPECTS(type_of(x + w) == "real[if(equal(n, 1), k, n), 3]");
+            LIQUID_EXPECTS(GetOperatorAdd().GetShapeConstraints({}, std::vector<Tensor>{ x, w }).size() == 1);
+            LIQUID_EXPECTS(GetOperatorAdd().GetShapeConstraints({}, std::vector<Tensor>{ x, x }).empty());
+
+            LIQUID_EXPECTS_PANIC(x + Tensor({1., 2., 3., 4.}), "Broadcast failure");
+        }
+
+        // the evaluator is built once, and used for any n
+        {
+            Tensor const result = Sum(Sin(x) * n);
+            IncrementalEvaluator evaluator({ result, Shape(x) });
+
+            Tensor const first = Tensor({{1., 2., 3.}, {4., 5., 6.}});
+            evaluator.SetValue(x, GetConstantValue(first));
+            evaluator.Update();
+            LIQUID_EXPECTS(evaluator.GetValue(0) == GetConstantValue(Sum(Sin(first) * 2)));
+            LIQUID_EXPECTS(evaluator.GetValue(1) == GetConstantValue(Tensor({2, 3})));
+
+            Tensor const second = Tensor({{1., 2., 3.}, {4., 5., 6.}, {7., 8., 9.}, {0., 0., 0.}, {1., 1., 1.}});
+            evaluator.SetValue(x, GetConstantValue(second));
+            evaluator.Update();
+            LIQUID_EXPECTS(evaluator.GetValue(0) == GetConstantValue(Sum(Sin(second) * 5)));
+            LIQUID_EXPECTS(evaluator.GetValue(1) == GetConstantValue(Tensor({5, 3})));
+
+            LIQUID_EXPECTS_PANIC(evaluator.SetValue(n, GetConstantValue(Tensor(3))), "is a dimension");
+            LIQUID_EXPECTS_PANIC(evaluator.SetValue(x, GetConstantValue(Tensor({1., 2., 3.}))), "can't have a value of type");
+        }
+
+        // the shapes are checked before evaluating any node
+        {
+            Tensor const y("real[int n] y"), w("real[int k, 1] w");
+            IncrementalEvaluator evaluator({ x + w, Sum(y) });
+            evaluator.SetValue(x, GetConstantValue(Tensor({{1., 2., 3.}, {4., 5., 6.}})));
+            evaluator.SetValue(y, GetConstantValue(Tensor({1., 2.})));
+            evaluator.SetValue(w, GetConstantValue(Tensor({{1.}})));
+            LIQUID_EXPECTS(evaluator.Update() == 2);
+
+            evaluator.SetValue(y, GetConstantValue(Tensor({1., 2., 3.})));
+            LIQUID_EXPECTS_PANIC(evaluator.Update(), "the dimension n is 2, but it's 3 in y");
+
+            evaluator.SetValue(y, GetConstantValue(Tensor({1., 2.})));
+            evaluator.SetValue(w, GetConstantValue(Tensor({{1.}, {2.}, {3.}})));
+            LIQUID_EXPECTS_PANIC(evaluator.Update(), "violate the constraint");
+        }
+
+        std::cout << "done" << std::endl;
+    }
+}
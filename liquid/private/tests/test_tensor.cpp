@@ -6,8 +6,11 @@
 
 #include "private_common.h"
 #include "indices.h"
+#include "expression.h"
+#include <memory>
 #include <numeric>
 #include <iostream>
+#include <sstream>
 
 namespace liquid
 {
@@ -76,12 +79,68 @@ namespace liquid
             LIQUID_EXPECTS_PANIC(Add(true), "add: could not find an overload matching the argument types: bool[]");
         }
 
+        {
+            Tensor const a({{1, 2, 3}, {4, 5, 6}});
+            Tensor const b({{7, 8, 9}, {10, 11, 12}});
+
+            LIQUID_EXPECTS(( Stack({a, b}) == Tensor({ {{1, 2, 3}, {4, 5, 6}}, {{7, 8, 9}, {10, 11, 12}} }) ));
+            LIQUID_EXPECTS(( Stack({a, b}, 1) == Tensor({ {{1, 2, 3}, {7, 8, 9}}, {{4, 5, 6}, {10, 11, 12}} }) ));
+            LIQUID_EXPECTS(( Stack({a, b}, 2) == Tensor({ {{1, 7}, {2, 8}, {3, 9}}, {{4, 10}, {5, 11}, {6, 12}} }) ));
+            LIQUID_EXPECTS(AreIdentical(Stack({a, b}, 0), Stack({a, b})));
+
+            // broadcast operands: a scalar, a row, and a column
+            LIQUID_EXPECTS(( Stack({a, 0}, 2) == Tensor({ {{1, 0}, {2, 0}, {3, 0}}, {{4, 0}, {5, 0}, {6, 0}} }) ));
+            LIQUID_EXPECTS(( Stack({a, Tensor({0, 1, 2})}, 1) == Tensor({ {{1, 2, 3}, {0, 1, 2}}, {{4, 5, 6}, {0, 1, 2}} }) ));
+            LIQUID_EXPECTS(( Stack({a, Tensor({{0}, {1}})}, 1) == Tensor({ {{1, 2, 3}, {0, 0, 0}}, {{4, 5, 6}, {1, 1, 1}} }) ));
+
+            Tensor const x("real[2, 3] x");
+            LIQUID_EXPECTS(( Shape(Stack({x, x, x}, 1)) == Tensor({2, 3, 3}) ));
+            LIQUID_EXPECTS(!AreIdentical(Stack({x, x}, 1), Stack({x, x}, 2)));
+            LIQUID_EXPECTS_PANIC(Stack({a, b}, 3), "stack: the axis 3 is out of range for the rank 2");
+        }
+
         {
             Expects("[1 2] is int[2]");
             Expects("[ log[ 3 real[] ]"
                     "  exp[5 6] + 2  ] is real [2, 2]");
         }
 
+        {
+            // shared nodes are printed once
+            Tensor t("real x");
+            for(int i = 0; i < 64; i++)
+                t = Sin(t) * Cos(t);
+
+            std::ostringstream stream;
+            stream << t;
+            LIQUID_EXPECTS(stream.str().size() < 64 * 64);
+            LIQUID_EXPECTS(stream.str().find("let $0 = ") == 0);
+
+            std::ostringstream tree_stream;
+            tree_stream << Sin(Tensor("real y")) + 1;
+            LIQUID_EXPECTS(tree_stream.str().find("let") == std::string::npos);
+        }
+
+        {
+            // identical pairs are cached, but only while both expressions are alive
+            auto const make_graph = [](const char * i_leaf) {
+                Tensor t(i_leaf);
+                for(int i = 0; i < 64; i++)
+                    t = Sin(t) + Exp(t);
+                return t;
+            };
+            Tensor const first = make_graph("real x");
+            auto second = std::make_unique<Tensor>(make_graph("real x"));
+            LIQUID_EXPECTS(AreIdentical(first, *second));
+            LIQUID_EXPECTS(AreIdentical(*second, first));
+            second.reset();
+            for(int i = 0; i < 16; i++)
+            {
+                LIQUID_EXPECTS(!AreIdentical(first, make_graph("real y")));
+                LIQUID_EXPECTS(AreIdentical(first, make_graph("real x")));
+            }
+        }
+
         std::cout << "done" << std::endl;
     }
 }
@@ -0,0 +1,84 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "expression.h"
+#include "scope.h"
+#include "book.h"
+#include "miu6/parser.h"
+#include <thread>
+#include <atomic>
+#include <iostream>
+
+namespace liquid
+{
+    namespace
+    {
+        Tensor BuildGraph(int i_seed)
+        {
+            Tensor x("real[2] x");
+            Tensor result = x * i_seed;
+            for(int i = 0; i < 16; i++)
+                result = Sin(result) * Cos(result) + Exp(x) / (result + i) - Pow(result, 2);
+            return result;
+        }
+    }
+
+    void TestThreadSafety()
+    {
+        std::cout << "Test ThreadSafety...";
+
+        constexpr int thread_count = 8;
+        constexpr int iterations = 32;
+
+        auto const shared_scope = Scope::Root()->MakeInner();
+        std::atomic<int> failures{0};
+
+        std::vector<std::thread> threads;
+        for(int thread_index = 0; thread_index < thread_count; thread_index++)
+        {
+            threads.emplace_back([&, thread_index]{
+                try
+                {
+                    for(int iteration = 0; iteration < iterations; iteration++)
+                    {
+                        // graphs built concurrently are identical
+                        int const seed = iteration % 4;
+                        if(!AreIdentical(BuildGraph(seed), BuildGraph(seed)))
+                            failures++;
+
+                        // parsing, and panics that must stay silent on this thread only
+                        Tensor const parsed("[[1 2][3 4]] * real[2 2] y + if real z > 0 then 1 else 2");
+                        if(parsed.GetScalarType() != ScalarType::Real)
+                            failures++;
+                        ExpectsPanic("[1 2] + [1 2 3]", "");
+
+                        // concurrent declarations and lookups on a shared scope
+                        std::string const name = "v" + std::to_string(thread_index) +
+                            "x" + std::to_string(iteration);
+                        shared_scope->AddVariable(MakeVariable(ScalarType::Real, name));
+                        if(!std::holds_alternative<Tensor>(shared_scope->Lookup(name)) ||
+                                !std::holds_alternative<std::reference_wrapper<const Operator>>(
+                                    shared_scope->Lookup("add")))
+                            failures++;
+
+                        if(&Book::Get().GetOperator("mul") != &Mul(Tensor("real a"), 2).GetExpression()->GetOperator())
+                            failures++;
+                    }
+                }
+                catch(...)
+                {
+                    failures++;
+                }
+            });
+        }
+        for(auto & thread : threads)
+            thread.join();
+
+        LIQUID_EXPECTS(failures == 0);
+
+        std::cout << "done" << std::endl;
+    }
+}
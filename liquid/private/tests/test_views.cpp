@@ -0,0 +1,97 @@
+//   Copyright Giuseppe Campana (giu.campana@gmail.com) 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "private_common.h"
+#include "expression.h"
+#include "tensor_value.h"
+#include "book.h"
+#include "hash.h"
+#include <iostream>
+
+namespace liquid
+{
+    void TestViews()
+    {
+        std::cout << "Test Views...";
+
+        Tensor const a({{1., 2., 3.}, {4., 5., 6.}});
+        Tensor const cube({{{1, 2}, {3, 4}}, {{5, 6}, {7, 8}}});
+
+        {
+            LIQUID_EXPECTS(( Reshape(a, {3, 2}) == Tensor({{1, 2}, {3, 4}, {5, 6}}) ));
+            LIQUID_EXPECTS(( Reshape(a, {6}) == Tensor({1, 2, 3, 4, 5, 6}) ));
+            LIQUID_EXPECTS(( Transpose(a) == Tensor({{1, 4}, {2, 5}, {3, 6}}) ));
+            LIQUID_EXPECTS(( Transpose(cube, {0, 2, 1}) == Tensor({{{1, 3}, {2, 4}}, {{5, 7}, {6, 8}}}) ));
+            LIQUID_EXPECTS(( BroadcastTo(Tensor({1, 2}), {2, 2}) == Tensor({{1, 2}, {1, 2}}) ));
+            LIQUID_EXPECTS(( BroadcastTo(Tensor({{1}, {2}}), {2, 3}) == Tensor({{1, 1, 1}, {2, 2, 2}}) ));
+
+            // views of views, and reshapes of views that need a copy
+            LIQUID_EXPECTS(( Transpose(Transpose(cube, {1, 2, 0}), {1, 2, 0}) == Transpose(cube, {2, 0, 1}) ));
+            LIQUID_EXPECTS(( Reshape(Transpose(a), {6}) == Tensor({1, 4, 2, 5, 3, 6}) ));
+            LIQUID_EXPECTS(( Reshape(Tensor(2, {2, 3}), {3, 2}) == Tensor(2, {3, 2}) ));
+
+            // views share the storage of the source
+            Tensor const transposed = Transpose(a), reshaped = Reshape(a, {3, 2});
+            LIQUID_EXPECTS(GetConstantValue(transposed).IsView());
+            LIQUID_EXPECTS(GetConstantValue(transposed).GetStorageAs<Real>().data() ==
+                GetConstantValue(a).GetStorageAs<Real>().data());
+            LIQUID_EXPECTS(!GetConstantValue(reshaped).IsView());
+            LIQUID_EXPECTS(GetConstantValue(reshaped).GetStorageAs<Real>().data() ==
+                GetConstantValue(a).GetStorageAs<Real>().data());
+
+            // constants are identical regardless of their layout
+            LIQUID_EXPECTS(AreIdentical(Transpose(Tensor({{1, 2}, {3, 4}})), Tensor({{1, 3}, {2, 4}})));
+
+            // views are hashed walking the strides, as their dense copy would be
+            auto const hash_of = [](const Tensor & i_tensor) { return Hash(GetConstantValue(i_tensor)); };
+            LIQUID_EXPECTS(hash_of(transposed) == hash_of(Tensor({{1., 4.}, {2., 5.}, {3., 6.}})));
+            LIQUID_EXPECTS(hash_of(Transpose(cube, {0, 2, 1})) == hash_of(Tensor({{{1, 3}, {2, 4}}, {{5, 7}, {6, 8}}})));
+            LIQUID_EXPECTS(hash_of(BroadcastTo(Tensor({{1}, {2}}), {2, 3})) == hash_of(Tensor({{1, 1, 1}, {2, 2, 2}})));
+            LIQUID_EXPECTS(hash_of(BroadcastTo(Tensor({1, 2}), {3, 2})) == hash_of(Tensor({{1, 2}, {1, 2}, {1, 2}})));
+
+            LIQUID_EXPECTS_PANIC(Reshape(a, {4}), "reshape: can't reshape [2, 3] to [4]");
+            LIQUID_EXPECTS_PANIC(Transpose(a, {0, 0}), "transpose: the axes [0, 0] are not a permutation");
+            LIQUID_EXPECTS_PANIC(BroadcastTo(a, {3, 3}), "broadcast_to: can't broadcast [2, 3] to [3, 3]");
+        }
+
+        {
+            // kernels read views with their strides
+            Tensor const t = Transpose(a);
+            LIQUID_EXPECTS(( t + 1 == Tensor({{2, 5}, {3, 6}, {4, 7}}) ));
+            LIQUID_EXPECTS(( MatMul(t, Tensor({1., 1.})) == Tensor({5, 7, 9}) ));
+            LIQUID_EXPECTS(( MatMul(Tensor({1., 1., 1.}), t) == Tensor({6, 15}) ));
+            LIQUID_EXPECTS(( Sum(t, {0}) == Tensor({6, 15}) ));
+            LIQUID_EXPECTS(( Sum(Transpose(cube), {0, 1}) == Tensor({10, 26}) ));
+            LIQUID_EXPECTS(( Einsum("ij->i", {t}) == Tensor({5, 7, 9}) ));
+            LIQUID_EXPECTS(( Stack({t, t}) == Stack({Tensor({{1, 4}, {2, 5}, {3, 6}}), Tensor({{1, 4}, {2, 5}, {3, 6}})}) ));
+            LIQUID_EXPECTS(( Sum(BroadcastTo(Tensor({1, 2}), {1000, 2}), {0}) == Tensor({1000, 2000}) ));
+        }
+
+        {
+            // canonicalizations
+            Tensor const x("real[2, 3] x");
+            LIQUID_EXPECTS(AreIdentical(Transpose(Transpose(x)), x));
+            LIQUID_EXPECTS(AreIdentical(Transpose(x, {1, 0}), Transpose(x)));
+            LIQUID_EXPECTS(AreIdentical(Reshape(Reshape(x, {6}), {2, 3}), x));
+            LIQUID_EXPECTS(AreIdentical(Reshape(Reshape(x, {6}), {3, 2}), Reshape(x, {3, 2})));
+            LIQUID_EXPECTS(AreIdentical(BroadcastTo(x, {2, 3}), x));
+            LIQUID_EXPECTS(GetGraphStatistics({ Transpose(x) }).m_flops == 0);
+        }
+
+        {
+            Tensor const x("real[2, 3] x"), u("real[3] u");
+            Tensor const gradient({{1., 2., 3.}, {4., 5., 6.}});
+
+            LIQUID_EXPECTS(( Book::Get().GetOperator("reshape").GetGradientOfOperand(Reshape(x, {3, 2}),
+                Tensor({{1., 2.}, {3., 4.}, {5., 6.}}), 0) == gradient ));
+            LIQUID_EXPECTS(( Book::Get().GetOperator("transpose").GetGradientOfOperand(Transpose(x),
+                Transpose(gradient), 0) == gradient ));
+            LIQUID_EXPECTS(( Book::Get().GetOperator("broadcast_to").GetGradientOfOperand(BroadcastTo(u, {2, 3}),
+                gradient, 0) == Tensor({5, 7, 9}) ));
+        }
+
+        std::cout << "done" << std::endl;
+    }
+}
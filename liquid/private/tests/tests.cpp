@@ -16,10 +16,23 @@ namespace liquid
     void TestAdd();
     void TestMul();
     void TestPow();
+    void TestMatMul();
+    void TestEinsum();
+    void TestReduce();
+    void TestViews();
+    void TestIndexing();
+    void TestSoftmax();
+    void TestPrecision();
     void TestIf();
     void TestIs();
     void TestSubstutute();
     void TestMiu6();
+    void TestSerialize();
+    void TestThreadSafety();
+    void TestInstrumentation();
+    void TestGraphStatistics();
+    void TestIncrementalEvaluator();
+    void TestSymbolicShapes();
 
     void TestLiquid()
     {
@@ -31,9 +44,22 @@ namespace liquid
         TestAdd();
         TestMul();
         TestPow();
+        TestMatMul();
+        TestEinsum();
+        TestReduce();
+        TestViews();
+        TestIndexing();
+        TestSoftmax();
+        TestPrecision();
         TestIf();
         TestIs();
         TestSubstutute();
         TestMiu6();
+        TestSerialize();
+        TestThreadSafety();
+        TestInstrumentation();
+        TestGraphStatistics();
+        TestIncrementalEvaluator();
+        TestSymbolicShapes();
     }
 }
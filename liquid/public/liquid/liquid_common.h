@@ -9,6 +9,7 @@
 #include <string>
 #include <sstream>
 #include <exception>
+#include <optional>
 
 namespace liquid
 {
@@ -16,7 +17,13 @@ namespace liquid
     using Integer = int64_t;
     using Bool = bool;
 
-    enum class ScalarType { Any, Real, Integer, Bool };
+    // narrower scalar types, that halve or more the memory and double or more the SIMD width
+    using Real32 = float;
+    using Integer32 = int32_t;
+    using Integer8 = int8_t;
+
+    // new types are added at the end, so that serialized values remain readable
+    enum class ScalarType { Any, Real, Integer, Bool, Real32, Integer32, Integer8 };
 
     template <typename TYPE>
         constexpr ScalarType GetScalarType()
@@ -27,6 +34,12 @@ namespace liquid
             return ScalarType::Integer;
         else if constexpr (std::is_same_v<TYPE, Bool>)
             return ScalarType::Bool;
+        else if constexpr (std::is_same_v<TYPE, Real32>)
+            return ScalarType::Real32;
+        else if constexpr (std::is_same_v<TYPE, Integer32>)
+            return ScalarType::Integer32;
+        else if constexpr (std::is_same_v<TYPE, Integer8>)
+            return ScalarType::Integer8;
     }
 
     namespace detail
@@ -35,6 +48,9 @@ namespace liquid
         template <> struct FromScalarTypeImpl<ScalarType::Real> { using type = Real; };
         template <> struct FromScalarTypeImpl<ScalarType::Integer> { using type = Integer; };
         template <> struct FromScalarTypeImpl<ScalarType::Bool> { using type = Bool; }; 
+        template <> struct FromScalarTypeImpl<ScalarType::Real32> { using type = Real32; };
+        template <> struct FromScalarTypeImpl<ScalarType::Integer32> { using type = Integer32; };
+        template <> struct FromScalarTypeImpl<ScalarType::Integer8> { using type = Integer8; };
     }
     template <ScalarType SCALAR_TYPE>
         using FromScalarType = typename detail::FromScalarTypeImpl<SCALAR_TYPE>::type;
@@ -89,4 +105,31 @@ namespace liquid
 
     template <typename FIRST, typename...>
         using FirstOf = FIRST;
+
+    /* Precision of exp, log, sin, cos and pow. Fast uses polynomial approximations with an
+        error of a few units in the last place, see fast_math.h, and exponentiation by squaring
+        for small integer exponents. Constants are folded with the precision of the thread that
+        builds the expression. */
+    enum class Precision { Exact, Fast };
+
+    // sets the precision of the threads that have no PrecisionContext, initially Exact
+    void SetDefaultPrecision(Precision i_precision);
+
+    // precision of the calling thread
+    Precision GetPrecision();
+
+    // overrides the precision of the calling thread until it is destroyed
+    class PrecisionContext
+    {
+    public:
+
+        PrecisionContext(Precision i_precision);
+        ~PrecisionContext();
+
+        PrecisionContext(const PrecisionContext &) = delete;
+        PrecisionContext & operator = (const PrecisionContext &) = delete;
+
+    private:
+        std::optional<Precision> m_previous;
+    };
 }
@@ -155,7 +155,10 @@ namespace liquid
         {
             if(i != 0)
                 i_ostream << ", ";
-            i_ostream << i_span[i];
+            if constexpr(std::is_same_v<std::remove_const_t<TYPE>, int8_t>)
+                i_ostream << static_cast<int>(i_span[i]); // not as a character
+            else
+                i_ostream << i_span[i];
         }
         return i_ostream;
     }
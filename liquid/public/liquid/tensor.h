@@ -153,8 +153,14 @@ namespace liquid
             return Cast(ScalarType::Real, i_source);
         else if constexpr (std::is_same_v<DEST_SCALAR_TYPE, Integer>)
             return Cast(ScalarType::Integer, i_source);
+        else if constexpr (std::is_same_v<DEST_SCALAR_TYPE, Real32>)
+            return Cast(ScalarType::Real32, i_source);
+        else if constexpr (std::is_same_v<DEST_SCALAR_TYPE, Integer32>)
+            return Cast(ScalarType::Integer32, i_source);
+        else if constexpr (std::is_same_v<DEST_SCALAR_TYPE, Integer8>)
+            return Cast(ScalarType::Integer8, i_source);
         else
-            static_assert("DEST_SCALAR_TYPE must be Real or Integer");
+            static_assert("DEST_SCALAR_TYPE must be a numeric scalar type");
     }
 
     Tensor operator + (const Tensor & i_operand);
@@ -188,9 +194,69 @@ namespace liquid
     Tensor Sin(const Tensor & i_operand);
     Tensor Cos(const Tensor & i_operand);
 
+    /* Matrix product of matrices or vectors: a vector is a row if it's the first operand,
+        and a column if it's the second operand. */
+    Tensor MatMul(const Tensor & i_first, const Tensor & i_second);
+
+    /* General contraction described by an index specification, like "ij,jk->ik" for the
+        matrix product, "ii->" for the trace, or "ij->ji" for the transposition. Without
+        '->' the result has the labels used once, in alphabetical order. */
+    Tensor Einsum(std::string_view i_spec, Span<Tensor const> i_operands);
+
+    /* Reductions of the elements along the given axes, that are removed from the shape.
+        Without axes all the elements are reduced to a scalar. */
+    Tensor Sum(const Tensor & i_source);
+    Tensor Sum(const Tensor & i_source, Span<const Integer> i_axes);
+    Tensor Product(const Tensor & i_source);
+    Tensor Product(const Tensor & i_source, Span<const Integer> i_axes);
+    Tensor Min(const Tensor & i_source);
+    Tensor Min(const Tensor & i_source, Span<const Integer> i_axes);
+    Tensor Max(const Tensor & i_source);
+    Tensor Max(const Tensor & i_source, Span<const Integer> i_axes);
+    Tensor All(const Tensor & i_source);
+    Tensor All(const Tensor & i_source, Span<const Integer> i_axes);
+    Tensor Any(const Tensor & i_source);
+    Tensor Any(const Tensor & i_source, Span<const Integer> i_axes);
+
+    /* Softmax and logarithm of the sum of the exponentials along an axis, the last one by
+        default. They are evaluated in one pass keeping a running maximum, so large elements
+        don't overflow. */
+    Tensor Softmax(const Tensor & i_source);
+    Tensor Softmax(const Tensor & i_source, Integer i_axis);
+    Tensor LogSumExp(const Tensor & i_source);
+    Tensor LogSumExp(const Tensor & i_source, Integer i_axis);
+
+    /* Views: the results share the elements of the source, so evaluating them
+        copies nothing. */
+
+    // the elements of the source in the same order, with a shape with the same element count
+    Tensor Reshape(const Tensor & i_source, Span<const Integer> i_shape);
+
+    // the axis i of the result is the axis i_axes[i] of the source, the default reverses the axes
+    Tensor Transpose(const Tensor & i_source);
+    Tensor Transpose(const Tensor & i_source, Span<const Integer> i_axes);
+
+    Tensor BroadcastTo(const Tensor & i_source, Span<const Integer> i_shape);
+
+    /* Elements from i_start to i_stop, excluded, with the given step along an axis. Negative
+        start and stop count from the end of the axis. The result is a view. */
+    Tensor Slice(const Tensor & i_source, Integer i_axis, Integer i_start, Integer i_stop, Integer i_step = 1);
+
+    /* Elements of the source at the integer indices along an axis: the axis is replaced
+        by the shape of the indices. */
+    Tensor Gather(const Tensor & i_source, const Tensor & i_indices, Integer i_axis = 0);
+
+    /* Adds the updates to the target at the integer indices along an axis. The updates have
+        the shape that Gather(i_target, i_indices, i_axis) would have. */
+    Tensor ScatterAdd(const Tensor & i_target, const Tensor & i_indices, const Tensor & i_updates, Integer i_axis = 0);
+
     Tensor Stack(Span<Tensor const> i_tensors);
 
-    // to implement
+    // stacks the tensors along a new dimension inserted before the dimension i_axis
+    Tensor Stack(Span<Tensor const> i_tensors, Integer i_axis);
+
+    /* Replaces every occurrence of i_what in i_where with i_with, where the bool
+        expression i_when is true. Replacements are not substituted again. */
     Tensor Substitute(const Tensor & i_where, const Tensor & i_what,
         const Tensor & i_with, const Tensor & i_when = true);
 
@@ -199,7 +265,30 @@ namespace liquid
         Tensor const m_what, m_with, m_when = true;
     };
 
+    // applies many rules in a single visit of the graph, if many rules match the first is applied
     Tensor Substitute(const Tensor & i_where, Span<const Rule> i_rules);
 
     std::ostream & operator << (std::ostream & i_dest, const Tensor & i_tensor);
+
+    /* Writes the graph of the tensors in a compact binary format. Every unique
+        expression is written once, so sharing is preserved by ReadBinary. */
+    void WriteBinary(std::ostream & i_dest, Span<const Tensor> i_tensors);
+
+    // Reads tensors written by WriteBinary
+    std::vector<Tensor> ReadBinary(std::istream & i_source);
+
+    /* Statistics of the graph of some tensors. Every unique expression is counted
+        once. Costs are estimated from the fixed shapes: tensors with a variable or
+        undefined shape are estimated as scalars. */
+    struct GraphStatistics
+    {
+        size_t m_unique_nodes = 0;
+        size_t m_depth = 0; // number of nodes in the longest path from a root to a leaf
+        int64_t m_flops = 0;
+        /* maximum size of the intermediate results alive at the same time, evaluating
+            the graph in post-order and releasing every result after its last use */
+        int64_t m_peak_intermediate_bytes = 0;
+    };
+
+    GraphStatistics GetGraphStatistics(Span<const Tensor> i_roots);
 }